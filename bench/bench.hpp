@@ -0,0 +1,98 @@
+// A small microbenchmark harness. Each benchmark is timed over a fixed number of samples after a
+// warmup, and reported as the median, fastest and slowest time per operation
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace bench {
+
+/// Heap allocations so far, counted by a replacement operator new when the binary defines one
+inline std::atomic<size_t> allocations{0};
+
+struct Result {
+    std::string name;
+    /// Operations per sample
+    size_t ops;
+    /// Nanoseconds per operation
+    double median;
+    double min;
+    double max;
+    /// Heap allocations per operation, over every sample
+    double allocs;
+};
+
+class Runner {
+    std::vector<Result> results_;
+    const char *filter_ = nullptr;
+    int samples_ = 15;
+
+  public:
+    /// Takes an optional substring of the benchmarks to run, and --samples N
+    Runner(int argc, char **argv) {
+        for (int i = 1; i < argc; i++) {
+            if (!strcmp(argv[i], "--samples") && i + 1 < argc)
+                samples_ = std::max(1, atoi(argv[++i]));
+            else
+                filter_ = argv[i];
+        }
+    }
+
+    /// Times f, which performs ops operations. reset runs after each sample, untimed
+    void run(const char *name, size_t ops, const std::function<void()> &f,
+             const std::function<void()> &reset = nullptr) {
+        if (filter_ && !strstr(name, filter_))
+            return;
+        f();
+        if (reset)
+            reset();
+        std::vector<double> times;
+        times.reserve(samples_);
+        size_t allocs = 0;
+        for (int i = 0; i < samples_; i++) {
+            auto before = allocations.load(std::memory_order_relaxed);
+            auto start = std::chrono::steady_clock::now();
+            f();
+            auto ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() -
+                                                               start)
+                          .count();
+            allocs += allocations.load(std::memory_order_relaxed) - before;
+            times.push_back(ns / ops);
+            if (reset)
+                reset();
+        }
+        std::sort(times.begin(), times.end());
+        results_.push_back(Result{name, ops, times[times.size() / 2], times.front(), times.back(),
+                                  (double)allocs / ((double)ops * samples_)});
+    }
+
+    /// Prints the median time, rate and allocations of every benchmark
+    void summary(FILE *f = stderr) const {
+        for (auto &r : results_)
+            fprintf(f, "%-32s %12.1f ns %14.0f /s %10.2f allocs\n", r.name.c_str(), r.median,
+                    1e9 / r.median, r.allocs);
+    }
+
+    void json(FILE *f = stdout) const {
+        fprintf(f, "{\n  \"samples\": %d,\n  \"benchmarks\": [\n", samples_);
+        for (size_t i = 0; i < results_.size(); i++) {
+            auto &r = results_[i];
+            fprintf(f,
+                    "    {\"name\": \"%s\", \"ops\": %zu, \"ns_per_op\": %.2f, \"min_ns\": %.2f, "
+                    "\"max_ns\": %.2f, \"ops_per_sec\": %.0f, \"allocs_per_op\": %.2f}%s\n",
+                    r.name.c_str(), r.ops, r.median, r.min, r.max, 1e9 / r.median, r.allocs,
+                    i + 1 < results_.size() ? "," : "");
+        }
+        fprintf(f, "  ]\n}\n");
+    }
+};
+
+} // namespace bench
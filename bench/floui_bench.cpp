@@ -0,0 +1,344 @@
+// Benchmarks floui's own overhead against the headless backend, so results don't depend on a
+// windowing system. Prints JSON on stdout and a summary on stderr:
+// g++ -std=c++17 -O2 bench/floui_bench.cpp -o floui_bench && ./floui_bench > bench.json
+
+#define FLOUI_HEADLESS
+#define FLOUI_IMPL
+#include "../floui.hpp"
+
+#include "bench.hpp"
+
+#include <cstdlib>
+#include <new>
+#include <thread>
+#include <unistd.h>
+
+using namespace floui;
+
+// GCC pairs the malloc below with the free in operator delete once both are inlined
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+
+void *operator new(size_t n) {
+    bench::allocations.fetch_add(1, std::memory_order_relaxed);
+    if (auto p = std::malloc(n))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+
+void operator delete(void *p, size_t) noexcept { std::free(p); }
+
+/// Keeps the optimizer from discarding a result
+static void *volatile sink = nullptr;
+
+template <typename F>
+static void widget(bench::Runner &runner, const char *name, F make) {
+    constexpr size_t n = 10000;
+    runner.run(
+        name, n,
+        [&] {
+            for (size_t i = 0; i < n; i++)
+                sink = make().inner();
+        },
+        [] { headless::reset(); });
+}
+
+/// A MainView of rows of a Text, a Toggle and a Button in an HStack, nodes in total
+static MainView tree(const FlouiViewController &controller, size_t nodes) {
+    auto main_view = MainView(controller, {});
+    for (size_t i = 1; i + 4 <= nodes; i += 4)
+        main_view.add(HStack({Text(std::to_string(i)), Toggle("On").value(i % 2),
+                              Button("Open").action([](Widget &) {})}));
+    return main_view;
+}
+
+int main(int argc, char **argv) {
+    bench::Runner runner(argc, argv);
+    FlouiViewController controller(nullptr);
+
+    widget(runner, "build/Button", [] { return Button("Increment").action([](Widget &) {}); });
+    widget(runner, "build/Text",
+           [] { return Text("0").center().bold().fontsize(20).foreground(Color::Black); });
+    widget(runner, "build/Toggle", [] { return Toggle("Toggle").value(true); });
+    widget(runner, "build/Check", [] { return Check("Check").value(true); });
+    widget(runner, "build/Slider", [] { return Slider().value(0.5); });
+    widget(runner, "build/TextField", [] { return TextField().text("Text").fontsize(14); });
+    widget(runner, "build/Spacer", [] { return Spacer().size(10, 10); });
+    widget(runner, "build/ImageView", [] { return ImageView("image.png"); });
+    widget(runner, "build/WebView", [] { return WebView().load_url("https://example.com"); });
+    widget(runner, "build/VStack", [] { return VStack({Text("1"), Text("2")}); });
+    widget(runner, "build/HStack", [] { return HStack({Text("1"), Text("2")}); });
+    widget(runner, "build/ScrollView", [] { return ScrollView(Spacer()); });
+    widget(runner, "build/ListView", [] {
+        return ListView(
+            1000000, [](int) { return Text(""); }, [](Widget &, int) {});
+    });
+    widget(runner, "build/LazyVStack", [] {
+        return ScrollView(LazyVStack(2000, [](int i) { return Text(std::to_string(i)); }));
+    });
+
+    for (size_t nodes : {10, 1000, 100000}) {
+        auto name = "mainview/" + std::to_string(nodes) + " nodes";
+        runner.run(
+            name.c_str(), 1, [&] { sink = tree(controller, nodes).inner(); },
+            [] { headless::reset(); });
+    }
+
+    {
+        constexpr size_t n = 1000;
+        std::vector<std::string> names;
+        std::vector<Id> ids;
+        for (size_t i = 0; i < n; i++)
+            names.push_back("widget" + std::to_string(i));
+        for (auto &name : names) {
+            Text("").id(name.c_str());
+            ids.push_back(Id(name.c_str()));
+        }
+        runner.run("from_id/hashed", n, [&] {
+            for (auto id : ids)
+                sink = Widget::from_id<Text>(id).inner();
+        });
+        runner.run("from_id/string", n, [&] {
+            for (auto &name : names)
+                sink = Widget::from_id<Text>(name.c_str()).inner();
+        });
+        headless::reset();
+    }
+
+    {
+        constexpr size_t n = 100000;
+        int hits = 0;
+        auto button = Button("Tap").action([&](Widget &) { hits++; });
+        auto slot = FlouiViewController::add_callback([&](Widget &) { hits++; });
+        runner.run("dispatch/handle_events", n, [&] {
+            for (size_t i = 0; i < n; i++)
+                FlouiViewController::handle_events(button.inner());
+        });
+        runner.run("dispatch/handle_event", n, [&] {
+            for (size_t i = 0; i < n; i++)
+                FlouiViewController::handle_event(slot, button.inner());
+        });
+        runner.run("dispatch/click", n, [&] {
+            for (size_t i = 0; i < n; i++)
+                headless::click(button);
+        });
+        Trace::start();
+        runner.run(
+            "dispatch/click traced", n,
+            [&] {
+                for (size_t i = 0; i < n; i++)
+                    headless::click(button);
+            },
+            [] { Trace::clear(); });
+        Trace::stop();
+        Trace::clear();
+        auto text = Text("0");
+        auto update = Button("Update").action([&](Widget &) { text.text(std::to_string(hits++)); });
+        runner.run("dispatch/click and update", n, [&] {
+            for (size_t i = 0; i < n; i++)
+                headless::click(update);
+        });
+        headless::reset();
+    }
+
+    {
+        // Laying out a scrolling list of rows of a Text, a Toggle and a Button, 10k nodes in all,
+        // after one text changes its width, then after the window is resized
+        constexpr size_t rows = 2500;
+        std::vector<Text> texts;
+        auto stack = VStack({});
+        for (size_t i = 0; i < rows; i++) {
+            texts.push_back(Text(std::to_string(i)));
+            stack.add(HStack({texts.back(), Toggle("On"), Button("Open")}).spacing(8));
+        }
+        auto main_view = MainView(controller, {ScrollView(stack)}).size(400, 800);
+        Layout::update();
+        size_t i = 0;
+        runner.run("layout/10k nodes, one text", 1, [&] {
+            texts[rows / 2].text(i++ % 2 ? "short" : "a longer text");
+            Layout::update();
+        });
+        runner.run("layout/10k nodes, resized", 1, [&] {
+            main_view.size(400 + i++ % 2, 800);
+            Layout::update();
+        });
+        headless::reset();
+    }
+
+    {
+        // Measuring labels through the cache, against shaping them every time
+        constexpr size_t n = 1000;
+        std::vector<std::string> labels;
+        for (size_t i = 0; i < n; i++)
+            labels.push_back("Label number " + std::to_string(i) + " of the list");
+        Font font{0, 14};
+        runner.run("text/measure, cached", n, [&] {
+            for (auto &label : labels)
+                sink = (void *)&TextCache::measure(label, font, 120);
+        });
+        runner.run("text/shape", n, [&] {
+            for (auto &label : labels)
+                sink = (void *)(intptr_t)TextCache::shape(label, font, 120).height;
+        });
+        TextCache::clear();
+    }
+
+    {
+        // Restyling 5k rows, alternating between two looks, with chained setters and with shared
+        // styles
+        constexpr size_t n = 5000;
+        std::vector<Text> rows;
+        for (size_t i = 0; i < n; i++)
+            rows.push_back(Text(std::to_string(i)));
+        uint32_t colors[] = {Color::Black, Color::Blue};
+        auto look = [](uint32_t c) {
+            return Style().foreground(c).background(Color::White).fontsize(14).bold().center();
+        };
+        Style styles[] = {look(colors[0]), look(colors[1])};
+        size_t pass = 0;
+        runner.run("style/5k rows, chained", n, [&] {
+            auto c = colors[pass++ % 2];
+            for (auto &row : rows)
+                row.foreground(c).background(Color::White).fontsize(14).bold().center();
+        });
+        runner.run("style/5k rows, shared", n, [&] {
+            auto &s = styles[pass++ % 2];
+            for (auto &row : rows)
+                row.style(s);
+        });
+        headless::reset();
+    }
+
+    for (size_t n : {1000, 10000}) {
+        // Inserting the children of a laid out stack an add at a time, then all at once, each
+        // followed by the relayout
+        std::vector<Text> children;
+        for (size_t i = 0; i < n; i++)
+            children.push_back(Text(std::to_string(i)));
+        auto stack = VStack();
+        MainView(controller, {ScrollView(stack)}).size(400, 800);
+        Layout::update();
+        auto clear = [&] {
+            stack.clear();
+            Layout::update();
+        };
+        auto label = std::to_string(n / 1000) + "k";
+        runner.run(("children/" + label + ", one by one").c_str(), n,
+                   [&] {
+                       for (auto &child : children)
+                           stack.add(child);
+                       Layout::update();
+                   },
+                   clear);
+        runner.run(("children/" + label + ", add_all").c_str(), n,
+                   [&] {
+                       stack.add_all(children);
+                       Layout::update();
+                   },
+                   clear);
+        headless::reset();
+    }
+
+    {
+        // Loading the images of distinct paths, decoded on the worker pool, then loading them
+        // again from the cache. Both wait for every view to show its image
+        constexpr size_t n = 100;
+        std::vector<std::string> paths;
+        for (size_t i = 0; i < n; i++)
+            paths.push_back("image" + std::to_string(i) + ".png");
+        auto load = [&] {
+            for (auto &path : paths)
+                sink = ImageView(path).size(128, 128).inner();
+            while (Images::pending())
+                FlouiViewController::drain();
+        };
+        runner.run("image/cold", n, load, [] { headless::reset(); });
+        load();
+        runner.run("image/repeated", n, load);
+        headless::reset();
+    }
+
+    {
+        // Posting from other threads to the UI thread, which drains as it goes
+        constexpr size_t threads = 4, per = 50000;
+        auto posts = [&](bool batched) {
+            std::atomic<size_t> done{0};
+            size_t ran = 0;
+            std::vector<std::thread> posters;
+            for (size_t t = 0; t < threads; t++)
+                posters.emplace_back([&] {
+                    if (batched) {
+                        for (size_t i = 0; i < per; i += 100)
+                            post_batch(std::vector<std::function<void()>>(100, [] {}));
+                    } else {
+                        for (size_t i = 0; i < per; i++)
+                            post([] {});
+                    }
+                    done++;
+                });
+            while (done < threads || ran < threads * per)
+                ran += FlouiViewController::drain();
+            for (auto &t : posters)
+                t.join();
+        };
+        runner.run("post/4 threads", threads * per, [&] { posts(false); });
+        runner.run("post/4 threads, batches of 100", threads * per, [&] { posts(true); });
+    }
+
+    {
+        // The headless log writes to stderr, which is pointed at /dev/null meanwhile
+        constexpr size_t n = 100000;
+        fflush(stderr);
+        auto saved = dup(fileno(stderr));
+        if (freopen("/dev/null", "w", stderr)) {
+            runner.run("log/plain", n, [&] {
+                for (size_t i = 0; i < n; i++)
+                    floui_log("floui: a message");
+            });
+            runner.run("log/formatted", n, [&] {
+                for (size_t i = 0; i < n; i++)
+                    floui_log("floui: %s %d", "a message", (int)i);
+            });
+            runner.run("log/debug, compiled out", n, [&] {
+                for (size_t i = 0; i < n; i++)
+                    log_debug("floui: %s %d", "a message", (int)i);
+            });
+            // Flushing before the ring fills keeps every message, so this is the rate at which
+            // the background thread writes them out
+            Log::async(true);
+            runner.run("log/async plain", n, [&] {
+                for (size_t i = 0; i < n; i++) {
+                    floui_log("floui: a message");
+                    if (i % (Log::capacity / 2) == 0)
+                        Log::flush();
+                }
+                Log::flush();
+            });
+            runner.run("log/async formatted", n, [&] {
+                for (size_t i = 0; i < n; i++) {
+                    floui_log("floui: %s %d", "a message", (int)i);
+                    if (i % (Log::capacity / 2) == 0)
+                        Log::flush();
+                }
+                Log::flush();
+            });
+            // What the caller pays, the ring being flushed between samples
+            runner.run(
+                "log/async, caller side", Log::capacity / 2,
+                [&] {
+                    for (size_t i = 0; i < Log::capacity / 2; i++)
+                        floui_log("floui: %s %d", "a message", (int)i);
+                },
+                [] { Log::flush(); });
+            Log::async(false);
+            fflush(stderr);
+        }
+        dup2(saved, fileno(stderr));
+        close(saved);
+    }
+
+    runner.summary();
+    runner.json();
+    return 0;
+}
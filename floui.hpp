@@ -25,13 +25,35 @@
 #ifndef __FLOUI_HPP__
 #define __FLOUI_HPP__
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
 #include <functional>
 #include <initializer_list>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <optional>
 #include <string>
+#include <thread>
+#include <type_traits>
 #include <unordered_map>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#include <coroutine>
+/// Defined when coroutine actions are available, which needs C++20
+#define FLOUI_COROUTINES
+#endif
+
 struct FlouiViewControllerImpl;
 
 /// Log to console, this is platform specific and needs to be implemented for each platform
@@ -40,36 +62,972 @@ void floui_log0(const char *s);
 /// log to console, mainly to avoid triggering -Wformat-nonliteral
 int floui_log(const char *s);
 
+/// Log levels, the FLOUI_LOG_LEVEL macro sets the lowest one compiled in
+#define FLOUI_LOG_DEBUG 0
+#define FLOUI_LOG_INFO 1
+#define FLOUI_LOG_WARN 2
+#define FLOUI_LOG_ERROR 3
+#define FLOUI_LOG_OFF 4
+
+#ifndef FLOUI_LOG_LEVEL
+#define FLOUI_LOG_LEVEL FLOUI_LOG_INFO
+#endif
+
+namespace floui {
+
+enum class LogLevel {
+    Debug = FLOUI_LOG_DEBUG,
+    Info = FLOUI_LOG_INFO,
+    Warn = FLOUI_LOG_WARN,
+    Error = FLOUI_LOG_ERROR,
+};
+
+/// Formats messages into a stack buffer, and either writes them to floui_log0 right away or, once
+/// async(true) is set, copies them into a lock-free ring which a background thread drains into
+/// floui_log0. Neither path allocates. Messages longer than message_size are truncated, and
+/// messages which find the ring full are dropped and counted
+class Log {
+  public:
+    static constexpr size_t message_size = 256;
+    static constexpr size_t capacity = 1024;
+
+  private:
+    struct alignas(64) Slot {
+        std::atomic<size_t> seq{0};
+        char text[message_size];
+    };
+
+    static inline std::unique_ptr<Slot[]> slots_;
+    static inline std::atomic<size_t> head_{0};
+    static inline std::atomic<size_t> tail_{0};
+    static inline std::atomic<size_t> dropped_{0};
+    static inline std::atomic<bool> running_{false};
+    static inline std::atomic<bool> sleeping_{false};
+    static inline std::mutex mutex_;
+    static inline std::condition_variable wake_;
+    static inline std::thread thread_;
+    static inline std::mutex toggle_;
+
+    /// Stops the drain thread before thread_ is destroyed, since a joinable thread terminates
+    static inline struct Stopper {
+        ~Stopper() { Log::async(false); }
+    } stopper_{};
+
+    /// Claims a slot, or returns nullptr when the ring is full
+    static Slot *claim(size_t &pos) {
+        pos = head_.load(std::memory_order_relaxed);
+        for (;;) {
+            auto slot = &slots_[pos % capacity];
+            auto seq = slot->seq.load(std::memory_order_acquire);
+            auto diff = (intptr_t)seq - (intptr_t)pos;
+            if (diff == 0) {
+                if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    return slot;
+            } else if (diff < 0) {
+                return nullptr;
+            } else {
+                pos = head_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    static void publish(Slot *slot, size_t pos) {
+        slot->seq.store(pos + 1, std::memory_order_seq_cst);
+        // Only the first message after the drain thread went to sleep wakes it
+        if (sleeping_.load(std::memory_order_seq_cst) && sleeping_.exchange(false))
+            wake_.notify_one();
+    }
+
+    static bool pending() {
+        auto pos = tail_.load(std::memory_order_relaxed);
+        return slots_[pos % capacity].seq.load(std::memory_order_seq_cst) == pos + 1;
+    }
+
+    /// Writes every published message to floui_log0, only ever called by one thread at a time
+    static size_t drain() {
+        size_t n = 0;
+        auto pos = tail_.load(std::memory_order_relaxed);
+        for (;;) {
+            auto slot = &slots_[pos % capacity];
+            if (slot->seq.load(std::memory_order_acquire) != pos + 1)
+                break;
+            floui_log0(slot->text);
+            slot->seq.store(pos + capacity, std::memory_order_release);
+            tail_.store(++pos, std::memory_order_release);
+            n++;
+        }
+        if (auto lost = dropped_.exchange(0, std::memory_order_relaxed)) {
+            char buf[64];
+            snprintf(buf, sizeof(buf), "floui: %zu log messages dropped", lost);
+            floui_log0(buf);
+        }
+        return n;
+    }
+
+    static void run() {
+        while (running_.load(std::memory_order_acquire)) {
+            if (drain())
+                continue;
+            std::unique_lock<std::mutex> lock(mutex_);
+            sleeping_.store(true, std::memory_order_seq_cst);
+            // The timeout covers a notify sent between pending() and the wait
+            if (!pending())
+                wake_.wait_for(lock, std::chrono::milliseconds(10));
+            sleeping_.store(false, std::memory_order_relaxed);
+        }
+        drain();
+    }
+
+    /// Formats into a ring slot, or into a stack buffer written right away
+    template <typename F>
+    static void emit(F &&fill) {
+        if (running_.load(std::memory_order_acquire)) {
+            size_t pos;
+            if (auto slot = claim(pos)) {
+                fill(slot->text);
+                publish(slot, pos);
+            } else {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+            }
+            return;
+        }
+        char buf[message_size];
+        fill(buf);
+        floui_log0(buf);
+    }
+
+  public:
+    /// Starts or stops the background thread, stopping writes out what remains in the ring
+    static void async(bool on) {
+        std::lock_guard<std::mutex> guard(toggle_);
+        if (on == running_.load())
+            return;
+        if (on) {
+            if (!slots_) {
+                slots_.reset(new Slot[capacity]);
+                for (size_t i = 0; i < capacity; i++)
+                    slots_[i].seq.store(i, std::memory_order_relaxed);
+            }
+            running_.store(true, std::memory_order_release);
+            thread_ = std::thread(run);
+        } else {
+            running_.store(false, std::memory_order_release);
+            wake_.notify_one();
+            thread_.join();
+            // Picks up messages from threads which saw the ring running as it stopped
+            drain();
+        }
+    }
+
+    static bool async() { return running_.load(std::memory_order_acquire); }
+
+    /// Waits until the messages logged so far are written
+    static void flush() {
+        if (!async())
+            return;
+        auto head = head_.load(std::memory_order_acquire);
+        while (tail_.load(std::memory_order_acquire) < head && async()) {
+            wake_.notify_one();
+            std::this_thread::yield();
+        }
+    }
+
+    /// Messages dropped since the last drain because the ring was full
+    static size_t dropped() { return dropped_.load(std::memory_order_relaxed); }
+
+    template <LogLevel L>
+    static void write(const char *s) {
+        if constexpr ((int)L >= FLOUI_LOG_LEVEL) {
+            emit([s](char *buf) {
+                auto len = std::min(strlen(s), message_size - 1);
+                memcpy(buf, s, len);
+                buf[len] = 0;
+            });
+        }
+    }
+
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wformat-nonliteral"
-/// log to console
+    /// Returns the length of the formatted message before truncation
+    template <LogLevel L, typename... Args>
+    static int format(const char *fmt, Args... args) {
+        int ret = 0;
+        if constexpr ((int)L >= FLOUI_LOG_LEVEL) {
+            emit([&](char *buf) { ret = snprintf(buf, message_size, fmt, args...); });
+        }
+        return ret;
+    }
+#pragma clang diagnostic pop
+};
+
+template <typename... Args>
+int log_debug(const char *fmt, Args... args) {
+    return Log::format<LogLevel::Debug>(fmt, args...);
+}
+
+template <typename... Args>
+int log_info(const char *fmt, Args... args) {
+    return Log::format<LogLevel::Info>(fmt, args...);
+}
+
+template <typename... Args>
+int log_warn(const char *fmt, Args... args) {
+    return Log::format<LogLevel::Warn>(fmt, args...);
+}
+
+template <typename... Args>
+int log_error(const char *fmt, Args... args) {
+    return Log::format<LogLevel::Error>(fmt, args...);
+}
+
+} // namespace floui
+
+/// log to console at the info level
 template <typename... Args>
 int floui_log(const char *fmt, Args... args) {
-    auto sz = snprintf(0, 0, fmt, args...);
-    auto buf = new char[sz + 1];
-    auto ret = snprintf(buf, sz + 1, fmt, args...);
-    floui_log0(buf);
-    delete[] buf;
-    return ret;
+    return floui::Log::format<floui::LogLevel::Info>(fmt, args...);
 }
-#pragma clang diagnostic pop
 
 namespace floui {
+class Widget;
+
+/// A widget callback. Callables of up to Action::capacity bytes, like lambdas capturing a few
+/// pointers or ints, are stored inline without allocating, larger ones are boxed on the heap
+class Action {
+    struct Ops {
+        void (*invoke)(void *, Widget &);
+        /// Moves the callable between buffers, nullptr if it's trivially copyable
+        void (*relocate)(void *dst, void *src);
+        /// nullptr if it's trivially destructible
+        void (*destroy)(void *);
+    };
+
+    template <typename F>
+    static constexpr bool fits = sizeof(F) <= sizeof(void *[4]) &&
+                                 alignof(F) <= alignof(void *) &&
+                                 std::is_nothrow_move_constructible_v<F>;
+
+    template <typename F>
+    static inline constexpr Ops inline_ops{
+        [](void *p, Widget &w) { (*static_cast<F *>(p))(w); },
+        std::is_trivially_copyable_v<F> ? nullptr
+                                        : +[](void *dst, void *src) {
+                                              new (dst) F(std::move(*static_cast<F *>(src)));
+                                              static_cast<F *>(src)->~F();
+                                          },
+        std::is_trivially_destructible_v<F> ? nullptr
+                                            : +[](void *p) { static_cast<F *>(p)->~F(); },
+    };
+
+    template <typename F>
+    static inline constexpr Ops boxed_ops{
+        [](void *p, Widget &w) { (**static_cast<F **>(p))(w); },
+        nullptr,
+        [](void *p) { delete *static_cast<F **>(p); },
+    };
+
+    void *buf_[4];
+    const Ops *ops_ = nullptr;
+
+    void take(Action &other) {
+        ops_ = other.ops_;
+        if (ops_ && ops_->relocate)
+            ops_->relocate(buf_, other.buf_);
+        else
+            std::memcpy(buf_, other.buf_, sizeof(buf_));
+        other.ops_ = nullptr;
+    }
+
+  public:
+    static constexpr size_t capacity = sizeof(void *[4]);
+
+    Action() = default;
+    template <typename F, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, Action>>>
+    Action(F &&f) {
+        using T = std::decay_t<F>;
+        if constexpr (fits<T>) {
+            new (buf_) T(std::forward<F>(f));
+            ops_ = &inline_ops<T>;
+        } else {
+            *reinterpret_cast<T **>(buf_) = new T(std::forward<F>(f));
+            ops_ = &boxed_ops<T>;
+        }
+    }
+    Action(Action &&other) noexcept { take(other); }
+    Action &operator=(Action &&other) noexcept {
+        if (this != &other) {
+            reset();
+            take(other);
+        }
+        return *this;
+    }
+    Action(const Action &) = delete;
+    Action &operator=(const Action &) = delete;
+    ~Action() { reset(); }
+    /// Destroys the callable
+    void reset() {
+        if (ops_ && ops_->destroy)
+            ops_->destroy(buf_);
+        ops_ = nullptr;
+    }
+    /// Whether destroying the callable runs no code
+    bool trivial() const { return !ops_ || !ops_->destroy; }
+    explicit operator bool() const { return ops_; }
+    void operator()(Widget &w) { ops_->invoke(buf_, w); }
+};
+
+/// Stores Actions in fixed size chunks, indexed by slot. Chunks are kept when actions are
+/// released, so an app which rebuilds its screens stops allocating after the first build.
+/// Slots freed one at a time, by views discarded on their own, are reused by later actions
+class ActionPool {
+    static constexpr size_t chunk_size = 256;
+    std::vector<std::unique_ptr<Action[]>> chunks_;
+    /// Slots holding an Action whose destruction runs code, in increasing order
+    std::vector<int> owning_;
+    size_t size_ = 0;
+    /// Freed slots, a max-heap so the highest is reused first
+    std::vector<int> free_;
+    /// Whether each slot is in free_, so freeing it again doesn't hand it out twice
+    std::vector<bool> freed_;
+    /// Freed slots below it aren't reused, as a later release from the last mark would miss them
+    size_t floor_ = 0;
+    /// The slots being invoked, innermost last, and whether each was released meanwhile
+    std::vector<std::pair<int, bool>> running_;
+    /// Where the slots of added actions are recorded, if anywhere
+    std::vector<int> *recording_ = nullptr;
+
+    void released(int slot) {
+        for (auto &r : running_)
+            if (r.first == slot)
+                r.second = true;
+    }
+
+  public:
+    ActionPool() = default;
+    ActionPool(const ActionPool &) = delete;
+    ActionPool &operator=(const ActionPool &) = delete;
+    ~ActionPool() { release(0); }
+
+    int add(Action &&a) {
+        int slot;
+        if (!free_.empty() && static_cast<size_t>(free_.front()) >= floor_) {
+            std::pop_heap(free_.begin(), free_.end());
+            slot = free_.back();
+            free_.pop_back();
+        } else {
+            if (size_ == chunks_.size() * chunk_size)
+                chunks_.emplace_back(new Action[chunk_size]);
+            slot = static_cast<int>(size_++);
+            if (freed_.size() < size_)
+                freed_.resize(size_);
+        }
+        freed_[slot] = false;
+        auto &dst = (*this)[slot];
+        dst = std::move(a);
+        if (!dst.trivial())
+            owning_.insert(std::upper_bound(owning_.begin(), owning_.end(), slot), slot);
+        if (recording_)
+            recording_->push_back(slot);
+        return slot;
+    }
+
+    /// The slot the next action added after it is released from, see release
+    size_t mark() {
+        floor_ = size_;
+        return size_;
+    }
+
+    /// Records the slots of the actions added from now on into slots, or stops if nullptr,
+    /// returning where they were recorded before
+    std::vector<int> *record(std::vector<int> *slots) {
+        std::swap(recording_, slots);
+        return slots;
+    }
+
+    /// Frees the action in slot alone, so a later add can reuse the slot. Freeing a free slot
+    /// does nothing
+    void free(int slot) {
+        if (slot < 0 || static_cast<size_t>(slot) >= size_ || freed_[slot])
+            return;
+        freed_[slot] = true;
+        released(slot);
+        auto it = std::lower_bound(owning_.begin(), owning_.end(), slot);
+        if (it != owning_.end() && *it == slot)
+            owning_.erase(it);
+        (*this)[slot].reset();
+        free_.push_back(slot);
+        std::push_heap(free_.begin(), free_.end());
+    }
+
+    Action &operator[](int slot) { return chunks_[slot / chunk_size][slot % chunk_size]; }
+
+    size_t size() const { return size_; }
+
+    /// Invokes the action in slot. It's moved out of the pool for the call, so it can release its
+    /// own slot, like a button rebuilding the screen, and is only destroyed once it returns
+    void invoke(int slot, Widget &w) {
+        auto &a = (*this)[slot];
+        if (!a)
+            return;
+        Action running = std::move(a);
+        running_.emplace_back(slot, false);
+        running(w);
+        if (!running_.back().second)
+            (*this)[slot] = std::move(running);
+        running_.pop_back();
+    }
+
+    /// Releases every action from slot mark onwards. Only actions with non-trivial destructors
+    /// are visited, the rest are simply forgotten
+    void release(size_t mark) {
+        for (auto &r : running_)
+            if (static_cast<size_t>(r.first) >= mark)
+                r.second = true;
+        while (!owning_.empty() && static_cast<size_t>(owning_.back()) >= mark) {
+            (*this)[owning_.back()].reset();
+            owning_.pop_back();
+        }
+        while (!free_.empty() && static_cast<size_t>(free_.front()) >= mark) {
+            std::pop_heap(free_.begin(), free_.end());
+            free_.pop_back();
+        }
+        if (mark < size_)
+            size_ = mark;
+        floor_ = std::min(floor_, mark);
+    }
+
+};
+
+/// Widget properties, for identifying writes to the same property
+enum class Prop : uint8_t { Text, Value, Foreground, Background, Fontsize, Size, Image, Style };
+
+#ifdef FLOUI_STATS
+/// Counters of one floui entry point. Times include those of nested entry points
+struct EntryStats {
+    const char *name;
+    uint64_t calls = 0;
+    uint64_t total_ns = 0;
+    uint64_t max_ns = 0;
+    /// Native calls issued, JNI calls on Android. Other platforms don't count them
+    uint64_t native_calls = 0;
+};
+
+/// Counters of a cache
+struct CacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    /// Time spent computing the missing entries
+    uint64_t miss_ns = 0;
+
+    double hit_rate() const { return hits + misses ? (double)hits / (hits + misses) : 0; }
+    /// Time the hits would have taken, at the average cost of a miss
+    uint64_t saved_ns() const { return misses ? hits * miss_ns / misses : 0; }
+};
+
+/// The counters of every entry point called so far, only compiled in when FLOUI_STATS is defined
+class Stats {
+    std::vector<std::unique_ptr<EntryStats>> entries_;
+
+  public:
+    /// Native calls issued so far on the calling thread, counted by the platform, so that the
+    /// calls of other threads, like the log drain, aren't charged to the UI thread's entry points
+    static inline thread_local uint64_t native_calls = 0;
+    /// Lookups of TextCache
+    CacheStats text_cache;
+
+    /// Gets the counters of an entry point, name has to outlive them
+    EntryStats &entry(const char *name) {
+        for (auto &e : entries_) {
+            if (!strcmp(e->name, name))
+                return *e;
+        }
+        entries_.push_back(std::make_unique<EntryStats>(EntryStats{name}));
+        return *entries_.back();
+    }
+    const std::vector<std::unique_ptr<EntryStats>> &entries() const { return entries_; }
+    /// Zeroes every counter
+    void reset() {
+        for (auto &e : entries_)
+            *e = EntryStats{e->name};
+        text_cache = CacheStats{};
+    }
+    /// Writes a table of the entry points called, the most time consuming first
+    void text(FILE *f = stderr) const {
+        std::vector<const EntryStats *> sorted;
+        for (auto &e : entries_) {
+            if (e->calls)
+                sorted.push_back(e.get());
+        }
+        std::sort(sorted.begin(), sorted.end(),
+                  [](auto a, auto b) { return a->total_ns > b->total_ns; });
+        fprintf(f, "%-28s %10s %12s %10s %10s\n", "entry", "calls", "total us", "max us",
+                "native");
+        for (auto e : sorted)
+            fprintf(f, "%-28s %10llu %12.1f %10.1f %10llu\n", e->name,
+                    (unsigned long long)e->calls, e->total_ns / 1000.0, e->max_ns / 1000.0,
+                    (unsigned long long)e->native_calls);
+        auto &t = text_cache;
+        if (t.hits + t.misses)
+            fprintf(f, "text cache: %llu hits, %llu misses, %.1f%% hit rate, %.1f us saved\n",
+                    (unsigned long long)t.hits, (unsigned long long)t.misses,
+                    t.hit_rate() * 100, t.saved_ns() / 1000.0);
+    }
+    void json(FILE *f = stdout) const {
+        fprintf(f, "{\"entries\": [");
+        auto first = true;
+        for (auto &e : entries_) {
+            if (!e->calls)
+                continue;
+            fprintf(f,
+                    "%s\n  {\"name\": \"%s\", \"calls\": %llu, \"total_ns\": %llu, \"max_ns\": "
+                    "%llu, \"native_calls\": %llu}",
+                    first ? "" : ",", e->name, (unsigned long long)e->calls,
+                    (unsigned long long)e->total_ns, (unsigned long long)e->max_ns,
+                    (unsigned long long)e->native_calls);
+            first = false;
+        }
+        auto &t = text_cache;
+        fprintf(f,
+                "\n],\n\"text_cache\": {\"hits\": %llu, \"misses\": %llu, \"miss_ns\": %llu, "
+                "\"saved_ns\": %llu}}\n",
+                (unsigned long long)t.hits, (unsigned long long)t.misses,
+                (unsigned long long)t.miss_ns, (unsigned long long)t.saved_ns());
+    }
+};
+
+/// The entry point counters
+inline Stats &stats() {
+    static Stats s;
+    return s;
+}
+
+/// Records a call of an entry point, from construction to destruction
+class StatScope {
+    EntryStats &entry_;
+    std::chrono::steady_clock::time_point start_;
+    uint64_t native_;
+
+  public:
+    explicit StatScope(EntryStats &e)
+        : entry_(e), start_(std::chrono::steady_clock::now()), native_(Stats::native_calls) {}
+    StatScope(const StatScope &) = delete;
+    StatScope &operator=(const StatScope &) = delete;
+    ~StatScope() {
+        auto ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                            std::chrono::steady_clock::now() - start_)
+                                            .count());
+        entry_.calls++;
+        entry_.total_ns += ns;
+        entry_.max_ns = std::max(entry_.max_ns, ns);
+        entry_.native_calls += Stats::native_calls - native_;
+    }
+};
+
+#define FLOUI_STAT_SCOPE(name)                                                                     \
+    static auto &floui_stat_entry_ = ::floui::stats().entry(name);                                 \
+    ::floui::StatScope floui_stat_scope_(floui_stat_entry_);
+#else
+#define FLOUI_STAT_SCOPE(name)
+#endif // FLOUI_STATS
+
+/// Records spans of floui's entry points, like widget construction, callbacks and flushes, as
+/// Chrome trace events. Each thread records into its own ring buffer, without locking, and the
+/// spans are written on demand to a file which loads into Perfetto or chrome://tracing.
+/// Entry points only check whether recording is on while it's off
+class Trace {
+  public:
+    /// A complete span, times are in nanoseconds since the first recording started
+    struct Event {
+        const char *name;
+        uint64_t start;
+        uint64_t duration;
+    };
+
+  private:
+    /// Written by its thread only, the head is published after the event it covers
+    struct Buffer {
+        std::vector<Event> events;
+        std::atomic<uint64_t> head{0};
+        uint32_t tid;
+    };
+
+    static inline std::atomic<bool> recording_{false};
+    static inline size_t capacity_ = 65536;
+    static inline std::mutex mutex_{};
+    static inline std::vector<std::shared_ptr<Buffer>> buffers_{};
+
+    static std::chrono::steady_clock::time_point epoch() {
+        static const auto t = std::chrono::steady_clock::now();
+        return t;
+    }
+
+    static Buffer &local() {
+        thread_local std::shared_ptr<Buffer> buffer = [] {
+            auto b = std::make_shared<Buffer>();
+            std::lock_guard<std::mutex> lock(mutex_);
+            b->events.resize(capacity_);
+            b->tid = static_cast<uint32_t>(buffers_.size() + 1);
+            buffers_.push_back(b);
+            return b;
+        }();
+        return *buffer;
+    }
+
+  public:
+    /// Starts recording, each thread keeps its last capacity spans. The capacity only applies to
+    /// threads which haven't recorded yet
+    static void start(size_t capacity = 65536) {
+        epoch();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            capacity_ = capacity ? capacity : 1;
+        }
+        recording_.store(true, std::memory_order_relaxed);
+    }
+    static void stop() { recording_.store(false, std::memory_order_relaxed); }
+    static bool recording() { return recording_.load(std::memory_order_relaxed); }
+    /// Nanoseconds since the epoch, never 0
+    static uint64_t now() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                         std::chrono::steady_clock::now() - epoch())
+                                         .count()) +
+               1;
+    }
+    /// Records a span which started at start and ends now
+    static void record(const char *name, uint64_t start) {
+        auto &b = local();
+        auto head = b.head.load(std::memory_order_relaxed);
+        b.events[head % b.events.size()] = Event{name, start - 1, now() - start};
+        b.head.store(head + 1, std::memory_order_release);
+    }
+    /// Number of spans held
+    static size_t size() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        size_t n = 0;
+        for (auto &b : buffers_)
+            n += std::min<size_t>(b->head.load(std::memory_order_acquire), b->events.size());
+        return n;
+    }
+    /// Drops the spans held. Threads must not be recording meanwhile
+    static void clear() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto &b : buffers_)
+            b->head.store(0, std::memory_order_relaxed);
+    }
+    /// Writes the spans held as trace event JSON. Spans a thread records meanwhile may be
+    /// overwritten, so this is best done after stop()
+    static bool write(const char *path) {
+        auto f = fopen(path, "w");
+        if (!f)
+            return false;
+        fprintf(f, "{\"traceEvents\": [");
+        auto first = true;
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto &b : buffers_) {
+            auto head = b->head.load(std::memory_order_acquire);
+            auto size = b->events.size();
+            for (auto i = head > size ? head - size : 0; i < head; i++) {
+                auto &e = b->events[i % size];
+                fprintf(f,
+                        "%s\n{\"name\": \"%s\", \"cat\": \"floui\", \"ph\": \"X\", \"ts\": %.3f, "
+                        "\"dur\": %.3f, \"pid\": 1, \"tid\": %u}",
+                        first ? "" : ",", e.name, e.start / 1000.0, e.duration / 1000.0, b->tid);
+                first = false;
+            }
+        }
+        fprintf(f, "\n], \"displayTimeUnit\": \"ns\"}\n");
+        return fclose(f) == 0;
+    }
+};
+
+/// Records a span of an entry point while Trace is recording, from construction to destruction
+class TraceSpan {
+    const char *name_;
+    uint64_t start_ = 0;
+
+  public:
+    explicit TraceSpan(const char *name) : name_(name) {
+        if (Trace::recording())
+            start_ = Trace::now();
+    }
+    TraceSpan(const TraceSpan &) = delete;
+    TraceSpan &operator=(const TraceSpan &) = delete;
+    ~TraceSpan() {
+        if (start_)
+            Trace::record(name_, start_);
+    }
+};
+
+/// Instruments the entry point name until the end of the enclosing scope: its call is counted
+/// when FLOUI_STATS is defined, and traced while Trace is recording
+#define FLOUI_ENTRY(name)                                                                          \
+    FLOUI_STAT_SCOPE(name)                                                                         \
+    ::floui::TraceSpan floui_trace_span_(name)
+
 /// Wraps global state
 class FlouiViewController {
+    struct Write {
+        void *view;
+        Prop prop;
+        bool operator==(const Write &o) const { return view == o.view && prop == o.prop; }
+    };
+    struct WriteHash {
+        size_t operator()(const Write &w) const {
+            return std::hash<void *>()(w.view) * 31 + static_cast<size_t>(w.prop);
+        }
+    };
+
   protected:
     FlouiViewControllerImpl *impl;
+    /// Callbacks, indexed by their dispatch slot
+    static inline ActionPool actions{};
+    static inline bool batching_ = false;
+    static inline bool flushing_ = false;
+    /// Queued writes in the order their property was first written, and their index by property
+    static inline std::vector<std::pair<Write, Action>> writes_{};
+    static inline std::unordered_map<Write, size_t, WriteHash> pending_{};
+
+    /// The last value written to a property, numbers are packed into n, strings kept in s
+    struct Value {
+        uint64_t n = 0;
+        std::string s;
+        bool operator==(const Value &o) const { return n == o.n && s == o.s; }
+    };
+    static void pack(Value &v, const std::string &s) { v.s = s; }
+    static void pack(Value &v, double d) {
+        uint64_t bits;
+        std::memcpy(&bits, &d, sizeof(bits));
+        v.n = bits;
+    }
+    static void pack(Value &v, int i) { v.n = (v.n << 32) | static_cast<uint32_t>(i); }
+    static void pack(Value &v, uint32_t u) { v.n = (v.n << 32) | u; }
+    static void pack(Value &v, bool b) { v.n = b; }
+    static void pack(Value &v, const void *p) { v.n = reinterpret_cast<uintptr_t>(p); }
+
+    static inline bool eliding_ = false;
+    /// The cached values of each view's properties
+    static inline std::unordered_map<void *, std::vector<std::pair<Prop, Value>>> applied_{};
+    static inline size_t applied_count_ = 0;
+    static inline size_t elided_count_ = 0;
+
+    /// A write of a property a Style sets means the view's style may no longer hold
+    static void restyled(void *view, Prop prop) {
+        if (prop == Prop::Foreground || prop == Prop::Background || prop == Prop::Fontsize)
+            invalidate(view, Prop::Style);
+    }
+
+    /// A task posted from another thread. Posts push onto a lock-free stack, which drain takes
+    /// whole and reverses, so every task posted within one loop turn runs in one batch
+    struct Posted {
+        std::function<void()> f;
+        Posted *next = nullptr;
+    };
+    static inline std::atomic<Posted *> posted_{nullptr};
+
+    /// The callback being dispatched, which async work started from it is tied to
+    static inline int event_slot_ = -1;
+    static inline void *event_view_ = nullptr;
+    friend void post(std::function<void()> f);
+    friend void post_batch(std::vector<std::function<void()>> fs);
+
+    /// Pushes the chain first..last, waking the UI thread if the queue was empty
+    static void push(Posted *first, Posted *last) {
+        auto head = posted_.load(std::memory_order_relaxed);
+        do {
+            last->next = head;
+        } while (!posted_.compare_exchange_weak(head, first, std::memory_order_release,
+                                                std::memory_order_relaxed));
+        if (!head)
+            wake();
+    }
 
   public:
     /// Instantiate a new view controller
     /// On android, the params are (JNIenv, main_view: Jobject, ConstraintLayout: Jobject)
     /// On iOS, the params are (UIViewController, optional const char *application_label: void *)
     FlouiViewController(void *, void * = nullptr, void * = nullptr);
-    /// Needed on Android
+    /// Needed on Android, finds the callback from the view's id
     static void handle_events(void *view);
+    /// Invokes the callback registered in slot, with the view which triggered it.
+    /// On Android, the slot is stored as the view's tag, so it can be passed from Java directly
+    static void handle_event(int slot, void *view);
+    /// Registers a callback, returning its dispatch slot
+    static int add_callback(Action &&f);
+    /// The slot the next callback will get, to pass to release_callbacks
+    static size_t callback_mark() { return actions.mark(); }
+    /// Slots taken by callbacks, counting released ones awaiting reuse
+    static size_t callback_slots() { return actions.size(); }
+    /// Releases the callbacks registered since mark, once the views they're attached to are
+    /// discarded. The controller doesn't do so itself, since on Android it only lives for the
+    /// duration of mainView
+    static void release_callbacks(size_t mark = 0) {
+        for (auto w : Inflight::all())
+            if (w->slot_ >= 0 && static_cast<size_t>(w->slot_) >= mark)
+                w->cancelled_ = true;
+        actions.release(mark);
+    }
+    /// Releases a single callback, once the view it's attached to is discarded on its own. Its
+    /// slot is reused by a later callback
+    static void release_callback(int slot) {
+        for (auto w : Inflight::all())
+            if (w->slot_ == slot)
+                w->cancelled_ = true;
+        actions.free(slot);
+    }
+    /// Records the slots of the callbacks registered while it's alive, so they can be released
+    /// one at a time with release_callback
+    class Recording {
+        std::vector<int> *prev_;
+
+      public:
+        explicit Recording(std::vector<int> &slots) : prev_(actions.record(&slots)) {}
+        Recording(const Recording &) = delete;
+        Recording &operator=(const Recording &) = delete;
+        ~Recording() { actions.record(prev_); }
+    };
+    /// Async work started by an event callback, registered while it's in flight. It's cancelled
+    /// when the callback is released or the view which triggered it is cancelled, after which its
+    /// results are dropped. Only touched on the UI thread
+    class Inflight {
+        friend class FlouiViewController;
+        int slot_ = event_slot_;
+        void *view_ = event_view_;
+        bool cancelled_ = false;
+
+        static std::vector<Inflight *> &all() {
+            static std::vector<Inflight *> inflight;
+            return inflight;
+        }
+
+      public:
+        Inflight() { all().push_back(this); }
+        Inflight(const Inflight &) = delete;
+        Inflight &operator=(const Inflight &) = delete;
+        ~Inflight() {
+            auto &v = all();
+            v.erase(std::find(v.begin(), v.end(), this));
+        }
+        bool cancelled() const { return cancelled_; }
+    };
+    /// Cancels the async work started by view's events, for when the view is torn down
+    static void cancel(void *view) {
+        for (auto w : Inflight::all())
+            if (w->view_ == view)
+                w->cancelled_ = true;
+    }
+    /// Number of async works in flight
+    static size_t inflight() { return Inflight::all().size(); }
+    /// Opts into batching property writes. Writes are then queued per widget and property, only
+    /// the last write to each is kept, and they're applied once per event loop turn: after each
+    /// event callback, on FLTK from an Fl::add_check handler and on iOS before the main run loop
+    /// waits. Disabling it flushes the queue
+    static void batch(bool enable) {
+        batching_ = enable;
+        if (!enable)
+            flush();
+    }
+    static bool batching() { return batching_; }
+    /// Queues a write of prop if batching, replacing any queued write of it. Returns whether it
+    /// was queued, otherwise the caller applies it
+    template <typename F>
+    static bool defer(void *view, Prop prop, F &&f) {
+        if (!batching_ || flushing_)
+            return false;
+        auto it = pending_.find(Write{view, prop});
+        if (it != pending_.end()) {
+            writes_[it->second].second = Action(std::forward<F>(f));
+        } else {
+            pending_.emplace(Write{view, prop}, writes_.size());
+            writes_.emplace_back(Write{view, prop}, Action(std::forward<F>(f)));
+        }
+        return true;
+    }
+    /// Applies the queued writes
+    static void flush();
+    /// Applies the queued write to prop of view alone, if there's one, so a getter reads it
+    static void settle(void *view, Prop prop);
+    /// Forgets a view which is about to be destroyed: its cached values, its queued writes and
+    /// the async work it started
+    static void discard(void *view);
+    /// Opts into skipping writes of the value a property already has. The last value written to
+    /// each property is cached, and the cache is invalidated for a view when it triggers an event
+    /// or the backend sees its native state change, like text typed into a TextField
+    static void elide(bool enable) {
+        eliding_ = enable;
+        if (!enable)
+            applied_.clear();
+    }
+    /// Checks a write against the cached value of prop, recording it. Returns whether it can be
+    /// skipped
+    template <typename... Args>
+    static bool unchanged(void *view, Prop prop, const Args &...args) {
+        if (!eliding_)
+            return false;
+        Value v;
+        (pack(v, args), ...);
+        auto &props = applied_[view];
+        for (auto &[p, cached] : props) {
+            if (p != prop)
+                continue;
+            if (cached == v) {
+                elided_count_++;
+                return true;
+            }
+            cached = std::move(v);
+            restyled(view, prop);
+            applied_count_++;
+            return false;
+        }
+        props.emplace_back(prop, std::move(v));
+        restyled(view, prop);
+        applied_count_++;
+        return false;
+    }
+    /// Forgets the cached value of prop
+    static void invalidate(void *view, Prop prop) {
+        auto it = applied_.find(view);
+        if (it == applied_.end())
+            return;
+        auto &props = it->second;
+        props.erase(std::remove_if(props.begin(), props.end(),
+                                   [=](const auto &e) { return e.first == prop; }),
+                    props.end());
+    }
+    /// Forgets the cached values of all of view's properties
+    static void invalidate(void *view) { applied_.erase(view); }
+    /// Number of writes applied and skipped since elision was enabled
+    static size_t applied_writes() { return applied_count_; }
+    static size_t elided_writes() { return elided_count_; }
+    /// Runs the tasks posted since the last drain, in order, within one Transaction and flush.
+    /// Backends call it on the UI thread after wake, and it also runs after each event callback.
+    /// Returns the number of tasks run
+    static size_t drain();
+    /// Gets the UI thread to call drain, implemented by each backend. Called by the posting
+    /// thread, only by the first post after a drain
+    static void wake();
     ~FlouiViewController();
 };
 
+/// Runs f on the UI thread. Floui's state and the native views belong to the UI thread, so this is
+/// the only floui function which can be called from other threads
+inline void post(std::function<void()> f);
+
+/// Runs fs in order on the UI thread, pushing them all at once
+inline void post_batch(std::vector<std::function<void()>> fs);
+
+/// Groups the construction of many widgets within one native call. On Android, temporary local
+/// references are then released a whole frame at a time, and the created views are kept alive by
+/// global references until the scope ends, so the local reference table stays bounded no matter how
+/// many widgets are built. Other platforms need no special handling
+class BulkScope {
+  public:
+    /// capacity is the number of local references a frame holds before it's recycled
+    explicit BulkScope(int capacity = 256);
+    BulkScope(const BulkScope &) = delete;
+    BulkScope &operator=(const BulkScope &) = delete;
+    ~BulkScope();
+};
+
 /// Wraps an RGBA color, has several predefined colors, and can be instantiated from methods like
 /// rgb(r, g, b, a = 255)
 class Color {
@@ -96,1704 +1054,6112 @@ class Color {
     static Color rgb(uint8_t r, uint8_t g, uint8_t b, uint8_t a = 255);
 };
 
-#define DECLARE_STYLES(widget)                                                                     \
-    widget &background(uint32_t col);                                                              \
-    widget &id(const char *val);                                                                   \
-    widget &size(int w, int h);
+/// A widget ID, identified by the content of its name rather than the pointer.
+/// Constructing one from a string hashes it, the _id literal does so at compile time when bound to
+/// a constexpr variable, or when used in an expression the compiler folds:
+/// `static constexpr auto mytext = "mytext"_id;`
+class Id {
+    const char *name_;
+    uint64_t hash_;
+
+    static constexpr size_t length(const char *s) {
+        size_t len = 0;
+        while (s[len])
+            len++;
+        return len;
+    }
 
-class Widget {
-  protected:
-    /// Keeps a map of widgets assigned an ID
-    static inline std::unordered_map<const char *, void *> widget_map{};
-    /// A non-owning pointer of UIView on iOS and View (jobject) on Android
-    void *view = nullptr;
+    /// 64-bit FNV-1a
+    static constexpr uint64_t hash(const char *s, size_t len) {
+        uint64_t h = 0xcbf29ce484222325ull;
+        for (size_t i = 0; i < len; i++) {
+            h ^= static_cast<uint8_t>(s[i]);
+            h *= 0x100000001b3ull;
+        }
+        return h;
+    }
 
   public:
-    explicit Widget(void *v);
-    /// Gets the inner pointer
-    void *inner() const;
-    /// Gets back the Widget by its ID
-    template <typename T, typename = std::enable_if_t<std::is_base_of_v<Widget, T>>>
-    static T from_id(const char *v) {
-        return T{widget_map[v]};
-    }
-    DECLARE_STYLES(Widget)
+    constexpr Id(const char *name) : name_(name), hash_(hash(name, length(name))) {}
+    constexpr Id(const char *name, size_t len) : name_(name), hash_(hash(name, len)) {}
+    /// The name the ID was created with, not owned
+    constexpr const char *name() const { return name_; }
+    constexpr uint64_t hash() const { return hash_; }
 };
 
-class Button : public Widget {
+/// Creates an ID hashed at compile time, i.e. "mytext"_id
+constexpr Id operator""_id(const char *name, size_t len) { return Id(name, len); }
+
+/// Interns widget IDs and maps them to their views. Lookups hash through the precomputed hash, then
+/// compare the name, so IDs whose hashes collide are told apart instead of mistaken for each other
+class IdRegistry {
+    struct Entry {
+        std::string name;
+        void *view;
+    };
+    struct Identity {
+        size_t operator()(uint64_t h) const { return static_cast<size_t>(h); }
+    };
+    std::unordered_map<uint64_t, Entry, Identity> map_;
+    /// The hashes of the IDs assigned to each view, to forget them with the view
+    std::unordered_map<void *, std::vector<uint64_t>> views_;
+
+    void unlink(void *view, uint64_t hash) {
+        auto it = views_.find(view);
+        if (it == views_.end())
+            return;
+        auto &hashes = it->second;
+        hashes.erase(std::remove(hashes.begin(), hashes.end(), hash), hashes.end());
+        if (hashes.empty())
+            views_.erase(it);
+    }
+
   public:
-    explicit Button(void *b);
-    explicit Button(const std::string &label);
-    /// Makes the button filled on iOS
-    Button &filled();
-    /// Sets the callback of the button
-    Button &action(std::function<void(Widget &)> &&f);
-#ifdef __OBJC__
-    Button &action(::id target, SEL s);
-#endif
-    /// Sets the foreground (label) color
-    Button &foreground(uint32_t c);
-    DECLARE_STYLES(Button)
+    /// Assigns an ID to a view, replacing any view which had it. An ID whose hash collides with
+    /// another ID's is reported and not assigned, leaving the other ID's view in place
+    void insert(Id id, void *view) {
+        auto it = map_.find(id.hash());
+        if (it == map_.end()) {
+            map_.emplace(id.hash(), Entry{id.name(), view});
+            views_[view].push_back(id.hash());
+            return;
+        }
+        if (it->second.name != id.name()) {
+            floui_log("floui: id \"%s\" collides with id \"%s\", not assigned", id.name(),
+                      it->second.name.c_str());
+            return;
+        }
+        if (it->second.view == view)
+            return;
+        unlink(it->second.view, id.hash());
+        it->second.view = view;
+        views_[view].push_back(id.hash());
+    }
+    /// Gets the view with the ID, reporting unknown IDs and returning nullptr
+    void *find(Id id) const {
+        auto it = map_.find(id.hash());
+        if (it == map_.end() || it->second.name != id.name()) {
+            floui_log("floui: no widget has the id \"%s\"", id.name());
+            return nullptr;
+        }
+        return it->second.view;
+    }
+    /// Checks whether a view has the ID, without reporting
+    bool contains(Id id) const {
+        auto it = map_.find(id.hash());
+        return it != map_.end() && it->second.name == id.name();
+    }
+    /// Forgets the ID, if it's the one assigned
+    void erase(Id id) {
+        auto it = map_.find(id.hash());
+        if (it != map_.end() && it->second.name == id.name()) {
+            unlink(it->second.view, id.hash());
+            map_.erase(it);
+        }
+    }
+    /// Forgets the ID if it's still assigned to view
+    void erase(Id id, void *view) {
+        auto it = map_.find(id.hash());
+        if (it != map_.end() && it->second.name == id.name() && it->second.view == view) {
+            unlink(view, id.hash());
+            map_.erase(it);
+        }
+    }
+    /// Forgets every ID assigned to view, once it's destroyed
+    void erase(void *view) {
+        auto it = views_.find(view);
+        if (it == views_.end())
+            return;
+        for (auto hash : it->second)
+            map_.erase(hash);
+        views_.erase(it);
+    }
+    size_t size() const { return map_.size(); }
 };
 
-class Toggle : public Widget {
-  public:
-    explicit Toggle(void *b);
-    explicit Toggle(const std::string &label);
-    /// Sets whether a toggle is on or off
-    Toggle &value(bool val);
-    /// Gets the toggle's value
-    bool value();
-    /// Sets the callback of the button
-    Toggle &action(std::function<void(Widget &)> &&f);
-#ifdef __OBJC__
-    Toggle &action(::id target, SEL s);
-#endif
-    Toggle &foreground(uint32_t c);
-    DECLARE_STYLES(Toggle)
+class Effect;
+
+/// What effects read, a State's value, which knows the effects to rerun once it changes
+struct Source {
+    std::vector<Effect *> readers;
 };
 
-/// A checkbox widget, iOS doesn't support checkboxes out of the box, only on iOS apps built for
-/// Catalyst (to run on OSX)
-class Check : public Widget {
+/// An update which reruns whenever a State it read during its last run changes. Reruns are
+/// deferred to the end of the current Transaction, so each effect runs at most once per event
+class Effect {
+    std::function<void()> f_;
+    bool queued_ = false;
+    /// The sources read during the last run
+    std::vector<std::weak_ptr<Source>> sources_;
+    /// The bound property, for effects attached to a view
+    Prop prop_ = Prop::Text;
+
+    static inline Effect *current_ = nullptr;
+    static inline int depth_ = 0;
+    static inline std::vector<Effect *> queue_{};
+    static inline std::vector<std::unique_ptr<Effect>> effects_{};
+    /// The effects attached to each view, at most one per property
+    static inline std::unordered_map<void *, std::vector<std::unique_ptr<Effect>>> attached_{};
+
+    explicit Effect(std::function<void()> &&f) : f_(std::move(f)) {}
+
+    /// Subscribes to s, for the rest of the current run
+    void track(std::shared_ptr<Source> s) {
+        auto &r = s->readers;
+        if (std::find(r.begin(), r.end(), this) != r.end())
+            return;
+        r.push_back(this);
+        sources_.push_back(std::move(s));
+    }
+
+    /// Unsubscribes from the sources of the last run
+    void untrack() {
+        for (auto &w : sources_) {
+            if (auto s = w.lock()) {
+                auto &r = s->readers;
+                r.erase(std::find(r.begin(), r.end(), this));
+            }
+        }
+        sources_.clear();
+    }
+
+    template <typename T>
+    friend class State;
+    friend class Transaction;
+
   public:
-    explicit Check(void *b);
-    explicit Check(const std::string &label);
-    /// Sets whether the checkbox is on or off
-    Check &value(bool val);
-    /// Gets the checks's value
-    bool value();
-    /// Sets the callback of the button
-    Check &action(std::function<void(Widget &)> &&f);
-#ifdef __OBJC__
-    Check &action(::id target, SEL s);
-#endif
-    Check &foreground(uint32_t c);
-    DECLARE_STYLES(Check)
+    Effect(const Effect &) = delete;
+    Effect &operator=(const Effect &) = delete;
+    ~Effect() {
+        untrack();
+        if (queued_)
+            std::replace(queue_.begin(), queue_.end(), this, static_cast<Effect *>(nullptr));
+    }
+
+    /// Runs f, tracking the States it reads, and keeps it alive for the rest of the program
+    static Effect &create(std::function<void()> &&f) {
+        effects_.emplace_back(new Effect(std::move(f)));
+        auto &e = *effects_.back();
+        e.run();
+        return e;
+    }
+
+    /// Runs f, tracking the States it reads, as the binding of view's property prop. It replaces
+    /// the effect the property was bound to, and is dropped by forget once the view is discarded
+    static Effect &attach(void *view, Prop prop, std::function<void()> &&f) {
+        auto &effects = attached_[view];
+        auto it = std::find_if(effects.begin(), effects.end(), [prop](const auto &e) {
+            return e->prop_ == prop;
+        });
+        if (it == effects.end())
+            it = effects.insert(effects.end(), nullptr);
+        it->reset(new Effect(std::move(f)));
+        auto &e = **it;
+        e.prop_ = prop;
+        e.run();
+        return e;
+    }
+
+    /// Drops the effects attached to view, once it's discarded
+    static void forget(void *view) { attached_.erase(view); }
+    /// Number of views which have effects attached
+    static size_t attached() { return attached_.size(); }
+
+    /// Drops every effect
+    static void reset() {
+        attached_.clear();
+        effects_.clear();
+        queue_.clear();
+    }
+
+    /// Reruns f, tracking the States it reads this time
+    void run() {
+        untrack();
+        auto prev = current_;
+        current_ = this;
+        f_();
+        current_ = prev;
+    }
+
+    /// Queues a rerun, which happens right away outside of a Transaction
+    void schedule() {
+        if (queued_)
+            return;
+        queued_ = true;
+        queue_.push_back(this);
+        if (depth_ == 0)
+            flush();
+    }
+
+    /// Reruns queued effects, including any their reruns queue
+    static void flush() {
+        depth_++;
+        // Reruns may queue more effects, or drop queued ones, which are nulled out
+        for (size_t i = 0; i < queue_.size(); i++) {
+            if (auto e = queue_[i]) {
+                e->queued_ = false;
+                e->run();
+            }
+        }
+        queue_.clear();
+        depth_--;
+    }
 };
 
-class Slider : public Widget {
+/// Defers effects of the State changes made during its lifetime to its end. Event callbacks run
+/// within one, so setting a State several times in a callback updates its bindings once
+class Transaction {
   public:
-    explicit Slider(void *b);
-    Slider();
-    Slider &value(double val);
-    double value();
-    /// Sets the callback of the button
-    Slider &action(std::function<void(Widget &)> &&f);
-#ifdef __OBJC__
-    Slider &action(::id target, SEL s);
-#endif
-    Slider &foreground(uint32_t c);
-    DECLARE_STYLES(Slider)
+    Transaction() { Effect::depth_++; }
+    Transaction(const Transaction &) = delete;
+    Transaction &operator=(const Transaction &) = delete;
+    ~Transaction() {
+        if (--Effect::depth_ == 0)
+            Effect::flush();
+    }
 };
 
-class Text : public Widget {
-  public:
-    explicit Text(void *b);
-    explicit Text(const std::string &s);
-    /// Centers the text
-    Text &center();
-    /// Changes the alignment to left
-    Text &left();
-    /// Changes the alignment to right
-    Text &right();
-    /// Makes the text bold
-    Text &bold();
-    /// Makes the text italic
-    Text &italic();
-    /// Makes the text normal, which is the default
-    Text &normal();
-    /// Sets the text content
-    Text &text(const std::string &s);
-    /// Sets the text's color
-    Text &foreground(uint32_t c);
-    /// Changes the fontsize
-    Text &fontsize(int size);
-    DECLARE_STYLES(Text)
+/// A value which widget properties can be bound to. Copies share the value
+/// ```cpp
+/// State<int> counter(0);
+/// Text(bind(counter, to_string));
+/// Button("Increment").action([=](Widget &) { counter.set(counter.get() + 1); });
+/// ```
+template <typename T>
+class State {
+    struct Cell : Source {
+        explicit Cell(T v) : value(std::move(v)) {}
+        T value;
+    };
+    std::shared_ptr<Cell> cell_;
+
+    template <typename U, typename = void>
+    struct comparable : std::false_type {};
+    template <typename U>
+    struct comparable<U, std::void_t<decltype(std::declval<U>() == std::declval<U>())>>
+        : std::true_type {};
+
+  public:
+    explicit State(T value = T{}) : cell_(std::make_shared<Cell>(std::move(value))) {}
+
+    /// Gets the value, subscribing the running Effect to changes
+    const T &get() const {
+        if (auto e = Effect::current_)
+            e->track(cell_);
+        return cell_->value;
+    }
+
+    /// Sets the value, scheduling the effects which read it unless it's unchanged. Copies share the
+    /// value, so it's const like a pointer's
+    void set(T value) const {
+        if constexpr (comparable<T>::value) {
+            if (value == cell_->value)
+                return;
+        }
+        cell_->value = std::move(value);
+        // Reruns wait until every reader is queued, as they resubscribe
+        Transaction t;
+        for (auto e : cell_->readers)
+            e->schedule();
+    }
+
+    /// Sets the value to f(value)
+    template <typename F>
+    void update(F &&f) const {
+        set(f(cell_->value));
+    }
 };
 
-class TextField : public Widget {
+/// A value computed from States, for binding to widget properties
+template <typename R>
+class Bound {
+    std::function<R()> f_;
+
   public:
-    explicit TextField(void *b);
-    TextField();
-    /// Centers the text
-    TextField &center();
-    /// Changes the alignment to left
-    TextField &left();
-    /// Changes the alignment to right
-    TextField &right();
-    /// Sets the text content
-    TextField &text(const std::string &s);
-    /// Sets the text
-    std::string text() const;
-    /// Changes the fontsize
-    TextField &fontsize(int size);
-    /// Sets the text's color
-    TextField &foreground(uint32_t c);
-    DECLARE_STYLES(TextField)
+    explicit Bound(std::function<R()> f) : f_(std::move(f)) {}
+    R operator()() const { return f_(); }
 };
 
-/// An empty widget
-class Spacer : public Widget {
+/// Binds to f(state)
+template <typename T, typename F>
+auto bind(const State<T> &state, F f) -> Bound<decltype(f(state.get()))> {
+    return Bound<decltype(f(state.get()))>([state, f] { return f(state.get()); });
+}
+
+/// Binds to the state's value
+template <typename T>
+Bound<T> bind(const State<T> &state) {
+    return Bound<T>([state] { return state.get(); });
+}
+
+/// Binds to any computation, it's recomputed whenever a State it reads changes
+template <typename F>
+auto bind(F f) -> Bound<decltype(f())> {
+    return Bound<decltype(f())>(std::move(f));
+}
+
+/// std::to_string as a function object, so it can be passed to bind
+inline constexpr auto to_string = [](const auto &v) { return std::to_string(v); };
+
+/// A portable flexbox-style layout engine. Each view is a node, and containers lay out their
+/// children in a column or a row: children get their preferred size along it, then grow into the
+/// free space or shrink out of the missing space by their factors, and are aligned across it.
+/// Preferred sizes are cached until a node, or one below it, is marked dirty, and update only
+/// lays out again the subtrees which are dirty or whose frame changed, handing the new frames to
+/// the backend. Only touched on the UI thread.
+/// Backends which lay out through it implement measure and apply, describe their containers with
+/// container and add, mark views whose content changed dirty, and call update once per event loop
+/// turn. The others leave them undefined, and the layout setters of widgets have no effect there
+class Layout {
   public:
-    explicit Spacer(void *b);
-    Spacer();
-    DECLARE_STYLES(Spacer)
+    enum class Direction : uint8_t { Column, Row };
+    /// How children are placed across the direction
+    enum class Align : uint8_t { Stretch, Start, Center, End };
+    /// How children are placed along the direction, when none of them grows
+    enum class Justify : uint8_t { Start, Center, End, SpaceBetween };
+    /// A view's frame, in the coordinates of its root
+    struct Frame {
+        int x = 0;
+        int y = 0;
+        int width = 0;
+        int height = 0;
+    };
+
+  private:
+    struct Node {
+        void *view = nullptr;
+        Node *parent = nullptr;
+        std::vector<Node *> children;
+        Direction direction = Direction::Column;
+        Align align = Align::Stretch;
+        Justify justify = Justify::Start;
+        bool container = false;
+        /// Children of scrolling containers keep their preferred size along the direction
+        bool scrolls = false;
+        float grow = 0;
+        float shrink = 1;
+        int padding = 0;
+        int spacing = 0;
+        /// The size set by size(), -1 for the preferred one
+        int width = -1;
+        int height = -1;
+        /// The preferred size, valid unless measure_dirty
+        int pref_width = 0;
+        int pref_height = 0;
+        bool measure_dirty = true;
+        bool layout_dirty = true;
+        bool placed = false;
+        Frame frame;
+    };
+
+    /// Nodes don't move once inserted, so they point at each other
+    static inline std::unordered_map<void *, Node> nodes_;
+    static inline std::vector<Node *> roots_;
+    /// Whether any node is dirty
+    static inline bool dirty_ = false;
+    static inline size_t measured_ = 0;
+    static inline size_t applied_ = 0;
+
+    static Node &node(void *view) {
+        auto &n = nodes_[view];
+        n.view = view;
+        return n;
+    }
+
+    /// Marks n and its ancestors dirty. Ancestors of dirty nodes are dirty, so it stops at the
+    /// first one which already is
+    static void mark(Node *n) {
+        dirty_ = true;
+        for (; n && !(n->measure_dirty && n->layout_dirty); n = n->parent)
+            n->measure_dirty = n->layout_dirty = true;
+    }
+
+    static void detach(Node &child) {
+        if (!child.parent)
+            return;
+        auto &siblings = child.parent->children;
+        siblings.erase(std::find(siblings.begin(), siblings.end(), &child));
+        mark(child.parent);
+        child.parent = nullptr;
+    }
+
+    /// A child's factors only matter to its container, which lays it out again
+    static void dirty_parent(void *view) {
+        auto parent = nodes_[view].parent;
+        if (parent)
+            mark(parent);
+    }
+
+    static int main_size(const Node &n, bool row) { return row ? n.pref_width : n.pref_height; }
+    static int cross_size(const Node &n, bool row) { return row ? n.pref_height : n.pref_width; }
+
+    static void prefer(Node &n) {
+        if (!n.measure_dirty)
+            return;
+        n.measure_dirty = false;
+        int w = 0, h = 0;
+        if (n.container) {
+            auto row = n.direction == Direction::Row;
+            int main = 0, cross = 0;
+            for (auto c : n.children) {
+                prefer(*c);
+                main += main_size(*c, row);
+                cross = std::max(cross, cross_size(*c, row));
+            }
+            if (!n.children.empty())
+                main += n.spacing * (int)(n.children.size() - 1);
+            w = row ? main : cross;
+            h = row ? cross : main;
+        } else if (n.width < 0 || n.height < 0) {
+            measured_++;
+            measure(n.view, w, h);
+        }
+        n.pref_width = n.width >= 0 ? n.width : w + 2 * n.padding;
+        n.pref_height = n.height >= 0 ? n.height : h + 2 * n.padding;
+    }
+
+    /// Gives n frame f, and lays out its children again if it's dirty or resized. Clean subtrees
+    /// keeping their frame are skipped
+    static void place(Node &n, const Frame &f) {
+        auto moved = !n.placed || f.x != n.frame.x || f.y != n.frame.y;
+        auto resized = !n.placed || f.width != n.frame.width || f.height != n.frame.height;
+        if (!n.layout_dirty && !moved && !resized)
+            return;
+        if (moved || resized) {
+            n.frame = f;
+            n.placed = true;
+            applied_++;
+            apply(n.view, f);
+        }
+        n.layout_dirty = false;
+        if (!n.container || n.children.empty())
+            return;
+        auto row = n.direction == Direction::Row;
+        auto count = (int)n.children.size();
+        auto x = f.x + n.padding, y = f.y + n.padding;
+        auto inner_main = std::max(0, (row ? f.width : f.height) - 2 * n.padding);
+        auto inner_cross = std::max(0, (row ? f.height : f.width) - 2 * n.padding);
+        int total = 0;
+        float grows = 0, shrinks = 0;
+        for (auto c : n.children) {
+            total += main_size(*c, row);
+            grows += c->grow;
+            shrinks += c->shrink * main_size(*c, row);
+        }
+        auto space = n.scrolls ? 0 : inner_main - total - n.spacing * (count - 1);
+        int pos = 0, gap = n.spacing;
+        if (space > 0 && grows <= 0) {
+            if (n.justify == Justify::Center)
+                pos = space / 2;
+            else if (n.justify == Justify::End)
+                pos = space;
+            else if (n.justify == Justify::SpaceBetween && count > 1)
+                gap += space / (count - 1);
+        }
+        // Shares are rounded at their running total, so they add up to exactly space
+        float done = 0;
+        for (auto c : n.children) {
+            auto main = main_size(*c, row);
+            if (space > 0 && grows > 0) {
+                main += (int)(space * (done + c->grow) / grows) - (int)(space * done / grows);
+                done += c->grow;
+            } else if (space < 0 && shrinks > 0) {
+                auto weight = c->shrink * main_size(*c, row);
+                main += (int)(space * (done + weight) / shrinks) - (int)(space * done / shrinks);
+                main = std::max(0, main);
+                done += weight;
+            }
+            auto fixed_cross = row ? c->height : c->width;
+            auto cross = n.align == Align::Stretch && fixed_cross < 0
+                             ? inner_cross
+                             : std::min(cross_size(*c, row), inner_cross);
+            auto offset = n.align == Align::Center ? (inner_cross - cross) / 2
+                          : n.align == Align::End  ? inner_cross - cross
+                                                   : 0;
+            place(*c, row ? Frame{x + pos, y + offset, main, cross}
+                          : Frame{x + offset, y + pos, cross, main});
+            pos += main + gap;
+        }
+    }
+
+  public:
+    /// Whether the backend lays out through Layout, as FLTK and headless do. Android and iOS lay
+    /// out with their native stacks, where the layout setters of widgets don't record nodes
+#if defined(__ANDROID__) || (defined(__APPLE__) && defined(__OBJC__))
+    static constexpr bool enabled = false;
+#else
+    static constexpr bool enabled = true;
+#endif
+    /// Makes view a container, laying out its children along direction. The children of
+    /// scrolling containers keep their preferred size along it
+    static void container(void *view, Direction direction, bool scrolls = false) {
+        auto &n = node(view);
+        n.container = true;
+        n.direction = direction;
+        n.scrolls = scrolls;
+        mark(&n);
+    }
+    /// Makes view a root, laid out at the origin, at the size set by size() or else its
+    /// preferred one
+    static void root(void *view) {
+        auto n = &node(view);
+        if (std::find(roots_.begin(), roots_.end(), n) == roots_.end())
+            roots_.push_back(n);
+        mark(n);
+    }
+    /// Appends child to parent's children, taking it from its previous parent
+    static void add(void *parent, void *child) {
+        auto &p = node(parent);
+        auto &c = node(child);
+        detach(c);
+        c.parent = &p;
+        p.children.push_back(&c);
+        // A child which was laid out elsewhere is placed again
+        c.placed = false;
+        mark(&c);
+        mark(&p);
+    }
+    /// Inserts child before parent's child at index, or appends it if index is negative or past
+    /// the end, taking it from its previous parent
+    static void insert(void *parent, void *child, int index) {
+        auto &p = node(parent);
+        auto &c = node(child);
+        detach(c);
+        c.parent = &p;
+        auto at = index < 0 ? p.children.size()
+                            : std::min(static_cast<size_t>(index), p.children.size());
+        p.children.insert(p.children.begin() + at, &c);
+        c.placed = false;
+        mark(&c);
+        mark(&p);
+    }
+    /// Appends children to parent's children, marking parent once
+    static void add(void *parent, const std::vector<void *> &children) {
+        auto &p = node(parent);
+        p.children.reserve(p.children.size() + children.size());
+        for (auto child : children) {
+            auto &c = node(child);
+            detach(c);
+            c.parent = &p;
+            p.children.push_back(&c);
+            c.placed = false;
+            mark(&c);
+        }
+        mark(&p);
+    }
+    static void remove(void *parent, void *child) {
+        auto it = nodes_.find(child);
+        if (it != nodes_.end() && it->second.parent && it->second.parent->view == parent)
+            detach(it->second);
+    }
+    static void clear(void *parent) {
+        auto it = nodes_.find(parent);
+        if (it == nodes_.end())
+            return;
+        for (auto c : it->second.children)
+            c->parent = nullptr;
+        it->second.children.clear();
+        mark(&it->second);
+    }
+    /// Drops view's node, once the view is destroyed
+    static void forget(void *view) {
+        auto it = nodes_.find(view);
+        if (it == nodes_.end())
+            return;
+        auto &n = it->second;
+        detach(n);
+        for (auto c : n.children)
+            c->parent = nullptr;
+        roots_.erase(std::remove(roots_.begin(), roots_.end(), &n), roots_.end());
+        nodes_.erase(it);
+    }
+    /// Marks view to be measured again, after its content changed
+    static void dirty(void *view) {
+        auto it = nodes_.find(view);
+        if (it != nodes_.end())
+            mark(&it->second);
+    }
+    /// Fixes view's size, -1 keeps its preferred width or height
+    static void size(void *view, int width, int height) {
+        auto &n = node(view);
+        if (n.width == width && n.height == height)
+            return;
+        n.width = width;
+        n.height = height;
+        mark(&n);
+    }
+    /// Sets the share of its container's free space which view grows into, 0 by default
+    static void grow(void *view, float factor) {
+        if (!enabled)
+            return;
+        node(view).grow = factor;
+        dirty_parent(view);
+    }
+    /// Sets how much view shrinks, relative to its size, when its container lacks space, 1 by
+    /// default
+    static void shrink(void *view, float factor) {
+        if (!enabled)
+            return;
+        node(view).shrink = factor;
+        dirty_parent(view);
+    }
+    /// Sets the space kept around view's content or children
+    static void padding(void *view, int val) {
+        if (!enabled)
+            return;
+        auto &n = node(view);
+        n.padding = val;
+        mark(&n);
+    }
+    /// Sets the space between a container's children
+    static void spacing(void *view, int val) {
+        auto &n = node(view);
+        n.spacing = val;
+        mark(&n);
+    }
+    /// Sets how a container's children are placed across its direction, stretched by default
+    static void align(void *view, Align align) {
+        if (!enabled)
+            return;
+        auto &n = node(view);
+        n.align = align;
+        mark(&n);
+    }
+    /// Sets how a container's children are placed along its direction when none grows
+    static void justify(void *view, Justify justify) {
+        if (!enabled)
+            return;
+        auto &n = node(view);
+        n.justify = justify;
+        mark(&n);
+    }
+    /// Lays out the dirty subtrees of every root, and applies the frames which changed
+    static void update() {
+        if (!dirty_)
+            return;
+        FLOUI_ENTRY("Layout::update");
+        dirty_ = false;
+        for (auto r : roots_) {
+            prefer(*r);
+            place(*r, Frame{0, 0, r->pref_width, r->pref_height});
+        }
+    }
+    /// Gets view's frame, as of the last update
+    static Frame frame(void *view) {
+        auto it = nodes_.find(view);
+        return it != nodes_.end() ? it->second.frame : Frame{};
+    }
+    /// Number of views measured, and of frames applied, so far
+    static size_t measured() { return measured_; }
+    static size_t applied() { return applied_; }
+    /// Number of views which have a node
+    static size_t size() { return nodes_.size(); }
+    /// Drops every node, like headless::reset, only meant between benchmark runs or tests
+    static void reset() {
+        nodes_.clear();
+        roots_.clear();
+        dirty_ = false;
+        measured_ = applied_ = 0;
+    }
+
+    /// Gets the size of view's content, a text's or an image's
+    static void measure(void *view, int &width, int &height);
+    /// Moves and resizes view to frame
+    static void apply(void *view, const Frame &frame);
 };
 
-/// The main view of your application
-class MainView : public Widget {
+/// A font, as set by fontsize, bold and italic. The face is the backend's, an Fl_Font with FLTK
+struct Font {
+    int face = 0;
+    int size = 14;
+    bool bold = false;
+    bool italic = false;
+};
+
+/// Caches the size of texts in a font, wrapped to a maximum width, and where their lines break,
+/// so labels are only shaped once however often they're laid out or truncated. Entries are kept
+/// in an LRU, up to a capacity. Only touched on the UI thread.
+/// Backends which measure text this way implement shape
+class TextCache {
   public:
-    explicit MainView(void *m);
-    MainView(const FlouiViewController &vc, std::initializer_list<Widget> l);
-    /// Sets the spacing between items
-    MainView &spacing(int val);
-    /// Add a widget
-    MainView &add(const Widget &w);
-    /// Remove a widget
-    MainView &remove(const Widget &w);
-    /// Clears the view
-    MainView &clear();
-    DECLARE_STYLES(MainView)
+    /// A measured text. Lines after the first start at the byte offsets in breaks
+    struct Metrics {
+        int width = 0;
+        int height = 0;
+        std::vector<uint32_t> breaks;
+    };
+
+  private:
+    struct Key {
+        /// Hash of all the fields. index_ is keyed by it, so lookups don't copy the text
+        size_t hash;
+        std::string text;
+        Font font;
+        int max_width;
+
+        bool matches(const std::string &t, const Font &f, int w) const {
+            return f.face == font.face && f.size == font.size && f.bold == font.bold &&
+                   f.italic == font.italic && w == max_width && t == text;
+        }
+    };
+    /// Most recently used first
+    using Lru = std::list<std::pair<Key, Metrics>>;
+
+    static inline Lru lru_;
+    /// Entries by hash. An entry colliding with the one looked up is replaced by it
+    static inline std::unordered_map<size_t, Lru::iterator> index_;
+
+    static size_t hash(const std::string &text, const Font &font, int max_width) {
+        auto fields = (uint64_t)font.face << 40 ^ (uint64_t)font.size << 20 ^
+                      (uint64_t)max_width << 2 ^ (uint64_t)font.bold << 1 ^ font.italic;
+        return std::hash<std::string>()(text) ^ (size_t)(fields * 0x9e3779b97f4a7c15ull);
+    }
+    static inline size_t capacity_ = 4096;
+    static inline size_t hits_ = 0;
+    static inline size_t misses_ = 0;
+
+    static void evict() {
+        while (lru_.size() > capacity_) {
+            index_.erase(lru_.back().first.hash);
+            lru_.pop_back();
+        }
+    }
+
+  public:
+    /// Gets text's metrics in font, wrapped at max_width unless it's 0, shaping it on a miss
+    static const Metrics &measure(const std::string &text, const Font &font, int max_width = 0) {
+        auto h = hash(text, font, max_width);
+        auto it = index_.find(h);
+        if (it != index_.end() && it->second->first.matches(text, font, max_width)) {
+            hits_++;
+#ifdef FLOUI_STATS
+            stats().text_cache.hits++;
+#endif
+            lru_.splice(lru_.begin(), lru_, it->second);
+            return it->second->second;
+        }
+        misses_++;
+#ifdef FLOUI_STATS
+        auto start = std::chrono::steady_clock::now();
+#endif
+        auto metrics = shape(text, font, max_width);
+#ifdef FLOUI_STATS
+        auto &s = stats().text_cache;
+        s.misses++;
+        s.miss_ns += static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                               std::chrono::steady_clock::now() - start)
+                                               .count());
+#endif
+        if (it != index_.end()) {
+            lru_.erase(it->second);
+            index_.erase(it);
+        }
+        lru_.emplace_front(Key{h, text, font, max_width}, std::move(metrics));
+        index_.emplace(h, lru_.begin());
+        evict();
+        return lru_.front().second;
+    }
+    /// Cuts text to the part of its first line which fits in max_width, ending it with "..." if
+    /// anything was cut. Shares the metrics layout uses at that width
+    static std::string truncate(const std::string &text, const Font &font, int max_width) {
+        auto &m = measure(text, font, max_width);
+        if (m.breaks.empty())
+            return text;
+        auto end = m.breaks.front();
+        while (end > 0 && (text[end - 1] == ' ' || text[end - 1] == '\n'))
+            end--;
+        return text.substr(0, end) + "...";
+    }
+    /// Drops the entries of a face, after it's redefined
+    static void invalidate(int face) {
+        for (auto it = lru_.begin(); it != lru_.end();) {
+            if (it->first.font.face == face) {
+                index_.erase(it->first.hash);
+                it = lru_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+    static void clear() {
+        lru_.clear();
+        index_.clear();
+        hits_ = misses_ = 0;
+    }
+    /// Sets how many entries are kept, evicting the least recently used ones over it
+    static void capacity(size_t n) {
+        capacity_ = n;
+        evict();
+    }
+    static size_t size() { return lru_.size(); }
+    static size_t hits() { return hits_; }
+    static size_t misses() { return misses_; }
+
+    /// Breaks text into lines at newlines, and at spaces before max_width unless it's 0, given
+    /// the width of a run of bytes. For backends' shape
+    template <typename Width>
+    static Metrics wrap(const std::string &text, int max_width, int line_height, Width width) {
+        Metrics m;
+        auto line = [&](size_t begin, size_t end) {
+            m.width = std::max(m.width, width(text.data() + begin, (int)(end - begin)));
+            m.height += line_height;
+        };
+        size_t begin = 0;
+        while (true) {
+            auto newline = std::min(text.find('\n', begin), text.size());
+            auto end = newline;
+            if (max_width > 0) {
+                // The longest run of whole words which fits, or the first word if none does
+                size_t fits = begin, next = begin;
+                while (next < newline) {
+                    auto space = std::min(text.find(' ', next + 1), newline);
+                    if (fits > begin && width(text.data() + begin, (int)(space - begin)) > max_width)
+                        break;
+                    fits = space;
+                    next = space;
+                }
+                end = fits;
+            }
+            line(begin, end);
+            if (end < newline) {
+                begin = end + 1;
+            } else if (newline < text.size()) {
+                begin = newline + 1;
+            } else {
+                break;
+            }
+            m.breaks.push_back((uint32_t)begin);
+        }
+        return m;
+    }
+
+    /// Measures text in font, wrapped at max_width unless it's 0
+    static Metrics shape(const std::string &text, const Font &font, int max_width);
 };
 
-class VStack : public Widget {
+/// A set of style properties, built once and applied with a widget's style(). Applying a style
+/// interns it, so widgets given equal styles share one copy, and backends apply its properties in
+/// one native operation. Properties which a widget doesn't have, like the font of a Spacer, are
+/// ignored for it
+class Style {
   public:
-    explicit VStack(void *v);
-    explicit VStack(std::initializer_list<Widget> l);
-    /// Sets the spacing between items
-    VStack &spacing(int val);
-    /// Add a widget
-    VStack &add(const Widget &w);
-    /// Remove a widget
-    VStack &remove(const Widget &w);
-    /// Clears the view
-    VStack &clear();
-    DECLARE_STYLES(VStack)
+    enum class Align : uint8_t { Left, Center, Right };
+    enum class FontStyle : uint8_t { Normal, Bold, Italic };
+    /// The properties a style sets, one bit each
+    enum Field : uint8_t {
+        Background = 1,
+        Foreground = 2,
+        Fontsize = 4,
+        Font = 8,
+        Alignment = 16,
+    };
+
+  private:
+    uint32_t background_ = 0;
+    uint32_t foreground_ = 0;
+    int fontsize_ = 0;
+    uint8_t fields_ = 0;
+    FontStyle font_ = FontStyle::Normal;
+    Align align_ = Align::Left;
+    /// The interned copy, as of the generation of interned styles, so applying a style again
+    /// skips the lookup
+    mutable const Style *interned_copy_ = nullptr;
+    mutable uint32_t generation_ = 0;
+    static inline uint32_t interned_generation_ = 1;
+
+    struct Hash {
+        size_t operator()(const Style &s) const {
+            auto h = (uint64_t)s.background_ << 32 | s.foreground_;
+            auto rest = (uint64_t)s.fontsize_ << 24 | (uint64_t)s.fields_ << 16 |
+                        (uint64_t)s.font_ << 8 | (uint64_t)s.align_;
+            return std::hash<uint64_t>()(h ^ rest * 0x9e3779b97f4a7c15ull);
+        }
+    };
+    /// Interned styles, whose elements never move
+    static std::unordered_set<Style, Hash> &interned_() {
+        static std::unordered_set<Style, Hash> styles;
+        return styles;
+    }
+    /// The interned style each view was last given
+    static inline std::unordered_map<void *, const Style *> applied_{};
+
+    Style &set(Field f) {
+        fields_ |= f;
+        interned_copy_ = nullptr;
+        return *this;
+    }
+
+  public:
+    Style &background(uint32_t col) {
+        background_ = col;
+        return set(Background);
+    }
+    Style &foreground(uint32_t col) {
+        foreground_ = col;
+        return set(Foreground);
+    }
+    Style &fontsize(int size) {
+        fontsize_ = size;
+        return set(Fontsize);
+    }
+    Style &bold() {
+        font_ = FontStyle::Bold;
+        return set(Font);
+    }
+    Style &italic() {
+        font_ = FontStyle::Italic;
+        return set(Font);
+    }
+    Style &normal() {
+        font_ = FontStyle::Normal;
+        return set(Font);
+    }
+    Style &center() {
+        align_ = Align::Center;
+        return set(Alignment);
+    }
+    Style &left() {
+        align_ = Align::Left;
+        return set(Alignment);
+    }
+    Style &right() {
+        align_ = Align::Right;
+        return set(Alignment);
+    }
+    /// Whether the style sets f
+    bool has(Field f) const { return fields_ & f; }
+    uint8_t fields() const { return fields_; }
+    uint32_t background() const { return background_; }
+    uint32_t foreground() const { return foreground_; }
+    int fontsize() const { return fontsize_; }
+    FontStyle font() const { return font_; }
+    Align align() const { return align_; }
+    /// Styles are equal when they set the same properties to the same values
+    bool operator==(const Style &o) const {
+        return fields_ == o.fields_ && background_ == o.background_ &&
+               foreground_ == o.foreground_ && fontsize_ == o.fontsize_ && font_ == o.font_ &&
+               align_ == o.align_;
+    }
+    bool operator!=(const Style &o) const { return !(*this == o); }
+
+    /// Gets the interned copy of the style, which lives until reset
+    const Style &intern() const {
+        if (!interned_copy_ || generation_ != interned_generation_) {
+            interned_copy_ = &*interned_().insert(*this).first;
+            generation_ = interned_generation_;
+        }
+        return *interned_copy_;
+    }
+    /// Number of distinct styles interned
+    static size_t interned() { return interned_().size(); }
+    /// Applies s to view. The write is batched and elided like other property writes, elision
+    /// comparing the interned style, so restyling a widget with the style it has is skipped. The
+    /// widget's own setters don't reset that, so call FlouiViewController::invalidate(view,
+    /// Prop::Style) after changing its font or alignment directly
+    static void apply(void *view, const Style &s);
+    /// Gets the interned style view was last given, or null
+    static const Style *of(void *view) {
+        auto it = applied_.find(view);
+        return it == applied_.end() ? nullptr : it->second;
+    }
+    /// Forgets view, for when it's torn down
+    static void forget(void *view) { applied_.erase(view); }
+    /// Forgets every view and interned style. Styles obtained from intern are left dangling, so
+    /// like headless::reset, this is only meant between benchmark runs or tests
+    static void reset() {
+        applied_.clear();
+        interned_().clear();
+        interned_generation_++;
+    }
+
+    /// Sets the properties s has on view, in one native operation where the platform allows
+    static void show(void *view, const Style &s);
 };
 
-class HStack : public Widget {
+#define DECLARE_STYLES(widget)                                                                     \
+    widget &background(uint32_t col);                                                              \
+    widget &id(Id val);                                                                            \
+    widget &size(int w, int h);                                                                    \
+    widget &grow(float factor) {                                                                   \
+        Layout::grow(view, factor);                                                                \
+        return *this;                                                                              \
+    }                                                                                              \
+    widget &shrink(float factor) {                                                                 \
+        Layout::shrink(view, factor);                                                              \
+        return *this;                                                                              \
+    }                                                                                              \
+    widget &padding(int val) {                                                                     \
+        Layout::padding(view, val);                                                                \
+        return *this;                                                                              \
+    }                                                                                              \
+    widget &style(const Style &s) {                                                                \
+        Style::apply(view, s);                                                                     \
+        return *this;                                                                              \
+    }
+
+class Widget {
+  protected:
+    /// Keeps a registry of widgets assigned an ID
+    static inline IdRegistry widget_map{};
+    /// A non-owning pointer of UIView on iOS and View (jobject) on Android
+    void *view = nullptr;
+
   public:
-    explicit HStack(void *v);
-    explicit HStack(std::initializer_list<Widget> l);
-    /// Sets the spacing between items
-    HStack &spacing(int val);
-    /// Add a widget
-    HStack &add(const Widget &w);
-    /// Remove a widget
-    HStack &remove(const Widget &w);
-    /// Clears the view
-    HStack &clear();
-    DECLARE_STYLES(HStack)
+    explicit Widget(void *v);
+    /// Gets the inner pointer
+    void *inner() const;
+    /// Gets back the Widget by its ID. Unknown IDs are logged and give a Widget around nullptr,
+    /// which must not be used: its setters and getters dereference the view. Check has_id first
+    /// when the ID may not be assigned
+    template <typename T, typename = std::enable_if_t<std::is_base_of_v<Widget, T>>>
+    static T from_id(Id v) {
+        return T{widget_map.find(v)};
+    }
+    /// Checks whether a widget was assigned the ID
+    static bool has_id(Id v) { return widget_map.contains(v); }
+    /// Forgets the ID once view is discarded, unless another view has taken it since
+    static void forget_id(Id v, void *view) { widget_map.erase(v, view); }
+    /// Destroys a view which floui made and which was taken out of its parent, along with the
+    /// views under it, calling discard for each. Where Java owns the views, floui's reference is
+    /// released and Java collects them. Defined by each backend
+    static void destroy(void *view);
+    /// Drops what floui keeps for a view which is about to be destroyed: its IDs, cached and
+    /// queued writes, async work, bindings, style, image, layout node and list or lazy stack
+    static void discard(void *view);
+    DECLARE_STYLES(Widget)
 };
 
-class ImageView : public Widget {
+/// Whether Ws can be passed as the children of a W: widgets, other than a single W, which is
+/// copied instead
+template <typename W, typename... Ws>
+inline constexpr bool is_children_v =
+    (std::is_base_of_v<Widget, std::decay_t<Ws>> && ...) &&
+    !(sizeof...(Ws) == 1 && (std::is_same_v<std::decay_t<Ws>, W> && ...));
+
+/// Gathers the views of a range of widgets, into a buffer reused by every call
+template <typename It>
+const std::vector<void *> &gather_views(It first, It last) {
+    static std::vector<void *> views;
+    views.clear();
+    for (; first != last; ++first)
+        views.push_back((*first).inner());
+    return views;
+}
+
+/// The bulk children management of containers, which adds many children with one native
+/// mutation, and one relayout, instead of one per child:
+/// - add(first, last) and add_all(widgets) append a range of widgets, like generated rows
+/// - replace_children(widgets) replaces the children with widgets
+/// - splice(views, replace) is what they call, defined by each backend
+#define DECLARE_CHILDREN(widget)                                                                   \
+    template <typename It>                                                                         \
+    widget &add(It first, It last) {                                                               \
+        return splice(gather_views(first, last), false);                                           \
+    }                                                                                              \
+    template <typename R>                                                                          \
+    widget &add_all(const R &widgets) {                                                            \
+        return add(std::begin(widgets), std::end(widgets));                                        \
+    }                                                                                              \
+    widget &add_all(std::initializer_list<Widget> widgets) {                                       \
+        return add(widgets.begin(), widgets.end());                                                \
+    }                                                                                              \
+    template <typename R>                                                                          \
+    widget &replace_children(const R &widgets) {                                                   \
+        return splice(gather_views(std::begin(widgets), std::end(widgets)), true);                 \
+    }                                                                                              \
+    widget &replace_children(std::initializer_list<Widget> widgets) {                              \
+        return splice(gather_views(widgets.begin(), widgets.end()), true);                         \
+    }                                                                                              \
+    widget &splice(const std::vector<void *> &views, bool replace);
+
+inline int FlouiViewController::add_callback(Action &&f) { return actions.add(std::move(f)); }
+
+inline void FlouiViewController::handle_event(int slot, void *view) {
+    if (slot < 0 || static_cast<size_t>(slot) >= actions.size())
+        return;
+    FLOUI_ENTRY("callback");
+    if (eliding_)
+        invalidate(view);
+    auto w = Widget(view);
+    auto outer_slot = event_slot_;
+    auto outer_view = event_view_;
+    event_slot_ = slot;
+    event_view_ = view;
+    {
+        Transaction t;
+        actions.invoke(slot, w);
+    }
+    event_slot_ = outer_slot;
+    event_view_ = outer_view;
+    flush();
+    drain();
+}
+
+inline size_t FlouiViewController::drain() {
+    if (!posted_.load(std::memory_order_relaxed))
+        return 0;
+    FLOUI_ENTRY("drain");
+    auto task = posted_.exchange(nullptr, std::memory_order_acquire);
+    Posted *ordered = nullptr;
+    while (task) {
+        auto next = task->next;
+        task->next = ordered;
+        ordered = task;
+        task = next;
+    }
+    size_t n = 0;
+    {
+        Transaction t;
+        while (ordered) {
+            std::unique_ptr<Posted> done(ordered);
+            ordered = ordered->next;
+            done->f();
+            n++;
+        }
+    }
+    flush();
+    return n;
+}
+
+inline void post(std::function<void()> f) {
+    auto task = new FlouiViewController::Posted{std::move(f)};
+    FlouiViewController::push(task, task);
+}
+
+inline void post_batch(std::vector<std::function<void()>> fs) {
+    if (fs.empty())
+        return;
+    // The stack is reversed on drain, so the chain is linked last to first
+    FlouiViewController::Posted *first = nullptr, *last = nullptr;
+    for (auto &f : fs) {
+        first = new FlouiViewController::Posted{std::move(f), first};
+        if (!last)
+            last = first;
+    }
+    FlouiViewController::push(first, last);
+}
+
+/// A pool of worker threads running jobs off the UI thread, in the order they're queued. Threads
+/// are started on first use, one per core, with at least 2
+class Workers {
+    static inline std::mutex mutex_;
+    static inline std::condition_variable ready_;
+    static inline std::deque<std::function<void()>> jobs_;
+    static inline std::vector<std::thread> threads_;
+    static inline bool stopping_ = false;
+
+    /// Joins the threads before threads_ is destroyed
+    static inline struct Stopper {
+        ~Stopper() { Workers::stop(); }
+    } stopper_{};
+
+    static void work() {
+        for (;;) {
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                ready_.wait(lock, [] { return stopping_ || !jobs_.empty(); });
+                if (jobs_.empty())
+                    return;
+                job = std::move(jobs_.front());
+                jobs_.pop_front();
+            }
+            job();
+        }
+    }
+
   public:
-    explicit ImageView(void *v);
-    /// Creates an empty image view
-    ImageView();
-    /// Creates an image from a resource
-    explicit ImageView(const std::string &path);
-    /// Sets the image
-    ImageView &image(const std::string &path);
-    DECLARE_STYLES(ImageView)
+    /// Queues job, which mustn't touch widgets. Results go back to the UI thread through post
+    static void run(std::function<void()> job) {
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            if (threads_.empty()) {
+                stopping_ = false;
+                auto n = std::max(2u, std::thread::hardware_concurrency());
+                for (unsigned i = 0; i < n; i++)
+                    threads_.emplace_back(work);
+            }
+            jobs_.push_back(std::move(job));
+        }
+        ready_.notify_one();
+    }
+
+    /// Runs the queued jobs and joins the threads, which the next run restarts
+    static void stop() {
+        std::vector<std::thread> threads;
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            stopping_ = true;
+            threads.swap(threads_);
+        }
+        ready_.notify_all();
+        for (auto &t : threads)
+            t.join();
+    }
 };
 
-class WebView : public Widget {
+#ifdef FLOUI_COROUTINES
+/// The return type of coroutine actions. A task starts right away, on the UI thread, and its
+/// frame is freed once it finishes. If the event's callback is released or its view cancelled
+/// while the task is suspended, it's destroyed instead of resumed. Since the frame outlives the
+/// event, take the widget by value:
+/// Button("Load").action([](Widget) -> task { auto s = co_await background(load); ... })
+class task {
   public:
-    explicit WebView(void *v);
-    WebView();
-    WebView &load_file_url(const std::string &local_path);
-    WebView &load_http_url(const std::string &local_path);
-    WebView &load_url(const std::string &url);
-    WebView &load_html(const std::string &html);
-    DECLARE_STYLES(WebView)
+    struct promise_type : FlouiViewController::Inflight {
+        task get_return_object() { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() {
+            floui_log("floui: unhandled exception in a task");
+            std::terminate();
+        }
+    };
 };
 
-class ScrollView : public Widget {
+/// Awaits fn run on a Workers thread, giving its result back on the UI thread
+template <typename F, typename R = std::invoke_result_t<F &>>
+class BackgroundAwaiter {
+    struct Empty {};
+    using Result = std::conditional_t<std::is_void_v<R>, Empty, std::optional<R>>;
+
+    F fn_;
+    Result result_;
+
   public:
-    explicit ScrollView(void *v);
-    ScrollView(const Widget &w);
-    DECLARE_STYLES(ScrollView)
+    explicit BackgroundAwaiter(F fn) : fn_(std::move(fn)) {}
+    bool await_ready() const { return false; }
+    void await_suspend(std::coroutine_handle<task::promise_type> h) {
+        Workers::run([this, h] {
+            if constexpr (std::is_void_v<R>)
+                fn_();
+            else
+                result_.emplace(fn_());
+            post([h] {
+                if (h.promise().cancelled())
+                    h.destroy();
+                else
+                    h.resume();
+            });
+        });
+    }
+    R await_resume() {
+        if constexpr (!std::is_void_v<R>)
+            return std::move(*result_);
+    }
 };
-} // namespace floui
 
-#ifdef FLOUI_IMPL
+/// Runs fn off the UI thread: co_await background(fn) suspends the task, and resumes it on the UI
+/// thread with fn's result
+template <typename F>
+BackgroundAwaiter<F> background(F fn) {
+    return BackgroundAwaiter<F>(std::move(fn));
+}
+#endif // FLOUI_COROUTINES
+
+/// A decoded image in the backend's native form, an Fl_RGB_Image with FLTK
+struct Image {
+    void *native = nullptr;
+    int width = 0;
+    int height = 0;
+    /// Memory taken by the pixels, counted against the Images budget
+    size_t bytes = 0;
+};
+
+/// Loads the images of ImageViews off the UI thread. A load starts on the next drain, once the
+/// view has been sized, and decodes the image on the Workers pool, downsampled to fit the view.
+/// Decoded images are kept in an LRU cache keyed by path and size, up to a budget of bytes, and
+/// views showing the same image at the same size share it. Until its image is ready, a view shows
+/// the placeholder. Only touched on the UI thread, except for decode.
+/// Backends which load images this way implement decode, release, show and target, and call load
+/// from ImageView. The others leave them undefined
+class Images {
+  public:
+    using Ref = std::shared_ptr<const Image>;
+
+  private:
+    struct Key {
+        std::string path;
+        int width;
+        int height;
+        bool operator==(const Key &o) const {
+            return width == o.width && height == o.height && path == o.path;
+        }
+    };
+    struct KeyHash {
+        size_t operator()(const Key &k) const {
+            return std::hash<std::string>()(k.path) ^
+                   (((size_t)k.width << 16 | (size_t)k.height) * 0x9e3779b97f4a7c15ull);
+        }
+    };
+    /// Most recently used first
+    using Lru = std::list<std::pair<Key, Ref>>;
+
+    static inline Lru lru_;
+    static inline std::unordered_map<Key, Lru::iterator, KeyHash> cached_;
+    /// The views waiting on each decode in flight
+    static inline std::unordered_map<Key, std::vector<void *>, KeyHash> decoding_;
+    /// The image each view asked for last, with a size of -1 until its load starts
+    static inline std::unordered_map<void *, Key> wanted_;
+    /// Views whose load starts on the next drain
+    static inline std::vector<void *> queued_;
+    /// Keeps the images views show alive once they're evicted
+    static inline std::unordered_map<void *, Ref> shown_;
+    static inline Ref placeholder_;
+    static inline size_t budget_ = 32 << 20;
+    static inline size_t bytes_ = 0;
+    static inline size_t hits_ = 0;
+    static inline size_t misses_ = 0;
+    static inline size_t decodes_ = 0;
+    /// Bumped by reset, so the decodes started before are dropped
+    static inline unsigned generation_ = 0;
+
+    static Ref wrap(const Image &image) {
+        if (!image.native)
+            return nullptr;
+        return Ref(new Image(image), [](const Image *i) {
+            release(*i);
+            delete i;
+        });
+    }
+
+    static void display(void *view, Ref image) {
+        show(view, image.get());
+        if (image)
+            shown_[view] = std::move(image);
+        else
+            shown_.erase(view);
+    }
+
+    static void evict() {
+        // The most recent image stays, even over budget
+        while (bytes_ > budget_ && lru_.size() > 1) {
+            bytes_ -= lru_.back().second->bytes;
+            cached_.erase(lru_.back().first);
+            lru_.pop_back();
+        }
+    }
+
+    static void start() {
+        FLOUI_ENTRY("Images::start");
+        auto queued = std::move(queued_);
+        queued_.clear();
+        for (auto view : queued) {
+            auto it = wanted_.find(view);
+            if (it == wanted_.end() || it->second.width >= 0)
+                continue;
+            auto &key = it->second;
+            target(view, key.width, key.height);
+            key.width = std::max(0, key.width);
+            key.height = std::max(0, key.height);
+            auto hit = cached_.find(key);
+            if (hit != cached_.end()) {
+                hits_++;
+                lru_.splice(lru_.begin(), lru_, hit->second);
+                display(view, hit->second->second);
+                continue;
+            }
+            misses_++;
+            auto &waiting = decoding_[key];
+            waiting.push_back(view);
+            if (waiting.size() > 1)
+                continue;
+            decodes_++;
+            Workers::run([key, generation = generation_] {
+                auto image = decode(key.path, key.width, key.height);
+                post([key, image, generation] { finish(key, image, generation); });
+            });
+        }
+    }
+
+    static void finish(const Key &key, const Image &image, unsigned generation) {
+        auto ref = wrap(image);
+        if (generation != generation_)
+            return;
+        auto waiting = std::move(decoding_[key]);
+        decoding_.erase(key);
+        if (!ref) {
+            log_warn("floui: couldn't load the image %s", key.path.c_str());
+            return;
+        }
+        lru_.emplace_front(key, ref);
+        cached_[key] = lru_.begin();
+        bytes_ += ref->bytes;
+        evict();
+        for (auto view : waiting) {
+            auto it = wanted_.find(view);
+            if (it != wanted_.end() && it->second == key)
+                display(view, ref);
+        }
+    }
+
+  public:
+    /// Shows path in view once it's decoded, and the placeholder meanwhile
+    static void load(void *view, const std::string &path) {
+        wanted_[view] = Key{path, -1, -1};
+        display(view, placeholder_);
+        queued_.push_back(view);
+        if (queued_.size() == 1)
+            post(start);
+    }
+    /// Decodes path at its natural size, right away, to be shown by views whose image isn't ready
+    static void placeholder(const std::string &path) { placeholder_ = wrap(decode(path, 0, 0)); }
+    /// Drops view's image, once it's destroyed
+    static void forget(void *view) {
+        wanted_.erase(view);
+        shown_.erase(view);
+    }
+    /// Sets the bytes the cache may hold, evicting the least recently used images over it
+    static void budget(size_t bytes) {
+        budget_ = bytes;
+        evict();
+    }
+    static size_t budget() { return budget_; }
+    /// Bytes held by the cache
+    static size_t bytes() { return bytes_; }
+    /// Number of images in the cache
+    static size_t size() { return lru_.size(); }
+    /// Loads which found their image in the cache, and those which didn't
+    static size_t hits() { return hits_; }
+    static size_t misses() { return misses_; }
+    /// Number of decodes started, loads of an image being decoded wait for it instead
+    static size_t decodes() { return decodes_; }
+    /// Number of loads and decodes which haven't finished
+    static size_t pending() { return queued_.size() + decoding_.size(); }
+    /// Empties the cache. Images which are shown are only released once their view moves on
+    static void clear() {
+        lru_.clear();
+        cached_.clear();
+        bytes_ = 0;
+    }
+    /// Empties the cache, forgets every view and drops the decodes in flight. The images views
+    /// show are released, so like headless::reset, this is only meant between benchmark runs or
+    /// tests
+    static void reset() {
+        clear();
+        generation_++;
+        decoding_.clear();
+        wanted_.clear();
+        queued_.clear();
+        shown_.clear();
+        hits_ = misses_ = decodes_ = 0;
+    }
+    /// Fits width by height to an image of src_width by src_height, keeping its aspect ratio and
+    /// never upscaling. A width or height of 0 leaves that side unconstrained
+    static void fit(int src_width, int src_height, int &width, int &height) {
+        double scale = 1;
+        if (width > 0)
+            scale = std::min(scale, (double)width / src_width);
+        if (height > 0)
+            scale = std::min(scale, (double)height / src_height);
+        width = std::max(1, (int)(src_width * scale + 0.5));
+        height = std::max(1, (int)(src_height * scale + 0.5));
+    }
+
+    /// Decodes path, downsampled to fit width by height. Runs on a Workers thread, and returns an
+    /// Image with a null native on failure
+    static Image decode(const std::string &path, int width, int height);
+    /// Frees a decoded image, on the UI thread
+    static void release(const Image &image);
+    /// Shows image in view, or nothing if it's null
+    static void show(void *view, const Image *image);
+    /// Gets the size to decode view's image for, 0 for a side which isn't set
+    static void target(void *view, int &width, int &height);
+};
+
+inline void Style::apply(void *view, const Style &s) {
+    FLOUI_ENTRY("Widget::style");
+    auto &interned = s.intern();
+    if (FlouiViewController::defer(view, Prop::Style,
+                                   [p = &interned](Widget &target) { apply(target.inner(), *p); }) ||
+        FlouiViewController::unchanged(view, Prop::Style, (const void *)&interned))
+        return;
+    // The values cached for the properties it sets no longer hold
+    if (s.has(Background))
+        FlouiViewController::invalidate(view, Prop::Background);
+    if (s.has(Foreground))
+        FlouiViewController::invalidate(view, Prop::Foreground);
+    if (s.has(Fontsize))
+        FlouiViewController::invalidate(view, Prop::Fontsize);
+    applied_[view] = &interned;
+    show(view, interned);
+}
+
+inline void FlouiViewController::flush() {
+    if (writes_.empty() || flushing_)
+        return;
+    FLOUI_ENTRY("flush");
+    flushing_ = true;
+    for (auto &[write, apply] : writes_) {
+        // Writes settled by a getter are already applied
+        if (!apply)
+            continue;
+        auto w = Widget(write.view);
+        apply(w);
+    }
+    writes_.clear();
+    pending_.clear();
+    flushing_ = false;
+}
+
+inline void FlouiViewController::discard(void *view) {
+    invalidate(view);
+    cancel(view);
+    for (auto it = pending_.begin(); it != pending_.end();) {
+        if (it->first.view == view) {
+            writes_[it->second].second.reset();
+            it = pending_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+inline void FlouiViewController::settle(void *view, Prop prop) {
+    if (pending_.empty() || flushing_)
+        return;
+    auto it = pending_.find(Write{view, prop});
+    if (it == pending_.end())
+        return;
+    auto apply = std::move(writes_[it->second].second);
+    pending_.erase(it);
+    flushing_ = true;
+    auto w = Widget(view);
+    apply(w);
+    flushing_ = false;
+}
+
+/// Routes a setter's write through batching and write elision, f is called on a W with args
+#define PROPERTY_WRITE(W, prop, f, ...)                                                            \
+    FLOUI_ENTRY(#W "::" #f);                                                                       \
+    if (FlouiViewController::defer(view, Prop::prop,                                               \
+                                   [=](Widget &target) { W(target.inner()).f(__VA_ARGS__); }) ||   \
+        FlouiViewController::unchanged(view, Prop::prop, __VA_ARGS__))                             \
+        return *this;
+
+class Button : public Widget {
+  public:
+    explicit Button(void *b);
+    explicit Button(const std::string &label);
+    /// Makes the button filled on iOS
+    Button &filled();
+    /// Sets the callback of the button
+    Button &action(Action &&f);
+#ifdef __OBJC__
+    Button &action(::id target, SEL s);
+#endif
+    /// Sets the foreground (label) color
+    Button &foreground(uint32_t c);
+    DECLARE_STYLES(Button)
+};
+
+class Toggle : public Widget {
+  public:
+    explicit Toggle(void *b);
+    explicit Toggle(const std::string &label);
+    /// Sets whether a toggle is on or off
+    Toggle &value(bool val);
+    /// Binds whether a toggle is on
+    template <typename R>
+    Toggle &value(const Bound<R> &b);
+    /// Gets the toggle's value
+    bool value();
+    /// Sets the callback of the button
+    Toggle &action(Action &&f);
+#ifdef __OBJC__
+    Toggle &action(::id target, SEL s);
+#endif
+    Toggle &foreground(uint32_t c);
+    DECLARE_STYLES(Toggle)
+};
+
+/// A checkbox widget, iOS doesn't support checkboxes out of the box, only on iOS apps built for
+/// Catalyst (to run on OSX)
+class Check : public Widget {
+  public:
+    explicit Check(void *b);
+    explicit Check(const std::string &label);
+    /// Sets whether the checkbox is on or off
+    Check &value(bool val);
+    /// Binds whether the checkbox is on
+    template <typename R>
+    Check &value(const Bound<R> &b);
+    /// Gets the checks's value
+    bool value();
+    /// Sets the callback of the button
+    Check &action(Action &&f);
+#ifdef __OBJC__
+    Check &action(::id target, SEL s);
+#endif
+    Check &foreground(uint32_t c);
+    DECLARE_STYLES(Check)
+};
+
+class Slider : public Widget {
+  public:
+    explicit Slider(void *b);
+    Slider();
+    Slider &value(double val);
+    /// Binds the slider's value
+    template <typename R>
+    Slider &value(const Bound<R> &b);
+    double value();
+    /// Sets the callback of the button
+    Slider &action(Action &&f);
+#ifdef __OBJC__
+    Slider &action(::id target, SEL s);
+#endif
+    Slider &foreground(uint32_t c);
+    DECLARE_STYLES(Slider)
+};
+
+class Text : public Widget {
+  public:
+    explicit Text(void *b);
+    explicit Text(const std::string &s);
+    /// Creates a text bound to b
+    template <typename R>
+    explicit Text(const Bound<R> &b);
+    /// Centers the text
+    Text &center();
+    /// Changes the alignment to left
+    Text &left();
+    /// Changes the alignment to right
+    Text &right();
+    /// Makes the text bold
+    Text &bold();
+    /// Makes the text italic
+    Text &italic();
+    /// Makes the text normal, which is the default
+    Text &normal();
+    /// Sets the text content
+    Text &text(const std::string &s);
+    /// Binds the text content
+    template <typename R>
+    Text &text(const Bound<R> &b);
+    /// Sets the text's color
+    Text &foreground(uint32_t c);
+    /// Changes the fontsize
+    Text &fontsize(int size);
+    DECLARE_STYLES(Text)
+};
+
+class TextField : public Widget {
+  public:
+    explicit TextField(void *b);
+    TextField();
+    /// Centers the text
+    TextField &center();
+    /// Changes the alignment to left
+    TextField &left();
+    /// Changes the alignment to right
+    TextField &right();
+    /// Sets the text content
+    TextField &text(const std::string &s);
+    /// Binds the text content
+    template <typename R>
+    TextField &text(const Bound<R> &b);
+    /// Sets the text
+    std::string text() const;
+    /// Changes the fontsize
+    TextField &fontsize(int size);
+    /// Sets the text's color
+    TextField &foreground(uint32_t c);
+    DECLARE_STYLES(TextField)
+};
+
+/// An empty widget
+class Spacer : public Widget {
+  public:
+    explicit Spacer(void *b);
+    Spacer();
+    DECLARE_STYLES(Spacer)
+};
+
+/// The main view of your application
+class MainView : public Widget {
+  public:
+    explicit MainView(void *m);
+    MainView(const FlouiViewController &vc, std::initializer_list<Widget> l);
+    /// Creates the main view of children, without braces
+    template <typename... Ws, typename = std::enable_if_t<is_children_v<MainView, Ws...>>>
+    MainView(const FlouiViewController &vc, const Ws &...children)
+        : MainView(vc, {static_cast<const Widget &>(children)...}) {}
+    /// Sets the spacing between items
+    MainView &spacing(int val);
+    /// Sets how items are placed across the stack, stretched by default
+    MainView &align(Layout::Align a) {
+        Layout::align(view, a);
+        return *this;
+    }
+    /// Sets how items are placed along the stack when none grows
+    MainView &justify(Layout::Justify j) {
+        Layout::justify(view, j);
+        return *this;
+    }
+    /// Add a widget
+    MainView &add(const Widget &w);
+    /// Inserts a widget before the child at index, or appends it if index is negative
+    MainView &insert(const Widget &w, int index);
+    /// Remove a widget
+    MainView &remove(const Widget &w);
+    /// Clears the view
+    MainView &clear();
+    DECLARE_CHILDREN(MainView)
+    DECLARE_STYLES(MainView)
+};
+
+class VStack : public Widget {
+  public:
+    explicit VStack(void *v);
+    explicit VStack(std::initializer_list<Widget> l);
+    /// Creates a stack of children, without braces. Widgets are handles, so they're passed by
+    /// reference and only their views are gathered
+    template <typename... Ws, typename = std::enable_if_t<is_children_v<VStack, Ws...>>>
+    explicit VStack(const Ws &...children) : VStack({static_cast<const Widget &>(children)...}) {}
+    /// Sets the spacing between items
+    VStack &spacing(int val);
+    /// Sets how items are placed across the stack, stretched by default
+    VStack &align(Layout::Align a) {
+        Layout::align(view, a);
+        return *this;
+    }
+    /// Sets how items are placed along the stack when none grows
+    VStack &justify(Layout::Justify j) {
+        Layout::justify(view, j);
+        return *this;
+    }
+    /// Add a widget
+    VStack &add(const Widget &w);
+    /// Inserts a widget before the child at index, or appends it if index is negative
+    VStack &insert(const Widget &w, int index);
+    /// Remove a widget
+    VStack &remove(const Widget &w);
+    /// Clears the view
+    VStack &clear();
+    DECLARE_CHILDREN(VStack)
+    DECLARE_STYLES(VStack)
+};
+
+class HStack : public Widget {
+  public:
+    explicit HStack(void *v);
+    explicit HStack(std::initializer_list<Widget> l);
+    /// Creates a stack of children, without braces. Widgets are handles, so they're passed by
+    /// reference and only their views are gathered
+    template <typename... Ws, typename = std::enable_if_t<is_children_v<HStack, Ws...>>>
+    explicit HStack(const Ws &...children) : HStack({static_cast<const Widget &>(children)...}) {}
+    /// Sets the spacing between items
+    HStack &spacing(int val);
+    /// Sets how items are placed across the stack, stretched by default
+    HStack &align(Layout::Align a) {
+        Layout::align(view, a);
+        return *this;
+    }
+    /// Sets how items are placed along the stack when none grows
+    HStack &justify(Layout::Justify j) {
+        Layout::justify(view, j);
+        return *this;
+    }
+    /// Add a widget
+    HStack &add(const Widget &w);
+    /// Inserts a widget before the child at index, or appends it if index is negative
+    HStack &insert(const Widget &w, int index);
+    /// Remove a widget
+    HStack &remove(const Widget &w);
+    /// Clears the view
+    HStack &clear();
+    DECLARE_CHILDREN(HStack)
+    DECLARE_STYLES(HStack)
+};
+
+class ImageView : public Widget {
+  public:
+    explicit ImageView(void *v);
+    /// Creates an empty image view
+    ImageView();
+    /// Creates an image from a resource. With FLTK and the headless backend it's loaded through
+    /// Images, off the UI thread
+    explicit ImageView(const std::string &path);
+    /// Sets the image
+    ImageView &image(const std::string &path);
+    DECLARE_STYLES(ImageView)
+};
+
+class WebView : public Widget {
+  public:
+    explicit WebView(void *v);
+    WebView();
+    WebView &load_file_url(const std::string &local_path);
+    WebView &load_http_url(const std::string &local_path);
+    WebView &load_url(const std::string &url);
+    WebView &load_html(const std::string &html);
+    DECLARE_STYLES(WebView)
+};
+
+class ScrollView : public Widget {
+  public:
+    explicit ScrollView(void *v);
+    ScrollView(const Widget &w);
+    DECLARE_STYLES(ScrollView)
+};
+
+/// A vertical list which only has views for the rows in view, and reuses the views of rows which
+/// scroll out of view for those scrolling in. A RecyclerView on Android, which needs the adapter
+/// glue shown in the README
+/// ```cpp
+/// ListView(1000000, [](int) { return Text(""); },
+///          [](Widget &row, int i) { Text(row.inner()).text(std::to_string(i)); });
+/// ```
+class ListView : public Widget {
+  public:
+    /// Creates a view for a row of type. Rows of the same type reuse each other's views
+    using Create = std::function<Widget(int type)>;
+    /// Fills a row's view with the content of row index, the view is only valid during the call
+    using Bind = std::function<void(Widget &row, int index)>;
+    /// Gives the type of row index
+    using Type = std::function<int(int index)>;
+
+    explicit ListView(void *v);
+    ListView(int count, Create create, Bind bind, Type type = nullptr);
+    /// Changes the number of rows, rebinding those in view
+    ListView &count(int n);
+    /// Sets the height of rows where the platform can't measure them, 40 by default
+    ListView &row_height(int h);
+    /// Sets how many rows beyond each edge of the viewport are kept bound, 2 by default. Android
+    /// manages this itself
+    ListView &overscan(int rows);
+    DECLARE_STYLES(ListView)
+
+    /// Entry points for the platform adapters, list is the list's id. Ids which aren't those of
+    /// a live list, as Java may pass, are reported and give no rows
+    static Widget create_row(int list, int type) {
+        if (!live(list))
+            return Widget(nullptr);
+        return lists_[list].create(type);
+    }
+    static void bind_row(int list, void *row, int index) {
+        if (!live(list))
+            return;
+        auto w = Widget(row);
+        lists_[list].bind(w, index);
+    }
+    static int row_type(int list, int index) {
+        if (!live(list))
+            return 0;
+        auto &l = lists_[list];
+        return l.type ? l.type(index) : 0;
+    }
+    static int row_count(int list) { return live(list) ? lists_[list].count : 0; }
+    /// The id the platform adapters identify the list by
+    int list_id() const { return ids_.at(view); }
+    /// Forgets a list's view once it's destroyed, where the platform lets floui destroy views,
+    /// releasing its functions. Its id is reused by a later list
+    static void forget(void *view) {
+        auto it = ids_.find(view);
+        if (it == ids_.end())
+            return;
+        lists_[it->second] = List{};
+        free_.push_back(it->second);
+        ids_.erase(it);
+    }
+    /// Forgets every list
+    static void reset() {
+        lists_.clear();
+        ids_.clear();
+        free_.clear();
+    }
+
+  protected:
+    struct List {
+        int count = 0;
+        Create create;
+        Bind bind;
+        Type type;
+        int row_height = 40;
+        int overscan = 2;
+    };
+    static inline std::vector<List> lists_{};
+    static inline std::unordered_map<void *, int> ids_{};
+    /// Ids of forgotten lists
+    static inline std::vector<int> free_{};
+
+    static int add_list(int count, Create &&create, Bind &&bind, Type &&type) {
+        auto l = List{count, std::move(create), std::move(bind), std::move(type)};
+        if (!free_.empty()) {
+            auto id = free_.back();
+            free_.pop_back();
+            lists_[id] = std::move(l);
+            return id;
+        }
+        lists_.push_back(std::move(l));
+        return static_cast<int>(lists_.size() - 1);
+    }
+    /// Whether list is the id of a list which wasn't forgotten
+    static bool live(int list) {
+        if (list >= 0 && static_cast<size_t>(list) < lists_.size() && lists_[list].create)
+            return true;
+        floui_log("floui: no list has the id %d", list);
+        return false;
+    }
+    List &list() const { return lists_[list_id()]; }
+
+    friend class RowRecycler;
+};
+
+/// Keeps views for the rows of a ListView which are in a viewport, plus overscan, for platforms
+/// without a recycling list. Rows are assumed to all have the list's row height, so the rows in
+/// view are computed rather than measured, and only rows entering or leaving the viewport are
+/// bound or recycled
+class RowRecycler {
+  public:
+    struct Row {
+        int index;
+        int type;
+        Widget view;
+    };
+
+  private:
+    int list_;
+    /// Bound rows, a contiguous range of indices in order
+    std::vector<Row> active_;
+    std::vector<Row> next_;
+    std::unordered_map<int, std::vector<Widget>> pool_;
+    size_t created_ = 0;
+    size_t bound_ = 0;
+
+    template <typename Hide>
+    void recycle(Row &r, Hide &hide) {
+        hide(r.view);
+        pool_[r.type].push_back(r.view);
+    }
+
+    Row take(int index) {
+        auto type = ListView::row_type(list_, index);
+        auto &pool = pool_[type];
+        Widget view(nullptr);
+        if (pool.empty()) {
+            view = ListView::create_row(list_, type);
+            created_++;
+        } else {
+            view = pool.back();
+            pool.pop_back();
+        }
+        ListView::bind_row(list_, view.inner(), index);
+        bound_++;
+        return Row{index, type, view};
+    }
+
+  public:
+    explicit RowRecycler(int list) : list_(list) {}
+
+    /// Binds the rows of a viewport of height, scrolled to offset, then calls place(view, y) for
+    /// every bound row, y being relative to the viewport. Rows leaving the range are passed to
+    /// hide and pooled
+    template <typename Place, typename Hide>
+    void layout(int offset, int height, Place place, Hide hide) {
+        FLOUI_ENTRY("RowRecycler::layout");
+        auto &l = ListView::lists_[list_];
+        auto rh = l.row_height > 0 ? l.row_height : 1;
+        auto first = std::max(0, offset / rh - l.overscan);
+        auto last = std::min(l.count, (offset + height) / rh + 1 + l.overscan);
+        if (last < first)
+            last = first;
+        auto &next = next_;
+        next.clear();
+        for (auto &r : active_) {
+            if (r.index < first || r.index >= last)
+                recycle(r, hide);
+        }
+        // Rows still in range stay bound, they're contiguous so new rows go before or after them
+        auto kept_first = last;
+        auto kept_last = last;
+        for (auto &r : active_) {
+            if (r.index >= first && r.index < last) {
+                if (kept_first == last)
+                    kept_first = r.index;
+                kept_last = r.index + 1;
+            }
+        }
+        for (int i = first; i < kept_first; i++)
+            next.push_back(take(i));
+        for (auto &r : active_) {
+            if (r.index >= first && r.index < last)
+                next.push_back(r);
+        }
+        for (int i = kept_last; i < last; i++)
+            next.push_back(take(i));
+        active_.swap(next);
+        for (auto &r : active_)
+            place(r.view, r.index * rh - offset);
+    }
+
+    /// Recycles every bound row, so the next layout rebinds them, e.g. after the count changes
+    template <typename Hide>
+    void reset(Hide hide) {
+        for (auto &r : active_)
+            recycle(r, hide);
+        active_.clear();
+    }
+
+    int row_height() const { return ListView::lists_[list_].row_height; }
+    /// The full height of the list
+    int content_height() const {
+        auto &l = ListView::lists_[list_];
+        return l.count * l.row_height;
+    }
+    const std::vector<Row> &rows() const { return active_; }
+    /// Calls f with the view of every row, bound or pooled, e.g. to destroy them with the list
+    template <typename F>
+    void each(F f) {
+        for (auto &r : active_)
+            f(r.view);
+        for (auto &[type, views] : pool_)
+            for (auto &v : views)
+                f(v);
+    }
+    /// Row views created and rows bound so far
+    size_t created() const { return created_; }
+    size_t bound() const { return bound_; }
+    /// Views waiting to be reused
+    size_t pooled() const {
+        size_t n = 0;
+        for (auto &[type, views] : pool_)
+            n += views.size();
+        return n;
+    }
+};
+
+inline ListView &ListView::row_height(int h) {
+    list().row_height = h;
+    return *this;
+}
+
+inline ListView &ListView::overscan(int rows) {
+    list().overscan = rows;
+    return *this;
+}
+
+/// A stack whose children are made by a factory only once they're about to scroll into the
+/// viewport of the enclosing ScrollView. The children which exist are a contiguous range, with a
+/// spacer standing in for those before it and one for those after it, sized from an estimated
+/// extent per child
+/// ```cpp
+/// ScrollView(LazyVStack(2000, [](int i) { return Text(std::to_string(i)); }).estimate(30));
+/// ```
+class LazyStack : public Widget {
+  public:
+    /// Makes child index
+    using Factory = std::function<Widget(int index)>;
+
+    explicit LazyStack(void *v) : Widget(v) {}
+    /// Sets the extent of a child along the stack's axis, used to size the spacers, 40 by default
+    LazyStack &estimate(int px) {
+        lazy().estimate = px;
+        return *this;
+    }
+    /// Sets how many children beyond each edge of the viewport are made ahead of time, 2 by
+    /// default
+    LazyStack &overscan(int children) {
+        lazy().overscan = children;
+        return *this;
+    }
+    /// Sets how many children may exist at once. Those furthest from the viewport are evicted
+    /// beyond it, and made again if they come back into view. 0, the default, keeps every child.
+    /// Evicted children are destroyed with the views under them and their callbacks released, so
+    /// the factory has to make new widgets
+    LazyStack &budget(size_t children) {
+        lazy().budget = children;
+        return *this;
+    }
+    /// Sets the viewport extent assumed until the first scroll event, 1000 by default
+    LazyStack &viewport(int px) {
+        lazy().viewport = px;
+        return *this;
+    }
+    /// Makes the children within a viewport of extent scrolled to offset, and evicts those
+    /// beyond the budget. Called when the enclosing ScrollView scrolls, a stack outside of one
+    /// has to be laid out by hand
+    LazyStack &layout(int offset, int extent);
+    /// Children made so far, evicted so far, and existing now
+    size_t made() const { return lazy().made; }
+    size_t evicted() const { return lazy().evicted; }
+    size_t live() const { return lazy().live.size(); }
+
+    /// Whether view is a lazy stack's
+    static bool lazy(void *view) { return stacks_.count(view) != 0; }
+    /// Entry points for the platform's scroll views. A scroll view holding a lazy stack attaches
+    /// it under a key of its choosing, which lays out its first viewport, and reports scrolling
+    /// under that key
+    static void attach(int64_t scroll, void *stack) {
+        scrolls_[scroll] = stack;
+        auto s = LazyStack(stack);
+        s.lazy().scroll = scroll;
+        s.layout(0, s.lazy().viewport);
+    }
+    /// Forgets a stack's view once it's destroyed, where the platform lets floui destroy views,
+    /// releasing the callbacks of its children
+    static void forget(void *view) {
+        auto it = stacks_.find(view);
+        if (it == stacks_.end())
+            return;
+        for (auto &c : it->second.live)
+            for (auto slot : c.slots)
+                FlouiViewController::release_callback(slot);
+        auto scroll = scrolls_.find(it->second.scroll);
+        if (scroll != scrolls_.end() && scroll->second == view)
+            scrolls_.erase(scroll);
+        stacks_.erase(it);
+    }
+    static void scrolled(int64_t scroll, int x, int y, int w, int h) {
+        auto it = scrolls_.find(scroll);
+        if (it == scrolls_.end())
+            return;
+        auto stack = LazyStack(it->second);
+        auto &l = stack.lazy();
+        if (l.vertical)
+            stack.layout(y, h);
+        else
+            stack.layout(x, w);
+    }
+
+  protected:
+    struct Child {
+        Widget view;
+        /// The slots of the callbacks registered while making it
+        std::vector<int> slots;
+    };
+    struct Lazy {
+        Lazy(bool vertical, int count, Factory &&make, Widget lead, Widget trail)
+            : vertical(vertical), count(count), make(std::move(make)), lead(lead), trail(trail) {}
+        bool vertical;
+        int count;
+        Factory make;
+        Widget lead;
+        Widget trail;
+        int estimate = 40;
+        int overscan = 2;
+        size_t budget = 0;
+        int viewport = 1000;
+        /// The key of the scroll view it's attached to
+        int64_t scroll = -1;
+        /// The index of the first child which exists
+        int first = 0;
+        std::vector<Child> live;
+        int lead_px = -1;
+        int trail_px = -1;
+        size_t made = 0;
+        size_t evicted = 0;
+    };
+    static inline std::unordered_map<void *, Lazy> stacks_{};
+    static inline std::unordered_map<int64_t, void *> scrolls_{};
+
+    template <typename S>
+    static void *add_stack(int count, Factory &&make) {
+        auto lead = Spacer();
+        auto trail = Spacer();
+        auto stack = S({lead, trail});
+        stacks_.emplace(stack.inner(), Lazy{std::is_same_v<S, VStack>, count, std::move(make),
+                                            lead, trail});
+        return stack.inner();
+    }
+    Lazy &lazy() const { return stacks_.at(view); }
+
+  private:
+    void insert(Lazy &l, const Widget &w, int index) {
+        if (l.vertical)
+            VStack(view).insert(w, index);
+        else
+            HStack(view).insert(w, index);
+    }
+    void remove(Lazy &l, const Widget &w) {
+        if (l.vertical)
+            VStack(view).remove(w);
+        else
+            HStack(view).remove(w);
+    }
+    /// Makes child index, recording the callbacks it registers
+    static Child make(Lazy &l, int index) {
+        Child c{Widget(nullptr), {}};
+        {
+            FlouiViewController::Recording recording(c.slots);
+            c.view = l.make(index);
+        }
+        l.made++;
+        return c;
+    }
+    /// Takes an evicted child out and destroys it
+    void evict(Lazy &l, Child &c) {
+        remove(l, c.view);
+        for (auto slot : c.slots)
+            FlouiViewController::release_callback(slot);
+        Widget::destroy(c.view.inner());
+        l.evicted++;
+    }
+    static void resize(Lazy &l, Widget &spacer, int &current, int px) {
+        if (px == current)
+            return;
+        current = px;
+        if (l.vertical)
+            spacer.size(0, px);
+        else
+            spacer.size(px, 0);
+    }
+};
+
+/// A LazyStack laid out vertically
+class LazyVStack : public LazyStack {
+  public:
+    explicit LazyVStack(void *v) : LazyStack(v) {}
+    LazyVStack(int count, Factory make) : LazyStack(add_stack<VStack>(count, std::move(make))) {}
+};
+
+/// A LazyStack laid out horizontally
+class LazyHStack : public LazyStack {
+  public:
+    explicit LazyHStack(void *v) : LazyStack(v) {}
+    LazyHStack(int count, Factory make) : LazyStack(add_stack<HStack>(count, std::move(make))) {}
+};
+
+inline LazyStack &LazyStack::layout(int offset, int extent) {
+    FLOUI_ENTRY("LazyStack::layout");
+    auto &l = lazy();
+    auto e = l.estimate > 0 ? l.estimate : 1;
+    auto from = std::min(l.count, std::max(0, offset / e - l.overscan));
+    auto to = std::min(l.count, std::max(from, (offset + extent) / e + 1 + l.overscan));
+    auto &live = l.live;
+    // With a budget, a range out of reach of the existing one replaces it rather than growing it
+    if (l.budget && (to < l.first || from > l.first + (int)live.size())) {
+        for (auto &c : live)
+            evict(l, c);
+        live.clear();
+    }
+    if (live.empty())
+        l.first = from;
+    // Children are inserted between the spacers, the live ones staying where they are
+    if (from < l.first) {
+        std::vector<Child> next;
+        next.reserve(l.first - from + live.size());
+        for (int i = from; i < l.first; i++) {
+            next.push_back(make(l, i));
+            insert(l, next.back().view, 1 + i - from);
+        }
+        for (auto &c : live)
+            next.push_back(std::move(c));
+        live.swap(next);
+        l.first = from;
+    }
+    auto last = l.first + (int)live.size();
+    for (int i = last; i < to; i++) {
+        live.push_back(make(l, i));
+        insert(l, live.back().view, (int)live.size());
+    }
+    if (l.budget) {
+        size_t drop = 0;
+        while (live.size() - drop > l.budget && l.first + (int)drop < from) {
+            evict(l, live[drop]);
+            drop++;
+        }
+        live.erase(live.begin(), live.begin() + drop);
+        l.first += (int)drop;
+        while (live.size() > l.budget && l.first + (int)live.size() > to) {
+            evict(l, live.back());
+            live.pop_back();
+        }
+    }
+    resize(l, l.lead, l.lead_px, l.first * e);
+    resize(l, l.trail, l.trail_px, (l.count - l.first - (int)live.size()) * e);
+    return *this;
+}
+
+inline void Widget::discard(void *view) {
+    widget_map.erase(view);
+    FlouiViewController::discard(view);
+    Effect::forget(view);
+    Style::forget(view);
+    Images::forget(view);
+    Layout::forget(view);
+    ListView::forget(view);
+    LazyStack::forget(view);
+}
+
+/// Binds widget to b, replacing its previous binding, w is the widget's type, f its setter and prop
+/// the property it sets
+#define DEFINE_BINDING(w, f, prop)                                                                 \
+    template <typename R>                                                                          \
+    w &w::f(const Bound<R> &b) {                                                                   \
+        Effect::attach(view, Prop::prop, [v = view, b] { w(v).f(b()); });                          \
+        return *this;                                                                              \
+    }
+
+DEFINE_BINDING(Toggle, value, Value)
+DEFINE_BINDING(Check, value, Value)
+DEFINE_BINDING(Slider, value, Value)
+DEFINE_BINDING(Text, text, Text)
+DEFINE_BINDING(TextField, text, Text)
+
+template <typename R>
+Text::Text(const Bound<R> &b) : Text(std::string()) {
+    text(b);
+}
+
+/// A description of a widget, rendered by a Tree. Nodes are plain values rebuilt on every render,
+/// only the Tree holds native views
+class Node {
+  public:
+    enum class Kind : uint8_t {
+        Text,
+        Button,
+        Toggle,
+        Check,
+        Slider,
+        TextField,
+        Spacer,
+        ImageView,
+        VStack,
+        HStack
+    };
+    enum class Align : uint8_t { Left, Center, Right };
+    enum class Style : uint8_t { Normal, Bold, Italic };
+    /// Bits of Props::set
+    enum Field : uint32_t {
+        FieldText = 1 << 0,
+        FieldValue = 1 << 1,
+        FieldForeground = 1 << 2,
+        FieldBackground = 1 << 3,
+        FieldFontsize = 1 << 4,
+        FieldSize = 1 << 5,
+        FieldSpacing = 1 << 6,
+        FieldAlign = 1 << 7,
+        FieldStyle = 1 << 8,
+        FieldFilled = 1 << 9,
+    };
+
+    /// Properties of a node, those not in set are left to the platform's default
+    struct Props {
+        std::string text;
+        double value = 0;
+        uint32_t foreground = 0;
+        uint32_t background = 0;
+        int fontsize = 0;
+        int w = 0;
+        int h = 0;
+        int spacing = 0;
+        Align align = Align::Left;
+        Style style = Style::Normal;
+        uint32_t set = 0;
+
+        /// The fields which differ from other
+        uint32_t diff(const Props &other) const {
+            uint32_t d = set ^ other.set;
+            auto both = set & other.set;
+            if ((both & FieldText) && text != other.text)
+                d |= FieldText;
+            if ((both & FieldValue) && value != other.value)
+                d |= FieldValue;
+            if ((both & FieldForeground) && foreground != other.foreground)
+                d |= FieldForeground;
+            if ((both & FieldBackground) && background != other.background)
+                d |= FieldBackground;
+            if ((both & FieldFontsize) && fontsize != other.fontsize)
+                d |= FieldFontsize;
+            if ((both & FieldSize) && (w != other.w || h != other.h))
+                d |= FieldSize;
+            if ((both & FieldSpacing) && spacing != other.spacing)
+                d |= FieldSpacing;
+            if ((both & FieldAlign) && align != other.align)
+                d |= FieldAlign;
+            if ((both & FieldStyle) && style != other.style)
+                d |= FieldStyle;
+            return d;
+        }
+    };
+
+    Node(Kind k, std::vector<Node> children = {}) : kind_(k), children_(std::move(children)) {}
+
+    /// Sets the text, label, or image path depending on the kind
+    Node &text(const std::string &s) { return set(FieldText, props_.text, s); }
+    /// Sets a slider's value, or whether a toggle or checkbox is on
+    Node &value(double v) { return set(FieldValue, props_.value, v); }
+    Node &foreground(uint32_t c) { return set(FieldForeground, props_.foreground, c); }
+    Node &background(uint32_t c) { return set(FieldBackground, props_.background, c); }
+    Node &fontsize(int size) { return set(FieldFontsize, props_.fontsize, size); }
+    Node &size(int w, int h) {
+        props_.w = w;
+        return set(FieldSize, props_.h, h);
+    }
+    Node &spacing(int val) { return set(FieldSpacing, props_.spacing, val); }
+    Node &left() { return set(FieldAlign, props_.align, Align::Left); }
+    Node &center() { return set(FieldAlign, props_.align, Align::Center); }
+    Node &right() { return set(FieldAlign, props_.align, Align::Right); }
+    Node &normal() { return set(FieldStyle, props_.style, Style::Normal); }
+    Node &bold() { return set(FieldStyle, props_.style, Style::Bold); }
+    Node &italic() { return set(FieldStyle, props_.style, Style::Italic); }
+    /// Makes a button filled on iOS
+    Node &filled() {
+        props_.set |= FieldFilled;
+        return *this;
+    }
+    /// Sets the callback. A rerender replaces the callback without registering a new one
+    Node &action(Action &&f) {
+        action_ = std::make_shared<Action>(std::move(f));
+        return *this;
+    }
+    /// Registers the native view under id, like Widget::id
+    Node &id(Id val) {
+        id_ = val;
+        return *this;
+    }
+    /// Identifies the node among its siblings, so it keeps its native view when siblings are
+    /// inserted, removed or reordered. Unkeyed nodes are matched by position
+    Node &key(Id k) { return key(k.hash()); }
+    Node &key(uint64_t k) {
+        key_ = k;
+        keyed_ = true;
+        return *this;
+    }
+    /// Adds a child to a VStack or HStack
+    Node &add(Node child) {
+        children_.push_back(std::move(child));
+        return *this;
+    }
+
+    Kind kind() const { return kind_; }
+    const Props &props() const { return props_; }
+
+  private:
+    friend class Tree;
+
+    template <typename T, typename V>
+    Node &set(Field f, T &field, const V &v) {
+        field = v;
+        props_.set |= f;
+        return *this;
+    }
+
+    Kind kind_;
+    Props props_;
+    bool keyed_ = false;
+    uint64_t key_ = 0;
+    std::optional<Id> id_;
+    std::shared_ptr<Action> action_;
+    std::vector<Node> children_;
+};
+
+/// Builders for Nodes, named after the widgets they describe
+namespace node {
+inline Node Text(const std::string &s) { return Node(Node::Kind::Text).text(s); }
+inline Node Button(const std::string &label) { return Node(Node::Kind::Button).text(label); }
+inline Node Toggle(const std::string &label) { return Node(Node::Kind::Toggle).text(label); }
+inline Node Check(const std::string &label) { return Node(Node::Kind::Check).text(label); }
+inline Node Slider() { return Node(Node::Kind::Slider); }
+inline Node TextField() { return Node(Node::Kind::TextField); }
+inline Node Spacer() { return Node(Node::Kind::Spacer); }
+inline Node ImageView(const std::string &path) { return Node(Node::Kind::ImageView).text(path); }
+inline Node VStack(std::vector<Node> children) {
+    return Node(Node::Kind::VStack, std::move(children));
+}
+inline Node HStack(std::vector<Node> children) {
+    return Node(Node::Kind::HStack, std::move(children));
+}
+} // namespace node
+
+/// Native operations a Tree performed
+struct TreeStats {
+    /// Native views constructed
+    size_t created = 0;
+    /// Native views dropped from their parent
+    size_t removed = 0;
+    /// Retained native views detached and added back, to reorder them
+    size_t moved = 0;
+    /// Property setters called on retained views
+    size_t updated = 0;
+};
+
+/// A retained tree of native views. Each render diffs the new description against the previous
+/// one and only creates, removes, moves or restyles the views whose description changed.
+/// ```cpp
+/// auto tree = Tree(main_view);
+/// tree.render(node::VStack({node::Text(std::to_string(val)), node::Button("Incr")}));
+/// ```
+/// Properties which can't be changed in place, like a button's label, or a property which is no
+/// longer set, recreate the view. Removed nodes release their callback slot, which new nodes reuse,
+/// and their ID
+class Tree {
+    struct Mounted {
+        Node::Kind kind;
+        Node::Props props;
+        bool keyed = false;
+        uint64_t key = 0;
+        Widget widget{nullptr};
+        /// The callback the native view dispatches to, replaced on every render
+        std::shared_ptr<std::shared_ptr<Action>> action;
+        /// The dispatch slot of action, released with the view
+        int slot = -1;
+        /// The name of the ID the view was registered under, if any
+        std::string id;
+        std::vector<std::unique_ptr<Mounted>> children;
+    };
+
+    void *parent_;
+    void (*add_)(void *, const Widget &);
+    void (*remove_)(void *, const Widget &);
+    std::unique_ptr<Mounted> root_;
+    TreeStats stats_;
+
+    /// Fields which can be changed on an existing view, anything else recreates it
+    static uint32_t mutable_fields(Node::Kind k) {
+        constexpr uint32_t common = Node::FieldBackground | Node::FieldSize;
+        switch (k) {
+        case Node::Kind::Text:
+            return common | Node::FieldText | Node::FieldForeground | Node::FieldFontsize |
+                   Node::FieldAlign | Node::FieldStyle;
+        case Node::Kind::TextField:
+            return common | Node::FieldText | Node::FieldForeground | Node::FieldFontsize |
+                   Node::FieldAlign;
+        case Node::Kind::Button:
+            return common | Node::FieldForeground;
+        case Node::Kind::Toggle:
+        case Node::Kind::Check:
+        case Node::Kind::Slider:
+            return common | Node::FieldValue | Node::FieldForeground;
+        case Node::Kind::ImageView:
+            return common | Node::FieldText;
+        case Node::Kind::VStack:
+        case Node::Kind::HStack:
+            return common | Node::FieldSpacing;
+        default:
+            return common;
+        }
+    }
+
+    static bool is_stack(Node::Kind k) {
+        return k == Node::Kind::VStack || k == Node::Kind::HStack;
+    }
+
+    static int popcount(uint32_t v) {
+        int n = 0;
+        for (; v; v &= v - 1)
+            n++;
+        return n;
+    }
+
+    static void add_child(const Mounted &m, const Widget &w) {
+        if (m.kind == Node::Kind::VStack)
+            VStack(m.widget.inner()).add(w);
+        else
+            HStack(m.widget.inner()).add(w);
+    }
+
+    static void insert_child(const Mounted &m, const Widget &w, int index) {
+        if (m.kind == Node::Kind::VStack)
+            VStack(m.widget.inner()).insert(w, index);
+        else
+            HStack(m.widget.inner()).insert(w, index);
+    }
+
+    static void remove_child(const Mounted &m, const Widget &w) {
+        if (m.kind == Node::Kind::VStack)
+            VStack(m.widget.inner()).remove(w);
+        else
+            HStack(m.widget.inner()).remove(w);
+    }
+
+    template <typename W>
+    static void apply_common(W w, uint32_t fields, const Node::Props &p) {
+        if (fields & Node::FieldBackground)
+            w.background(p.background);
+        if (fields & Node::FieldSize)
+            w.size(p.w, p.h);
+    }
+
+    template <typename W>
+    static void apply_text(W w, uint32_t fields, const Node::Props &p) {
+        if (fields & Node::FieldText)
+            w.text(p.text);
+        if (fields & Node::FieldForeground)
+            w.foreground(p.foreground);
+        if (fields & Node::FieldFontsize)
+            w.fontsize(p.fontsize);
+        if (fields & Node::FieldAlign) {
+            if (p.align == Node::Align::Left)
+                w.left();
+            else if (p.align == Node::Align::Center)
+                w.center();
+            else
+                w.right();
+        }
+        apply_common(w, fields, p);
+    }
+
+    /// Calls the setters of fields, only those set in p
+    static void apply(const Mounted &m, uint32_t fields, const Node::Props &p) {
+        fields &= p.set;
+        auto v = m.widget.inner();
+        switch (m.kind) {
+        case Node::Kind::Text: {
+            auto t = floui::Text(v);
+            apply_text(t, fields, p);
+            if (fields & Node::FieldStyle) {
+                if (p.style == Node::Style::Normal)
+                    t.normal();
+                else if (p.style == Node::Style::Bold)
+                    t.bold();
+                else
+                    t.italic();
+            }
+            break;
+        }
+        case Node::Kind::TextField:
+            apply_text(floui::TextField(v), fields, p);
+            break;
+        case Node::Kind::Button: {
+            auto b = floui::Button(v);
+            if (fields & Node::FieldForeground)
+                b.foreground(p.foreground);
+            if (fields & Node::FieldFilled)
+                b.filled();
+            apply_common(b, fields, p);
+            break;
+        }
+        case Node::Kind::Toggle: {
+            auto t = floui::Toggle(v);
+            if (fields & Node::FieldValue)
+                t.value(p.value != 0);
+            if (fields & Node::FieldForeground)
+                t.foreground(p.foreground);
+            apply_common(t, fields, p);
+            break;
+        }
+        case Node::Kind::Check: {
+            auto c = floui::Check(v);
+            if (fields & Node::FieldValue)
+                c.value(p.value != 0);
+            if (fields & Node::FieldForeground)
+                c.foreground(p.foreground);
+            apply_common(c, fields, p);
+            break;
+        }
+        case Node::Kind::Slider: {
+            auto s = floui::Slider(v);
+            if (fields & Node::FieldValue)
+                s.value(p.value);
+            if (fields & Node::FieldForeground)
+                s.foreground(p.foreground);
+            apply_common(s, fields, p);
+            break;
+        }
+        case Node::Kind::ImageView: {
+            auto i = floui::ImageView(v);
+            if (fields & Node::FieldText)
+                i.image(p.text);
+            apply_common(i, fields, p);
+            break;
+        }
+        case Node::Kind::VStack: {
+            auto s = floui::VStack(v);
+            if (fields & Node::FieldSpacing)
+                s.spacing(p.spacing);
+            apply_common(s, fields, p);
+            break;
+        }
+        case Node::Kind::HStack: {
+            auto s = floui::HStack(v);
+            if (fields & Node::FieldSpacing)
+                s.spacing(p.spacing);
+            apply_common(s, fields, p);
+            break;
+        }
+        case Node::Kind::Spacer:
+            apply_common(floui::Spacer(v), fields, p);
+            break;
+        }
+    }
+
+    static void *construct(const Node &n) {
+        auto &text = n.props_.text;
+        switch (n.kind_) {
+        case Node::Kind::Text:
+            return floui::Text(text).inner();
+        case Node::Kind::Button:
+            return floui::Button(text).inner();
+        case Node::Kind::Toggle:
+            return floui::Toggle(text).inner();
+        case Node::Kind::Check:
+            return floui::Check(text).inner();
+        case Node::Kind::Slider:
+            return floui::Slider().inner();
+        case Node::Kind::TextField:
+            return floui::TextField().inner();
+        case Node::Kind::ImageView:
+            return floui::ImageView(text).inner();
+        case Node::Kind::VStack:
+            return floui::VStack({}).inner();
+        case Node::Kind::HStack:
+            return floui::HStack({}).inner();
+        default:
+            return floui::Spacer().inner();
+        }
+    }
+
+    /// Whether constructing the kind already applies the text
+    static bool text_in_constructor(Node::Kind k) {
+        return k != Node::Kind::Slider && k != Node::Kind::TextField && k != Node::Kind::Spacer &&
+               !is_stack(k);
+    }
+
+    /// Attaches the node's callback to the view, through a cell which later renders refill
+    static void hook(Mounted &m) {
+        auto cell = m.action;
+        auto v = m.widget.inner();
+        auto f = [cell](Widget &w) {
+            if (*cell && **cell)
+                (**cell)(w);
+        };
+        static std::vector<int> slots;
+        slots.clear();
+        FlouiViewController::Recording recording(slots);
+        switch (m.kind) {
+        case Node::Kind::Button:
+            floui::Button(v).action(std::move(f));
+            break;
+        case Node::Kind::Toggle:
+            floui::Toggle(v).action(std::move(f));
+            break;
+        case Node::Kind::Check:
+            floui::Check(v).action(std::move(f));
+            break;
+        case Node::Kind::Slider:
+            floui::Slider(v).action(std::move(f));
+            break;
+        default:
+            break;
+        }
+        if (!slots.empty())
+            m.slot = slots.back();
+    }
+
+    /// Registers the view under the node's ID, forgetting the ID it had if it changed
+    static void identify(Mounted &m, const Node &n) {
+        if (!n.id_) {
+            if (!m.id.empty())
+                Widget::forget_id(Id(m.id.c_str()), m.widget.inner());
+            m.id.clear();
+            return;
+        }
+        if (m.id != n.id_->name()) {
+            if (!m.id.empty())
+                Widget::forget_id(Id(m.id.c_str()), m.widget.inner());
+            m.id = n.id_->name();
+        }
+        m.widget.id(*n.id_);
+    }
+
+    std::unique_ptr<Mounted> mount(Node &n) {
+        auto m = std::make_unique<Mounted>();
+        m->kind = n.kind_;
+        m->keyed = n.keyed_;
+        m->key = n.key_;
+        m->widget = Widget(construct(n));
+        stats_.created++;
+        auto fields = n.props_.set;
+        if (text_in_constructor(n.kind_))
+            fields &= ~Node::FieldText;
+        apply(*m, fields, n.props_);
+        m->props = std::move(n.props_);
+        if (n.action_) {
+            m->action = std::make_shared<std::shared_ptr<Action>>(std::move(n.action_));
+            hook(*m);
+        }
+        identify(*m, n);
+        if (is_stack(m->kind)) {
+            for (auto &c : n.children_) {
+                m->children.push_back(mount(c));
+                add_child(*m, m->children.back()->widget);
+            }
+        }
+        return m;
+    }
+
+    /// Destroys the view of m, which was taken out of its parent, and those under it. Children
+    /// go first, so every view floui holds is released, also where the platform can't reach the
+    /// views under one
+    static void unmount(Mounted &m) {
+        for (auto &c : m.children)
+            unmount(*c);
+        if (m.action)
+            m.action->reset();
+        if (m.slot >= 0)
+            FlouiViewController::release_callback(m.slot);
+        Widget::destroy(m.widget.inner());
+    }
+
+    /// Takes the view of m out of parent, or out of the container for the root
+    void detach(const Mounted *parent, const Mounted &m) {
+        if (parent)
+            remove_child(*parent, m.widget);
+        else
+            remove_(parent_, m.widget);
+        stats_.removed++;
+    }
+
+    /// Whether n can't be brought about by setting properties on m's view. The new view may be
+    /// given the old one's address, so callers ask this rather than compare views
+    static bool recreates(const Mounted &m, const Node &n) {
+        return m.kind != n.kind_ || (m.props.diff(n.props_) & ~mutable_fields(m.kind)) ||
+               (m.props.set & ~n.props_.set);
+    }
+
+    /// Brings m in line with n, returning the node to use in its place, which is m unless the
+    /// view had to be recreated. A recreated view is taken out of parent and destroyed, the new
+    /// one is left for the caller to attach
+    std::unique_ptr<Mounted> patch(std::unique_ptr<Mounted> m, Node &n, const Mounted *parent) {
+        if (recreates(*m, n)) {
+            detach(parent, *m);
+            unmount(*m);
+            return mount(n);
+        }
+        auto changed = m->props.diff(n.props_);
+        if (changed) {
+            apply(*m, changed, n.props_);
+            stats_.updated += popcount(changed);
+            m->props = std::move(n.props_);
+        }
+        if (n.action_) {
+            if (m->action) {
+                *m->action = std::move(n.action_);
+            } else {
+                m->action = std::make_shared<std::shared_ptr<Action>>(std::move(n.action_));
+                hook(*m);
+            }
+        } else if (m->action) {
+            m->action->reset();
+        }
+        identify(*m, n);
+        if (is_stack(m->kind))
+            reconcile(*m, n.children_);
+        return m;
+    }
+
+    /// Marks the children of next which keep their place: the longest run, in next's order, of
+    /// retained views whose old positions increase. Every other child is moved or inserted
+    static std::vector<bool> in_place(const std::vector<ptrdiff_t> &from) {
+        // tails[k] is the child ending the best run of length k + 1 found so far
+        std::vector<size_t> tails;
+        std::vector<ptrdiff_t> prev(from.size(), -1);
+        for (size_t i = 0; i < from.size(); i++) {
+            if (from[i] < 0)
+                continue;
+            auto it = std::lower_bound(tails.begin(), tails.end(), from[i],
+                                       [&](size_t t, ptrdiff_t f) { return from[t] < f; });
+            if (it != tails.begin())
+                prev[i] = static_cast<ptrdiff_t>(*(it - 1));
+            if (it == tails.end())
+                tails.push_back(i);
+            else
+                *it = i;
+        }
+        std::vector<bool> kept(from.size(), false);
+        if (!tails.empty()) {
+            for (auto i = static_cast<ptrdiff_t>(tails.back()); i >= 0; i = prev[i])
+                kept[i] = true;
+        }
+        return kept;
+    }
+
+    /// Matches the new children with the old by key, or by position for unkeyed ones, then fixes
+    /// up the native order by moving only the retained views outside the longest run already in
+    /// order, so prepending a row inserts one view and moves none
+    void reconcile(Mounted &m, std::vector<Node> &nodes) {
+        auto &old = m.children;
+        std::unordered_map<uint64_t, size_t> keyed;
+        std::vector<size_t> unkeyed;
+        for (size_t i = 0; i < old.size(); i++) {
+            if (old[i]->keyed)
+                keyed.emplace(old[i]->key, i);
+            else
+                unkeyed.push_back(i);
+        }
+        std::vector<std::unique_ptr<Mounted>> next;
+        next.reserve(nodes.size());
+        /// The position in old each child of next came from, or -1 if it's new or was recreated
+        std::vector<ptrdiff_t> from;
+        from.reserve(nodes.size());
+        size_t next_unkeyed = 0;
+        for (auto &n : nodes) {
+            ptrdiff_t i = -1;
+            if (n.keyed_) {
+                auto it = keyed.find(n.key_);
+                if (it != keyed.end()) {
+                    i = static_cast<ptrdiff_t>(it->second);
+                    keyed.erase(it);
+                }
+            } else if (next_unkeyed < unkeyed.size()) {
+                i = static_cast<ptrdiff_t>(unkeyed[next_unkeyed++]);
+            }
+            if (i < 0) {
+                next.push_back(mount(n));
+                from.push_back(-1);
+                continue;
+            }
+            from.push_back(recreates(*old[i], n) ? -1 : i);
+            next.push_back(patch(std::move(old[i]), n, &m));
+        }
+        // Whatever wasn't matched is gone
+        for (auto &o : old) {
+            if (o) {
+                detach(&m, *o);
+                unmount(*o);
+            }
+        }
+        // Retained views are still attached in their old order. Take out those which move, so
+        // the kept ones remain, then insert each other child at its index in turn: everything
+        // before it is in place by then, and only kept views come after it
+        auto kept = in_place(from);
+        for (size_t i = 0; i < next.size(); i++) {
+            if (from[i] >= 0 && !kept[i]) {
+                remove_child(m, next[i]->widget);
+                stats_.moved++;
+            }
+        }
+        for (size_t i = 0; i < next.size(); i++) {
+            if (!kept[i])
+                insert_child(m, next[i]->widget, static_cast<int>(i));
+        }
+        old = std::move(next);
+    }
+
+  public:
+    /// Renders into container, a MainView, VStack or HStack
+    template <typename C, typename = std::enable_if_t<std::is_base_of_v<Widget, C>>>
+    explicit Tree(const C &container)
+        : parent_(container.inner()), add_([](void *p, const Widget &w) { C(p).add(w); }),
+          remove_([](void *p, const Widget &w) { C(p).remove(w); }) {}
+    Tree(const Tree &) = delete;
+    Tree &operator=(const Tree &) = delete;
+
+    /// Reconciles root against the previous render
+    Tree &render(Node root) {
+        if (!root_) {
+            root_ = mount(root);
+            add_(parent_, root_->widget);
+            return *this;
+        }
+        auto recreated = recreates(*root_, root);
+        root_ = patch(std::move(root_), root, nullptr);
+        if (recreated)
+            add_(parent_, root_->widget);
+        return *this;
+    }
+
+    /// The root's native view, null before the first render
+    Widget root() const { return root_ ? root_->widget : Widget(nullptr); }
+
+    /// Native operations performed by all renders so far
+    const TreeStats &stats() const { return stats_; }
+};
+
+#ifdef FLOUI_HEADLESS
+/// The headless backend, selected by defining FLOUI_HEADLESS along with FLOUI_IMPL. Widgets are
+/// plain nodes holding their properties and children, without any windowing system, so floui's
+/// own overhead can be measured, and apps tested, on any host. User input is injected with the
+/// functions below
+namespace headless {
+/// A widget's view, standing in for a UIView or an android.view.View
+struct View {
+    enum class Kind : uint8_t {
+        MainView,
+        Button,
+        Toggle,
+        Check,
+        Slider,
+        Text,
+        TextField,
+        Spacer,
+        VStack,
+        HStack,
+        ImageView,
+        WebView,
+        ScrollView,
+        ListView,
+    };
+    enum class Align : uint8_t { Left, Center, Right };
+
+    Kind kind;
+    View *parent = nullptr;
+    std::vector<View *> children;
+    /// The label, text content, image path, or the url or html loaded
+    std::string text;
+    double value = 0;
+    uint32_t foreground = Color::Black;
+    uint32_t background = 0;
+    int fontsize = 14;
+    int width = 0;
+    int height = 0;
+    int spacing = 0;
+    /// The scroll offset of scroll views and lists
+    int scroll_x = 0;
+    int scroll_y = 0;
+    Align align = Align::Left;
+    bool bold = false;
+    bool italic = false;
+    bool filled = false;
+    /// The callback's dispatch slot, -1 if there's none
+    int slot = -1;
+    /// The image shown by an ImageView, null until it's decoded unless there's a placeholder
+    const Image *image = nullptr;
+    /// The frame given by Layout
+    Layout::Frame frame;
+    /// Its position among the views alive
+    size_t index = 0;
+
+    explicit View(Kind k) : kind(k) {}
+    /// Appends child, taking it from its previous parent
+    void add(View *child) {
+        if (child->parent)
+            child->parent->remove(child);
+        child->parent = this;
+        children.push_back(child);
+    }
+    /// Inserts child before the one at index, or appends it if index is negative or past the end
+    void insert(View *child, int index) {
+        if (child->parent)
+            child->parent->remove(child);
+        child->parent = this;
+        auto at =
+            index < 0 ? children.size() : std::min(static_cast<size_t>(index), children.size());
+        children.insert(children.begin() + at, child);
+    }
+    void remove(View *child) {
+        auto it = std::find(children.begin(), children.end(), child);
+        if (it == children.end())
+            return;
+        child->parent = nullptr;
+        children.erase(it);
+    }
+    void clear() {
+        for (auto child : children)
+            child->parent = nullptr;
+        children.clear();
+    }
+};
+
+/// Gets a widget's view
+inline View &view(const Widget &w) { return *static_cast<View *>(w.inner()); }
+/// Number of views alive
+size_t views();
+/// Destroys every view and releases every callback. Widgets and IDs from before are left
+/// dangling, so this is only meant between benchmark runs or tests
+void reset();
+/// Clicks a button, toggle or check. Toggles and checks flip their value first
+void click(const Widget &w);
+/// Drags a slider to value
+void slide(const Widget &w, double value);
+/// Types into a text field, replacing its text
+void type(const Widget &w, const std::string &text);
+/// Scrolls a scroll view or list to (x, y), with a viewport of width by height
+void scroll(const Widget &w, int x, int y, int width, int height);
+/// The natural size of every image, which decodes stand in for by filling a buffer of the size
+/// it's downsampled to
+constexpr int image_width = 1024;
+constexpr int image_height = 768;
+/// Number of times posts asked for a drain. There's no loop to wake, so FlouiViewController::drain
+/// has to be called instead
+size_t wakes();
+/// Number of calls adding, inserting or removing the children of a MainView or stack, which a
+/// platform's backend would each make natively
+size_t container_calls();
+} // namespace headless
+#endif // FLOUI_HEADLESS
+} // namespace floui
+
+#ifdef FLOUI_IMPL
+
+using namespace floui;
+
+Color::Color(uint32_t col) : c(col) {}
+
+Color::operator uint32_t() const { return c; }
+
+Color::Color(uint8_t r, uint8_t g, uint8_t b, uint8_t a)
+    : c(((r & 0xff) << 24) + ((g & 0xff) << 16) + ((b & 0xff) << 8) + (a & 0xff)) {}
+
+Color Color::rgb(uint8_t r, uint8_t g, uint8_t b, uint8_t a) { return Color(r, g, b, a); }
+
+#ifdef __ANDROID__
+// Android stuff
+#include <jni.h>
+
+Color Color::system_purple() { return Color(0x7f007fff); }
+
+/// Java classes floui instantiates, with their (Context) constructor
+struct JniViewClass {
+    jclass cls = nullptr;
+    jmethodID init = nullptr;
+};
+
+/// Global class refs and method IDs, looked up once instead of on every call
+struct JniCache {
+    JniViewClass button, toggle, check, slider, text, text_field, spacer, linear_layout,
+        image_view, web_view, scroll_view, recycler_view, linear_layout_manager;
+    jclass view = nullptr;
+    jclass layout_params = nullptr;
+    jclass log = nullptr;
+    jclass integer = nullptr;
+    jclass gradient_drawable = nullptr;
+    // java.lang.Object and java.lang.Integer
+    jmethodID toString = nullptr;
+    jmethodID valueOf = nullptr;
+    // android.view.View
+    jmethodID generateViewId = nullptr;
+    jmethodID setId = nullptr;
+    jmethodID getId = nullptr;
+    jmethodID setTag = nullptr;
+    jmethodID setBackgroundColor = nullptr;
+    jmethodID setLayoutParams = nullptr;
+    jmethodID getLayoutParams = nullptr;
+    jmethodID setOnClickListener = nullptr;
+    jmethodID setOnScrollChangeListener = nullptr;
+    // android.view.ViewGroup
+    jmethodID addView = nullptr;
+    jmethodID addViewAt = nullptr;
+    jmethodID removeView = nullptr;
+    jmethodID removeAllViews = nullptr;
+    // android.view.ViewGroup$LayoutParams and android.widget.LinearLayout$LayoutParams
+    jfieldID width = nullptr;
+    jmethodID layout_params_init = nullptr;
+    // android.widget.LinearLayout
+    jmethodID setOrientation = nullptr;
+    jmethodID layout_setGravity = nullptr;
+    jmethodID setDividerDrawable = nullptr;
+    jmethodID setShowDividers = nullptr;
+    // android.graphics.drawable.GradientDrawable
+    jmethodID gradient_drawable_init = nullptr;
+    jmethodID setSize = nullptr;
+    // android.widget.TextView
+    jmethodID setText = nullptr;
+    jmethodID getText = nullptr;
+    jmethodID setTextColor = nullptr;
+    jmethodID setTextSize = nullptr;
+    jmethodID setTypeface = nullptr;
+    jmethodID setGravity = nullptr;
+    jmethodID setTransformationMethod = nullptr;
+    // android.widget.CompoundButton
+    jmethodID setChecked = nullptr;
+    jmethodID isChecked = nullptr;
+    // com.google.android.material.slider.Slider, optional dependency
+    jmethodID slider_setValue = nullptr;
+    jmethodID slider_getValue = nullptr;
+    jmethodID addOnChangeListener = nullptr;
+    // android.widget.ImageView
+    jmethodID setImageResource = nullptr;
+    // android.webkit.WebView
+    jmethodID loadUrl = nullptr;
+    jmethodID loadDataWithBaseURL = nullptr;
+    // androidx.recyclerview.widget.RecyclerView and its Adapter, optional dependency
+    jmethodID setLayoutManager = nullptr;
+    jmethodID setAdapter = nullptr;
+    jmethodID getAdapter = nullptr;
+    jmethodID notifyDataSetChanged = nullptr;
+    // The main activity and android.content.res.Resources
+    jmethodID findViewById = nullptr;
+    jmethodID listAdapter = nullptr;
+    jmethodID onScrollChange = nullptr;
+    jmethodID wake = nullptr;
+    jmethodID applyStyle = nullptr;
+    jmethodID addViews = nullptr;
+    jmethodID watchText = nullptr;
+    jmethodID getResources = nullptr;
+    jmethodID getPackageName = nullptr;
+    jmethodID getIdentifier = nullptr;
+    // android.util.Log
+    jmethodID e = nullptr;
+
+    static jclass find_class(JNIEnv *env, const char *name) {
+        auto local = env->FindClass(name);
+        if (!local) {
+            env->ExceptionClear();
+            return nullptr;
+        }
+        auto global = (jclass)env->NewGlobalRef(local);
+        env->DeleteLocalRef(local);
+        return global;
+    }
+
+    static JniViewClass view_class(JNIEnv *env, const char *name) {
+        JniViewClass k;
+        k.cls = find_class(env, name);
+        if (k.cls)
+            k.init = env->GetMethodID(k.cls, "<init>", "(Landroid/content/Context;)V");
+        return k;
+    }
+
+    void fill(JNIEnv *env, jobject main_activity) {
+        button = view_class(env, "android/widget/Button");
+        toggle = view_class(env, "android/widget/Switch");
+        check = view_class(env, "android/widget/CheckBox");
+        slider = view_class(env, "com/google/android/material/slider/Slider");
+        text = view_class(env, "android/widget/TextView");
+        text_field = view_class(env, "android/widget/EditText");
+        spacer = view_class(env, "android/widget/Space");
+        linear_layout = view_class(env, "android/widget/LinearLayout");
+        image_view = view_class(env, "android/widget/ImageView");
+        web_view = view_class(env, "android/webkit/WebView");
+        scroll_view = view_class(env, "android/widget/ScrollView");
+        recycler_view = view_class(env, "androidx/recyclerview/widget/RecyclerView");
+        linear_layout_manager = view_class(env, "androidx/recyclerview/widget/LinearLayoutManager");
+        view = find_class(env, "android/view/View");
+        layout_params = find_class(env, "android/widget/LinearLayout$LayoutParams");
+        log = find_class(env, "android/util/Log");
+        integer = find_class(env, "java/lang/Integer");
+        gradient_drawable = find_class(env, "android/graphics/drawable/GradientDrawable");
+
+        auto object = env->FindClass("java/lang/Object");
+        toString = env->GetMethodID(object, "toString", "()Ljava/lang/String;");
+        env->DeleteLocalRef(object);
+        valueOf = env->GetStaticMethodID(integer, "valueOf", "(I)Ljava/lang/Integer;");
+
+        generateViewId = env->GetStaticMethodID(view, "generateViewId", "()I");
+        setId = env->GetMethodID(view, "setId", "(I)V");
+        getId = env->GetMethodID(view, "getId", "()I");
+        setTag = env->GetMethodID(view, "setTag", "(Ljava/lang/Object;)V");
+        setBackgroundColor = env->GetMethodID(view, "setBackgroundColor", "(I)V");
+        setLayoutParams = env->GetMethodID(view, "setLayoutParams",
+                                           "(Landroid/view/ViewGroup$LayoutParams;)V");
+        getLayoutParams =
+            env->GetMethodID(view, "getLayoutParams", "()Landroid/view/ViewGroup$LayoutParams;");
+        setOnClickListener = env->GetMethodID(view, "setOnClickListener",
+                                              "(Landroid/view/View$OnClickListener;)V");
+        // API level 23
+        setOnScrollChangeListener = env->GetMethodID(
+            view, "setOnScrollChangeListener", "(Landroid/view/View$OnScrollChangeListener;)V");
+        if (!setOnScrollChangeListener)
+            env->ExceptionClear();
+
+        auto view_group = env->FindClass("android/view/ViewGroup");
+        addView = env->GetMethodID(view_group, "addView", "(Landroid/view/View;)V");
+        addViewAt = env->GetMethodID(view_group, "addView", "(Landroid/view/View;I)V");
+        removeView = env->GetMethodID(view_group, "removeView", "(Landroid/view/View;)V");
+        removeAllViews = env->GetMethodID(view_group, "removeAllViews", "()V");
+        env->DeleteLocalRef(view_group);
+
+        auto group_params = env->FindClass("android/view/ViewGroup$LayoutParams");
+        width = env->GetFieldID(group_params, "width", "I");
+        env->DeleteLocalRef(group_params);
+        layout_params_init = env->GetMethodID(layout_params, "<init>", "(II)V");
+
+        setOrientation = env->GetMethodID(linear_layout.cls, "setOrientation", "(I)V");
+        layout_setGravity = env->GetMethodID(linear_layout.cls, "setGravity", "(I)V");
+        setDividerDrawable = env->GetMethodID(linear_layout.cls, "setDividerDrawable",
+                                              "(Landroid/graphics/drawable/Drawable;)V");
+        setShowDividers = env->GetMethodID(linear_layout.cls, "setShowDividers", "(I)V");
+        gradient_drawable_init = env->GetMethodID(gradient_drawable, "<init>", "()V");
+        setSize = env->GetMethodID(gradient_drawable, "setSize", "(II)V");
+
+        setText = env->GetMethodID(text.cls, "setText", "(Ljava/lang/CharSequence;)V");
+        getText = env->GetMethodID(text.cls, "getText", "()Ljava/lang/CharSequence;");
+        setTextColor = env->GetMethodID(text.cls, "setTextColor", "(I)V");
+        setTextSize = env->GetMethodID(text.cls, "setTextSize", "(F)V");
+        setTypeface = env->GetMethodID(text.cls, "setTypeface", "(Landroid/graphics/Typeface;I)V");
+        setGravity = env->GetMethodID(text.cls, "setGravity", "(I)V");
+        setTransformationMethod = env->GetMethodID(
+            text.cls, "setTransformationMethod", "(Landroid/text/method/TransformationMethod;)V");
+
+        auto compound_button = env->FindClass("android/widget/CompoundButton");
+        setChecked = env->GetMethodID(compound_button, "setChecked", "(Z)V");
+        isChecked = env->GetMethodID(compound_button, "isChecked", "()Z");
+        env->DeleteLocalRef(compound_button);
+
+        if (slider.cls) {
+            slider_setValue = env->GetMethodID(slider.cls, "setValue", "(F)V");
+            slider_getValue = env->GetMethodID(slider.cls, "getValue", "()F");
+            addOnChangeListener =
+                env->GetMethodID(slider.cls, "addOnChangeListener",
+                                 "(Lcom/google/android/material/slider/BaseOnChangeListener;)V");
+        }
+
+        setImageResource = env->GetMethodID(image_view.cls, "setImageResource", "(I)V");
+
+        loadUrl = env->GetMethodID(web_view.cls, "loadUrl", "(Ljava/lang/String;)V");
+        loadDataWithBaseURL =
+            env->GetMethodID(web_view.cls, "loadDataWithBaseURL",
+                             "(Ljava/lang/String;Ljava/lang/String;Ljava/lang/String;Ljava/"
+                             "lang/String;Ljava/lang/String;)V");
+
+        if (recycler_view.cls) {
+            setLayoutManager = env->GetMethodID(
+                recycler_view.cls, "setLayoutManager",
+                "(Landroidx/recyclerview/widget/RecyclerView$LayoutManager;)V");
+            setAdapter = env->GetMethodID(recycler_view.cls, "setAdapter",
+                                          "(Landroidx/recyclerview/widget/RecyclerView$Adapter;)V");
+            getAdapter = env->GetMethodID(recycler_view.cls, "getAdapter",
+                                          "()Landroidx/recyclerview/widget/RecyclerView$Adapter;");
+            auto adapter = env->FindClass("androidx/recyclerview/widget/RecyclerView$Adapter");
+            notifyDataSetChanged = env->GetMethodID(adapter, "notifyDataSetChanged", "()V");
+            env->DeleteLocalRef(adapter);
+        }
+
+        auto activity = env->GetObjectClass(main_activity);
+        findViewById = env->GetMethodID(activity, "findViewById", "(I)Landroid/view/View;");
+        // Only needed by ListView, see the README
+        listAdapter = env->GetMethodID(activity, "listAdapter",
+                                       "(I)Landroidx/recyclerview/widget/RecyclerView$Adapter;");
+        if (!listAdapter)
+            env->ExceptionClear();
+        // Only needed by LazyVStack and LazyHStack, see the README
+        onScrollChange = env->GetMethodID(activity, "onScrollChange", "(Landroid/view/View;IIII)V");
+        if (!onScrollChange)
+            env->ExceptionClear();
+        // Only needed by post, see the README
+        wake = env->GetMethodID(activity, "wake", "()V");
+        if (!wake)
+            env->ExceptionClear();
+        // Optional, Style falls back to a call per property without it, see the README
+        applyStyle = env->GetMethodID(activity, "applyStyle", "(Landroid/view/View;IIIFII)V");
+        if (!applyStyle)
+            env->ExceptionClear();
+        // Optional, bulk children insertion falls back to a call per child without it
+        addViews = env->GetMethodID(activity, "addViews",
+                                    "(Landroid/view/ViewGroup;[Landroid/view/View;Z)V");
+        if (!addViews)
+            env->ExceptionClear();
+        // Optional, TextField text isn't elided without it, see the README
+        watchText = env->GetMethodID(activity, "watchText", "(Landroid/widget/TextView;)V");
+        if (!watchText)
+            env->ExceptionClear();
+        getResources =
+            env->GetMethodID(activity, "getResources", "()Landroid/content/res/Resources;");
+        getPackageName = env->GetMethodID(activity, "getPackageName", "()Ljava/lang/String;");
+        env->DeleteLocalRef(activity);
+        auto resources = env->FindClass("android/content/res/Resources");
+        getIdentifier =
+            env->GetMethodID(resources, "getIdentifier",
+                             "(Ljava/lang/String;Ljava/lang/String;Ljava/lang/String;)I");
+        env->DeleteLocalRef(resources);
+
+        e = env->GetStaticMethodID(log, "e", "(Ljava/lang/String;Ljava/lang/String;)I");
+    }
+};
+
+#ifdef FLOUI_STATS
+/// A JNIEnv counting the calls floui makes through it into Stats::native_calls, which it forwards
+/// to the thread's real JNIEnv. It covers the JNI functions floui uses
+struct CountingEnv {
+    using Table = std::remove_cv_t<std::remove_pointer_t<decltype(JNIEnv::functions)>>;
+
+    JNIEnv env;
+    JNIEnv *real;
+
+    template <typename T, T Table::*F>
+    struct Count;
+    template <typename R, typename... A, R(JNICALL *Table::*F)(JNIEnv *, A...)>
+    struct Count<R(JNICALL *)(JNIEnv *, A...), F> {
+        static R JNICALL call(JNIEnv *env, A... args) {
+            Stats::native_calls++;
+            auto real = reinterpret_cast<CountingEnv *>(env)->real;
+            return (real->functions->*F)(real, args...);
+        }
+    };
+
+    static Table make_table() {
+        Table t{};
+#define FLOUI_COUNT(f) t.f = Count<decltype(t.f), &Table::f>::call;
+        FLOUI_COUNT(FindClass)
+        FLOUI_COUNT(GetObjectClass)
+        FLOUI_COUNT(GetMethodID)
+        FLOUI_COUNT(GetStaticMethodID)
+        FLOUI_COUNT(GetFieldID)
+        FLOUI_COUNT(NewObjectV)
+        FLOUI_COUNT(NewObjectArray)
+        FLOUI_COUNT(SetObjectArrayElement)
+        FLOUI_COUNT(CallObjectMethodV)
+        FLOUI_COUNT(CallBooleanMethodV)
+        FLOUI_COUNT(CallIntMethodV)
+        FLOUI_COUNT(CallFloatMethodV)
+        FLOUI_COUNT(CallVoidMethodV)
+        FLOUI_COUNT(CallStaticObjectMethodV)
+        FLOUI_COUNT(CallStaticIntMethodV)
+        FLOUI_COUNT(CallStaticVoidMethodV)
+        FLOUI_COUNT(GetIntField)
+        FLOUI_COUNT(SetIntField)
+        FLOUI_COUNT(NewStringUTF)
+        FLOUI_COUNT(GetStringUTFChars)
+        FLOUI_COUNT(ReleaseStringUTFChars)
+        FLOUI_COUNT(NewGlobalRef)
+        FLOUI_COUNT(NewWeakGlobalRef)
+        FLOUI_COUNT(NewLocalRef)
+        FLOUI_COUNT(DeleteLocalRef)
+        FLOUI_COUNT(DeleteGlobalRef)
+        FLOUI_COUNT(DeleteWeakGlobalRef)
+        FLOUI_COUNT(PushLocalFrame)
+        FLOUI_COUNT(PopLocalFrame)
+        FLOUI_COUNT(EnsureLocalCapacity)
+        FLOUI_COUNT(IsSameObject)
+        FLOUI_COUNT(IsInstanceOf)
+        FLOUI_COUNT(ExceptionCheck)
+        FLOUI_COUNT(ExceptionClear)
+        FLOUI_COUNT(GetJavaVM)
+#undef FLOUI_COUNT
+        return t;
+    }
+
+    /// Wraps the thread's JNIEnv
+    static JNIEnv *wrap(JNIEnv *real) {
+        static const Table table = make_table();
+        thread_local CountingEnv counting{JNIEnv{&table}, nullptr};
+        counting.real = real;
+        return &counting.env;
+    }
+};
+#endif // FLOUI_STATS
+
+struct FlouiViewControllerImpl {
+    static inline JavaVM *vm = nullptr;
+    static inline jobject main_activity = nullptr;
+    static inline jobject layout = nullptr;
+    /// Maps view ids to dispatch slots, for handle_events
+    static inline std::unordered_map<int, int> slotmap = {};
+    static inline JniCache jni{};
+    static inline bool jni_filled = false;
+    static inline int bulk_depth = 0;
+    static inline int bulk_capacity = 0;
+    static inline int bulk_locals = 0;
+    static inline std::vector<jobject> bulk_views = {};
+
+    FlouiViewControllerImpl(JNIEnv *env, jobject m, jobject layout) {
+        env->GetJavaVM(&vm);
+        FlouiViewControllerImpl::main_activity = env->NewWeakGlobalRef(m);
+        FlouiViewControllerImpl::layout = env->NewWeakGlobalRef(layout);
+        if (!jni_filled) {
+            jni.fill(env, m);
+            jni_filled = true;
+        }
+    }
+
+    /// Converts to the out parameter of AttachCurrentThread, which is JNIEnv ** in the NDK's jni.h
+    /// and void ** in the JDK's
+    struct EnvOut {
+        JNIEnv **env;
+        operator JNIEnv **() const { return env; }
+        operator void **() const { return (void **)env; }
+    };
+
+    /// Attaches threads which aren't Java's, like the log's, detaching them again as they exit
+    static JNIEnv *attach() {
+        struct Detach {
+            ~Detach() { vm->DetachCurrentThread(); }
+        };
+        thread_local Detach detach;
+        (void)detach;
+        JNIEnv *env = nullptr;
+        vm->AttachCurrentThread(EnvOut{&env}, nullptr);
+        return env;
+    }
+
+    static JNIEnv *env() {
+        JNIEnv *env;
+        if (vm->GetEnv((void **)&env, JNI_VERSION_1_6) != JNI_OK)
+            env = attach();
+#ifdef FLOUI_STATS
+        return CountingEnv::wrap(env);
+#else
+        return env;
+#endif
+    }
+};
+
+FlouiViewController::FlouiViewController(void *env, void *m, void *layout)
+    : impl(new FlouiViewControllerImpl((JNIEnv *)env, (jobject)m, (jobject)layout)) {}
+
+static int get_android_id(jobject view);
+
+void FlouiViewController::handle_events(void *view) {
+    auto elem = FlouiViewControllerImpl::slotmap.find(get_android_id((jobject)view));
+    if (elem != FlouiViewControllerImpl::slotmap.end())
+        handle_event(elem->second, view);
+}
+
+/// Called from the posting thread, which env attaches if it's not Java's. MainActivity.wake hands
+/// drainPosts to the main looper
+void FlouiViewController::wake() {
+    if (!FlouiViewControllerImpl::jni.wake) {
+        static std::once_flag warned;
+        std::call_once(warned, [] {
+            floui_log("floui: post needs MainActivity.wake, posts wait for the next event");
+        });
+        return;
+    }
+    auto env = FlouiViewControllerImpl::env();
+    env->CallVoidMethod(FlouiViewControllerImpl::main_activity, FlouiViewControllerImpl::jni.wake);
+}
+
+FlouiViewController::~FlouiViewController() {
+    flush();
+    delete impl;
+}
+
+using c = FlouiViewControllerImpl;
+
+/// Releases a temporary local reference. Inside a BulkScope, temporaries are instead dropped a
+/// whole local frame at a time, once the frame is full
+static void release_local(JNIEnv *env, jobject obj) {
+    if (!c::bulk_depth) {
+        env->DeleteLocalRef(obj);
+        return;
+    }
+    if (++c::bulk_locals >= c::bulk_capacity) {
+        env->PopLocalFrame(nullptr);
+        env->PushLocalFrame(c::bulk_capacity);
+        c::bulk_locals = 0;
+    }
+}
+
+/// Returns the weak global ref floui hands out for a newly created view. Outside of a BulkScope,
+/// the view's local ref keeps it alive until it's added to a parent or the native call returns.
+/// Inside one, a global ref does until the scope ends, so the local can be dropped
+static void *android_wrap_view(JNIEnv *env, jobject view) {
+    auto weak = env->NewWeakGlobalRef(view);
+    if (c::bulk_depth) {
+        c::bulk_views.push_back(env->NewGlobalRef(view));
+        release_local(env, view);
+    }
+    return weak;
+}
+
+BulkScope::BulkScope(int capacity) {
+    if (c::bulk_depth++ == 0) {
+        c::bulk_capacity = capacity;
+        c::bulk_locals = 0;
+        c::env()->PushLocalFrame(capacity);
+    }
+}
+
+BulkScope::~BulkScope() {
+    if (--c::bulk_depth == 0) {
+        auto env = c::env();
+        env->PopLocalFrame(nullptr);
+        for (auto v : c::bulk_views)
+            env->DeleteGlobalRef(v);
+        c::bulk_views.clear();
+    }
+}
+
+static jobject android_new_view(const JniViewClass &klass) {
+    auto env = c::env();
+    auto obj = env->NewObject(klass.cls, klass.init, c::main_activity);
+    auto id = env->CallStaticIntMethod(c::jni.view, c::jni.generateViewId);
+    env->CallVoidMethod(obj, c::jni.setId, id);
+    return obj;
+}
+
+static jobject get_view_by_id(int val) {
+    auto env = c::env();
+    return env->CallObjectMethod(c::main_activity, c::jni.findViewById, val);
+}
+
+int get_android_id(jobject view) {
+    auto env = c::env();
+    return env->CallIntMethod(view, c::jni.getId);
+}
+
+/// Stores a callback's dispatch slot as the view's tag, for handle_event, and maps the view's id
+/// to it, for handle_events
+static void android_set_slot(JNIEnv *env, jobject view, int slot) {
+    auto tag = env->CallStaticObjectMethod(c::jni.integer, c::jni.valueOf, slot);
+    env->CallVoidMethod(view, c::jni.setTag, tag);
+    release_local(env, tag);
+    c::slotmap[get_android_id(view)] = slot;
+}
+
+void floui_log0(const char *s) {
+    auto env = c::env();
+    static auto tag = [env] {
+        auto local = env->NewStringUTF("FlouiApp");
+        auto global = (jstring)env->NewGlobalRef(local);
+        release_local(env, local);
+        return global;
+    }();
+    auto msg = env->NewStringUTF(s);
+    env->CallStaticIntMethod(c::jni.log, c::jni.e, tag, msg);
+    release_local(env, msg);
+}
+
+int floui_log(const char *s) {
+    floui::Log::write<floui::LogLevel::Info>(s);
+    return 0;
+}
+
+static constexpr uint32_t argb2rgba(uint32_t argb) { return (argb << 24) | (argb >> 8); }
+
+#define DEFINE_STYLES(widget)                                                                      \
+    widget &widget::background(uint32_t col) {                                                     \
+        PROPERTY_WRITE(widget, Background, background, col)                                        \
+        auto env = c::env();                                                                       \
+        env->CallVoidMethod((jobject)view, c::jni.setBackgroundColor, argb2rgba(col));             \
+        return *this;                                                                              \
+    }                                                                                              \
+    widget &widget::id(Id val) {                                                                   \
+        widget_map.insert(val, view);                                                              \
+        return *this;                                                                              \
+    }                                                                                              \
+    widget &widget::size(int w, int h) {                                                           \
+        PROPERTY_WRITE(widget, Size, size, w, h)                                                   \
+        auto env = c::env();                                                                       \
+        auto obj = env->NewObject(c::jni.layout_params, c::jni.layout_params_init, w, h);          \
+        env->CallVoidMethod((jobject)view, c::jni.setLayoutParams, obj);                           \
+        release_local(env, obj);                                                                   \
+        return *this;                                                                              \
+    }
+
+Widget::Widget(void *v) : view(v) {}
+
+void *Widget::inner() const { return view; }
+
+DEFINE_STYLES(Widget)
+
+void *Button_init() {
+    auto env = c::env();
+    auto view = android_new_view(c::jni.button);
+    env->CallVoidMethod(view, c::jni.setTransformationMethod, nullptr);
+    return android_wrap_view(env, view);
+}
+
+Button::Button(void *b) : Widget(b) {}
+
+Button::Button(const std::string &label) : Widget(nullptr) {
+    FLOUI_ENTRY("Button::Button");
+    view = Button_init();
+    auto env = c::env();
+    auto s = env->NewStringUTF(label.c_str());
+    env->CallVoidMethod((jobject)view, c::jni.setText, s);
+    release_local(env, s);
+}
+
+Button &Button::foreground(uint32_t c) {
+    PROPERTY_WRITE(Button, Foreground, foreground, c)
+    auto env = c::env();
+    env->CallVoidMethod((jobject)view, c::jni.setTextColor, argb2rgba(c));
+    return *this;
+}
+
+Button &Button::filled() { return *this; }
+
+Button &Button::action(Action &&f) {
+    FLOUI_ENTRY("Button::action");
+    auto env = c::env();
+    auto v = (jobject)view;
+    env->CallVoidMethod(v, c::jni.setOnClickListener, c::main_activity);
+    android_set_slot(env, v, FlouiViewController::add_callback(std::move(f)));
+    return *this;
+}
+
+DEFINE_STYLES(Button)
+
+void *Toggle_init() {
+    auto env = c::env();
+    auto view = android_new_view(c::jni.toggle);
+    env->CallVoidMethod(view, c::jni.setTransformationMethod, nullptr);
+    return android_wrap_view(env, view);
+}
+
+Toggle::Toggle(void *b) : Widget(b) {}
+
+Toggle::Toggle(const std::string &label) : Widget(nullptr) {
+    FLOUI_ENTRY("Toggle::Toggle");
+    view = Toggle_init();
+    auto env = c::env();
+    auto s = env->NewStringUTF(label.c_str());
+    env->CallVoidMethod((jobject)view, c::jni.setText, s);
+    release_local(env, s);
+}
+
+Toggle &Toggle::value(bool val) {
+    PROPERTY_WRITE(Toggle, Value, value, val)
+    auto env = c::env();
+    env->CallVoidMethod((jobject)view, c::jni.setChecked, val);
+    return *this;
+}
+
+bool Toggle::value() {
+    FLOUI_ENTRY("Toggle::value");
+    FlouiViewController::settle(view, Prop::Value);
+    // The user may have changed it
+    FlouiViewController::invalidate(view, Prop::Value);
+    auto env = c::env();
+    return env->CallBooleanMethod((jobject)view, c::jni.isChecked);
+}
+
+Toggle &Toggle::foreground(uint32_t c) {
+    PROPERTY_WRITE(Toggle, Foreground, foreground, c)
+    auto env = c::env();
+    env->CallVoidMethod((jobject)view, c::jni.setTextColor, argb2rgba(c));
+    return *this;
+}
+
+Toggle &Toggle::action(Action &&f) {
+    FLOUI_ENTRY("Toggle::action");
+    auto env = c::env();
+    auto v = (jobject)view;
+    env->CallVoidMethod(v, c::jni.setOnClickListener, c::main_activity);
+    android_set_slot(env, v, FlouiViewController::add_callback(std::move(f)));
+    return *this;
+}
+
+DEFINE_STYLES(Toggle)
+
+void *Check_init() {
+    auto env = c::env();
+    auto view = android_new_view(c::jni.check);
+    env->CallVoidMethod(view, c::jni.setTransformationMethod, nullptr);
+    return android_wrap_view(env, view);
+}
+
+Check::Check(void *b) : Widget(b) {}
+
+Check::Check(const std::string &label) : Widget(nullptr) {
+    FLOUI_ENTRY("Check::Check");
+    view = Check_init();
+    auto env = c::env();
+    auto s = env->NewStringUTF(label.c_str());
+    env->CallVoidMethod((jobject)view, c::jni.setText, s);
+    release_local(env, s);
+}
+
+Check &Check::value(bool val) {
+    PROPERTY_WRITE(Check, Value, value, val)
+    auto env = c::env();
+    env->CallVoidMethod((jobject)view, c::jni.setChecked, val);
+    return *this;
+}
+
+bool Check::value() {
+    FLOUI_ENTRY("Check::value");
+    FlouiViewController::settle(view, Prop::Value);
+    // The user may have changed it
+    FlouiViewController::invalidate(view, Prop::Value);
+    auto env = c::env();
+    return env->CallBooleanMethod((jobject)view, c::jni.isChecked);
+}
+
+Check &Check::foreground(uint32_t c) {
+    PROPERTY_WRITE(Check, Foreground, foreground, c)
+    auto env = c::env();
+    env->CallVoidMethod((jobject)view, c::jni.setTextColor, argb2rgba(c));
+    return *this;
+}
+
+Check &Check::action(Action &&f) {
+    FLOUI_ENTRY("Check::action");
+    auto env = c::env();
+    auto v = (jobject)view;
+    env->CallVoidMethod(v, c::jni.setOnClickListener, c::main_activity);
+    android_set_slot(env, v, FlouiViewController::add_callback(std::move(f)));
+    return *this;
+}
+
+DEFINE_STYLES(Check)
+
+void *Slider_init() {
+    auto env = c::env();
+    auto view = android_new_view(c::jni.slider);
+    return android_wrap_view(env, view);
+}
+
+Slider::Slider(void *b) : Widget(b) {}
+
+Slider::Slider() : Widget(nullptr) {
+    FLOUI_ENTRY("Slider::Slider");
+    view = Slider_init();
+}
+
+Slider &Slider::value(double val) {
+    PROPERTY_WRITE(Slider, Value, value, val)
+    auto env = c::env();
+    env->CallVoidMethod((jobject)view, c::jni.slider_setValue, val);
+    return *this;
+}
+
+double Slider::value() {
+    FLOUI_ENTRY("Slider::value");
+    FlouiViewController::settle(view, Prop::Value);
+    // The user may have changed it
+    FlouiViewController::invalidate(view, Prop::Value);
+    auto env = c::env();
+    return env->CallFloatMethod((jobject)view, c::jni.slider_getValue);
+}
+
+Slider &Slider::foreground(uint32_t) { return *this; }
+
+Slider &Slider::action(Action &&f) {
+    FLOUI_ENTRY("Slider::action");
+    auto env = c::env();
+    auto v = (jobject)view;
+    env->CallVoidMethod(v, c::jni.addOnChangeListener, c::main_activity);
+    android_set_slot(env, v, FlouiViewController::add_callback(std::move(f)));
+    return *this;
+}
+
+DEFINE_STYLES(Slider)
+
+void *Text_init() {
+    auto env = c::env();
+    auto view = android_new_view(c::jni.text);
+    return android_wrap_view(env, view);
+}
+
+Text::Text(void *b) : Widget(b) {}
+
+Text::Text(const std::string &label) : Widget(nullptr) {
+    FLOUI_ENTRY("Text::Text");
+    view = Text_init();
+    auto env = c::env();
+    auto s = env->NewStringUTF(label.c_str());
+    env->CallVoidMethod((jobject)view, c::jni.setText, s);
+    release_local(env, s);
+}
+
+Text &Text::fontsize(int size) {
+    PROPERTY_WRITE(Text, Fontsize, fontsize, size)
+    auto env = c::env();
+    env->CallVoidMethod((jobject)view, c::jni.setTextSize, (float)size);
+    return *this;
+}
+
+Text &Text::bold() {
+    FLOUI_ENTRY("Text::bold");
+    auto env = c::env();
+    env->CallVoidMethod((jobject)view, c::jni.setTypeface, (jobject) nullptr, 1);
+    return *this;
+}
+
+Text &Text::italic() {
+    FLOUI_ENTRY("Text::italic");
+    auto env = c::env();
+    env->CallVoidMethod((jobject)view, c::jni.setTypeface, (jobject) nullptr, 2);
+    return *this;
+}
+
+Text &Text::normal() {
+    FLOUI_ENTRY("Text::normal");
+    auto env = c::env();
+    env->CallVoidMethod((jobject)view, c::jni.setTypeface, (jobject) nullptr, 0);
+    return *this;
+}
+
+Text &Text::text(const std::string &label) {
+    PROPERTY_WRITE(Text, Text, text, label)
+    auto env = c::env();
+    auto s = env->NewStringUTF(label.c_str());
+    env->CallVoidMethod((jobject)view, c::jni.setText, s);
+    release_local(env, s);
+    return *this;
+}
+
+Text &Text::center() {
+    FLOUI_ENTRY("Text::center");
+    auto env = c::env();
+    env->CallVoidMethod((jobject)view, c::jni.setGravity, 17 /*center*/);
+    return *this;
+}
+
+Text &Text::left() {
+    FLOUI_ENTRY("Text::left");
+    auto env = c::env();
+    env->CallVoidMethod((jobject)view, c::jni.setGravity, 3 /*left*/);
+    return *this;
+}
+
+Text &Text::right() {
+    FLOUI_ENTRY("Text::right");
+    auto env = c::env();
+    env->CallVoidMethod((jobject)view, c::jni.setGravity, 5 /*right*/);
+    return *this;
+}
+
+Text &Text::foreground(uint32_t c) {
+    PROPERTY_WRITE(Text, Foreground, foreground, c)
+    auto env = c::env();
+    env->CallVoidMethod((jobject)view, c::jni.setTextColor, argb2rgba(c));
+    return *this;
+}
+
+DEFINE_STYLES(Text)
+
+void *TextField_init() {
+    auto env = c::env();
+    auto view = android_new_view(c::jni.text_field);
+    if (c::jni.watchText)
+        env->CallVoidMethod(c::main_activity, c::jni.watchText, view);
+    return android_wrap_view(env, view);
+}
+
+TextField::TextField(void *b) : Widget(b) {}
+
+TextField::TextField() : Widget(nullptr) {
+    FLOUI_ENTRY("TextField::TextField");
+    view = TextField_init();
+}
+
+TextField &TextField::fontsize(int size) {
+    PROPERTY_WRITE(TextField, Fontsize, fontsize, size)
+    auto env = c::env();
+    env->CallVoidMethod((jobject)view, c::jni.setTextSize, (float)size);
+    return *this;
+}
+
+TextField &TextField::text(const std::string &label) {
+    // Without MainActivity.watchText, typing isn't seen, so the cached text can't be trusted
+    if (!c::jni.watchText)
+        FlouiViewController::invalidate(view, Prop::Text);
+    PROPERTY_WRITE(TextField, Text, text, label)
+    auto env = c::env();
+    auto s = env->NewStringUTF(label.c_str());
+    env->CallVoidMethod((jobject)view, c::jni.setText, s);
+    release_local(env, s);
+    return *this;
+}
+
+std::string TextField::text() const {
+    FLOUI_ENTRY("TextField::text");
+    FlouiViewController::settle(view, Prop::Text);
+    // The user may have changed it
+    FlouiViewController::invalidate(view, Prop::Text);
+    auto env = c::env();
+    auto seq = env->CallObjectMethod((jobject)view, c::jni.getText);
+    auto str = (jstring)env->CallObjectMethod(seq, c::jni.toString);
+    auto chars = env->GetStringUTFChars(str, nullptr);
+    std::string ret(chars ? chars : "");
+    env->ReleaseStringUTFChars(str, chars);
+    release_local(env, str);
+    release_local(env, seq);
+    return ret;
+}
+
+TextField &TextField::center() {
+    FLOUI_ENTRY("TextField::center");
+    auto env = c::env();
+    env->CallVoidMethod((jobject)view, c::jni.setGravity, 17 /*center*/);
+    return *this;
+}
+
+TextField &TextField::left() {
+    FLOUI_ENTRY("TextField::left");
+    auto env = c::env();
+    env->CallVoidMethod((jobject)view, c::jni.setGravity, 3 /*left*/);
+    return *this;
+}
 
-using namespace floui;
+TextField &TextField::right() {
+    FLOUI_ENTRY("TextField::right");
+    auto env = c::env();
+    env->CallVoidMethod((jobject)view, c::jni.setGravity, 5 /*right*/);
+    return *this;
+}
 
-Color::Color(uint32_t col) : c(col) {}
+TextField &TextField::foreground(uint32_t c) {
+    PROPERTY_WRITE(TextField, Foreground, foreground, c)
+    auto env = c::env();
+    env->CallVoidMethod((jobject)view, c::jni.setTextColor, argb2rgba(c));
+    return *this;
+}
 
-Color::operator uint32_t() const { return c; }
+DEFINE_STYLES(TextField)
 
-Color::Color(uint8_t r, uint8_t g, uint8_t b, uint8_t a)
-    : c(((r & 0xff) << 24) + ((g & 0xff) << 16) + ((b & 0xff) << 8) + (a & 0xff)) {}
+void *Spacer_init() {
+    auto env = c::env();
+    auto view = android_new_view(c::jni.spacer);
+    return android_wrap_view(env, view);
+}
 
-Color Color::rgb(uint8_t r, uint8_t g, uint8_t b, uint8_t a) { return Color(r, g, b, a); }
+Spacer::Spacer(void *b) : Widget(b) {}
 
-#ifdef __ANDROID__
-// Android stuff
-#include <jni.h>
+Spacer::Spacer() : Widget(nullptr) {
+    FLOUI_ENTRY("Spacer::Spacer");
+    view = Spacer_init();
+}
 
-Color Color::system_purple() { return Color(0x7f007fff); }
+DEFINE_STYLES(Spacer)
 
-struct FlouiViewControllerImpl {
-    static inline JavaVM *vm = nullptr;
-    static inline jobject main_activity = nullptr;
-    static inline jobject layout = nullptr;
-    static inline std::unordered_map<int, std::function<void(Widget &)> *> callbackmap = {};
+void *VStack_init() {
+    auto env = c::env();
+    auto view = android_new_view(c::jni.linear_layout);
+    env->CallVoidMethod(view, c::jni.setOrientation, 1 /*vertical*/);
+    env->CallVoidMethod(view, c::jni.layout_setGravity, 17 /*center*/);
+    return android_wrap_view(env, view);
+}
 
-    FlouiViewControllerImpl(JNIEnv *env, jobject m, jobject layout) {
-        env->GetJavaVM(&vm);
-        FlouiViewControllerImpl::main_activity = env->NewWeakGlobalRef(m);
-        FlouiViewControllerImpl::layout = env->NewWeakGlobalRef(layout);
+/// Spaces the children of a LinearLayout by val pixels. A transparent divider of that size is shown
+/// between them, so the spacing follows children as they're added or removed
+static void android_spacing(jobject group, int val) {
+    auto env = c::env();
+    if (val <= 0) {
+        env->CallVoidMethod(group, c::jni.setShowDividers, 0 /*none*/);
+        return;
     }
+    auto divider = env->NewObject(c::jni.gradient_drawable, c::jni.gradient_drawable_init);
+    env->CallVoidMethod(divider, c::jni.setSize, val, val);
+    env->CallVoidMethod(group, c::jni.setDividerDrawable, divider);
+    env->CallVoidMethod(group, c::jni.setShowDividers, 2 /*middle*/);
+    release_local(env, divider);
+}
 
-    static JNIEnv *env() {
-        JNIEnv *env;
-        vm->GetEnv((void **)&env, JNI_VERSION_1_6);
-        return env;
+/// Adds views to group, replacing its children if replace. Several views go in a single call
+/// through MainActivity.addViews, which adds them on the Java side, otherwise each takes a call
+static void android_splice(jobject group, const std::vector<void *> &views, bool replace) {
+    auto env = c::env();
+    if (c::jni.addViews && views.size() > 1) {
+        auto array = env->NewObjectArray((jsize)views.size(), c::jni.view, nullptr);
+        for (size_t i = 0; i < views.size(); i++)
+            env->SetObjectArrayElement(array, (jsize)i, (jobject)views[i]);
+        env->CallVoidMethod(c::main_activity, c::jni.addViews, group, array, (jboolean)replace);
+        release_local(env, array);
+        return;
     }
-};
-
-FlouiViewController::FlouiViewController(void *env, void *m, void *layout)
-    : impl(new FlouiViewControllerImpl((JNIEnv *)env, (jobject)m, (jobject)layout)) {}
+    if (replace)
+        env->CallVoidMethod(group, c::jni.removeAllViews);
+    for (auto v : views)
+        env->CallVoidMethod(group, c::jni.addView, (jobject)v);
+}
 
-static int get_android_id(jobject view);
+MainView::MainView(void *m) : Widget(m) {}
 
-void FlouiViewController::handle_events(void *view) {
+MainView::MainView(const FlouiViewController &, std::initializer_list<Widget> l)
+    : Widget(nullptr) {
+    FLOUI_ENTRY("MainView::MainView");
+    view = VStack_init();
+    auto env = c::env();
     auto v = (jobject)view;
-    auto elem = FlouiViewControllerImpl::callbackmap.find(get_android_id(v));
-    if (elem != FlouiViewControllerImpl::callbackmap.end()) {
-        auto w = Widget(v);
-        (*elem->second)(w);
+    env->CallVoidMethod(c::layout, c::jni.addView, v);
+    auto params = env->CallObjectMethod(v, c::jni.getLayoutParams);
+    env->SetIntField(params, c::jni.width, -1);
+    release_local(env, params);
+    for (auto &e : l) {
+        env->CallVoidMethod(v, c::jni.addView, (jobject)e.inner());
     }
 }
 
-FlouiViewController::~FlouiViewController() { delete impl; }
-
-using c = FlouiViewControllerImpl;
+MainView &MainView::spacing(int val) {
+    FLOUI_ENTRY("MainView::spacing");
+    android_spacing((jobject)view, val);
+    return *this;
+}
 
-static jobject android_new_view(const char *klass) {
+MainView &MainView::add(const Widget &w) {
+    FLOUI_ENTRY("MainView::add");
     auto env = c::env();
-    auto k = env->FindClass(klass);
-    auto init = env->GetMethodID(k, "<init>", "(Landroid/content/Context;)V");
-    auto obj = env->NewObject(k, init, c::main_activity);
-    auto viewc = env->FindClass("android/view/View");
-    auto generateViewId = env->GetStaticMethodID(viewc, "generateViewId", "()I");
-    auto id = env->CallStaticIntMethod(viewc, generateViewId);
-    auto setId = env->GetMethodID(env->GetObjectClass(obj), "setId", "(I)V");
-    env->CallVoidMethod(obj, setId, id);
-    return obj;
+    env->CallVoidMethod((jobject)view, c::jni.addView, (jobject)w.inner());
+    return *this;
 }
 
-static jobject get_view_by_id(int val) {
+MainView &MainView::insert(const Widget &w, int index) {
+    FLOUI_ENTRY("MainView::insert");
     auto env = c::env();
-    auto viewc = env->FindClass("android/view/View");
-    auto findViewById = env->GetMethodID(viewc, "findViewById", "(I)Landroid/view/View;");
-    auto v = env->CallObjectMethod(c::main_activity, findViewById, val);
-    return v;
+    env->CallVoidMethod((jobject)view, c::jni.addViewAt, (jobject)w.inner(), (jint)index);
+    return *this;
 }
 
-int get_android_id(jobject view) {
+MainView &MainView::remove(const Widget &w) {
+    FLOUI_ENTRY("MainView::remove");
     auto env = c::env();
-    auto viewc = env->FindClass("android/view/View");
-    auto getId = env->GetMethodID(viewc, "getId", "()I");
-    return env->CallIntMethod(view, getId);
+    env->CallVoidMethod((jobject)view, c::jni.removeView, (jobject)w.inner());
+    return *this;
 }
 
-void floui_log0(const char *s) {
+MainView &MainView::clear() {
+    FLOUI_ENTRY("MainView::clear");
     auto env = c::env();
-    auto cl = env->FindClass("android/util/Log");
-    auto e = env->GetStaticMethodID(cl, "e", "(Ljava/lang/String;Ljava/lang/String;)I");
-    env->CallStaticIntMethod(cl, e, env->NewStringUTF("FlouiApp"), env->NewStringUTF(s));
+    env->CallVoidMethod((jobject)view, c::jni.removeAllViews);
+    return *this;
 }
 
-int floui_log(const char *s) {
-    floui_log0(s);
-    return 0;
+MainView &MainView::splice(const std::vector<void *> &views, bool replace) {
+    FLOUI_ENTRY("MainView::splice");
+    android_splice((jobject)view, views, replace);
+    return *this;
 }
 
-static constexpr uint32_t argb2rgba(uint32_t argb) { return (argb << 24) | (argb >> 8); }
+DEFINE_STYLES(MainView)
 
-#define DEFINE_STYLES(widget)                                                                      \
-    widget &widget::background(uint32_t col) {                                                     \
-        auto env = c::env();                                                                       \
-        auto v = (jobject)view;                                                                    \
-        auto setBackgroundColor =                                                                  \
-            env->GetMethodID(env->GetObjectClass(v), "setBackgroundColor", "(I)V");                \
-        env->CallVoidMethod(v, setBackgroundColor, argb2rgba(col));                                \
-        return *this;                                                                              \
-    }                                                                                              \
-    widget &widget::id(const char *val) {                                                          \
-        widget_map[val] = view;                                                                    \
-        return *this;                                                                              \
-    }                                                                                              \
-    widget &widget::size(int w, int h) {                                                           \
-        auto env = c::env();                                                                       \
-        auto v = (jobject)view;                                                                    \
-        auto layoutc = env->FindClass("android/widget/LinearLayout$LayoutParams");                 \
-        auto init = env->GetMethodID(layoutc, "<init>", "(II)V");                                  \
-        auto obj = env->NewObject(layoutc, init, w, h);                                            \
-        auto setLayoutParams = env->GetMethodID(env->GetObjectClass(v), "setLayoutParams",         \
-                                                "(Landroid/view/ViewGroup$LayoutParams;)V");       \
-        env->CallVoidMethod(v, setLayoutParams, obj);                                              \
-        return *this;                                                                              \
+VStack::VStack(void *m) : Widget(m) {}
+
+VStack::VStack(std::initializer_list<Widget> l) : Widget(nullptr) {
+    FLOUI_ENTRY("VStack::VStack");
+    view = VStack_init();
+    auto env = c::env();
+    auto v = (jobject)view;
+    for (auto &e : l) {
+        env->CallVoidMethod(v, c::jni.addView, (jobject)e.inner());
     }
+}
 
-Widget::Widget(void *v) : view(v) {}
+VStack &VStack::spacing(int val) {
+    FLOUI_ENTRY("VStack::spacing");
+    android_spacing((jobject)view, val);
+    return *this;
+}
 
-void *Widget::inner() const { return view; }
+VStack &VStack::add(const Widget &w) {
+    FLOUI_ENTRY("VStack::add");
+    auto env = c::env();
+    env->CallVoidMethod((jobject)view, c::jni.addView, (jobject)w.inner());
+    return *this;
+}
 
-DEFINE_STYLES(Widget)
+VStack &VStack::insert(const Widget &w, int index) {
+    FLOUI_ENTRY("VStack::insert");
+    auto env = c::env();
+    env->CallVoidMethod((jobject)view, c::jni.addViewAt, (jobject)w.inner(), (jint)index);
+    return *this;
+}
 
-void *Button_init() {
+VStack &VStack::remove(const Widget &w) {
+    FLOUI_ENTRY("VStack::remove");
     auto env = c::env();
-    auto view = android_new_view("android/widget/Button");
-    auto setTransformationMethod =
-        env->GetMethodID(env->GetObjectClass(view), "setTransformationMethod",
-                         "(Landroid/text/method/TransformationMethod;)V");
-    env->CallVoidMethod(view, setTransformationMethod, nullptr);
-    return env->NewWeakGlobalRef(view);
+    env->CallVoidMethod((jobject)view, c::jni.removeView, (jobject)w.inner());
+    return *this;
 }
 
-Button::Button(void *b) : Widget(b) {}
+VStack &VStack::clear() {
+    FLOUI_ENTRY("VStack::clear");
+    auto env = c::env();
+    env->CallVoidMethod((jobject)view, c::jni.removeAllViews);
+    return *this;
+}
+
+VStack &VStack::splice(const std::vector<void *> &views, bool replace) {
+    FLOUI_ENTRY("VStack::splice");
+    android_splice((jobject)view, views, replace);
+    return *this;
+}
+
+DEFINE_STYLES(VStack)
 
-Button::Button(const std::string &label) : Widget(Button_init()) {
+void *HStack_init() {
     auto env = c::env();
-    auto v = (jobject)view;
-    auto setText =
-        env->GetMethodID(env->GetObjectClass(v), "setText", "(Ljava/lang/CharSequence;)V");
-    env->CallVoidMethod(v, setText, env->NewStringUTF(label.c_str()));
+    auto view = android_new_view(c::jni.linear_layout);
+    env->CallVoidMethod(view, c::jni.setOrientation, 0 /*Horizontal*/);
+    env->CallVoidMethod(view, c::jni.layout_setGravity, 17 /*center*/);
+    return android_wrap_view(env, view);
 }
 
-Button &Button::foreground(uint32_t c) {
+HStack::HStack(void *m) : Widget(m) {}
+
+HStack::HStack(std::initializer_list<Widget> l) : Widget(nullptr) {
+    FLOUI_ENTRY("HStack::HStack");
+    view = HStack_init();
     auto env = c::env();
     auto v = (jobject)view;
-    auto setTextColor = env->GetMethodID(env->GetObjectClass(v), "setTextColor", "(I)V");
-    env->CallVoidMethod(v, setTextColor, argb2rgba(c));
+    for (auto &e : l) {
+        env->CallVoidMethod(v, c::jni.addView, (jobject)e.inner());
+    }
+}
+
+HStack &HStack::spacing(int val) {
+    FLOUI_ENTRY("HStack::spacing");
+    android_spacing((jobject)view, val);
     return *this;
 }
 
-Button &Button::filled() { return *this; }
+HStack &HStack::add(const Widget &w) {
+    FLOUI_ENTRY("HStack::add");
+    auto env = c::env();
+    env->CallVoidMethod((jobject)view, c::jni.addView, (jobject)w.inner());
+    return *this;
+}
 
-Button &Button::action(std::function<void(Widget &)> &&f) {
+HStack &HStack::insert(const Widget &w, int index) {
+    FLOUI_ENTRY("HStack::insert");
     auto env = c::env();
-    auto v = (jobject)view;
-    auto setOnClickListener = env->GetMethodID(env->GetObjectClass(v), "setOnClickListener",
-                                               "(Landroid/view/View$OnClickListener;)V");
-    env->CallVoidMethod(v, setOnClickListener, c::main_activity);
-    c::callbackmap[get_android_id(v)] = new std::function<void(Widget &)>(f);
+    env->CallVoidMethod((jobject)view, c::jni.addViewAt, (jobject)w.inner(), (jint)index);
     return *this;
 }
 
-DEFINE_STYLES(Button)
+HStack &HStack::remove(const Widget &w) {
+    FLOUI_ENTRY("HStack::remove");
+    auto env = c::env();
+    env->CallVoidMethod((jobject)view, c::jni.removeView, (jobject)w.inner());
+    return *this;
+}
 
-void *Toggle_init() {
+HStack &HStack::clear() {
+    FLOUI_ENTRY("HStack::clear");
     auto env = c::env();
-    auto view = android_new_view("android/widget/Switch");
-    auto setTransformationMethod =
-        env->GetMethodID(env->GetObjectClass(view), "setTransformationMethod",
-                         "(Landroid/text/method/TransformationMethod;)V");
-    env->CallVoidMethod(view, setTransformationMethod, nullptr);
-    return env->NewWeakGlobalRef(view);
+    env->CallVoidMethod((jobject)view, c::jni.removeAllViews);
+    return *this;
 }
 
-Toggle::Toggle(void *b) : Widget(b) {}
+HStack &HStack::splice(const std::vector<void *> &views, bool replace) {
+    FLOUI_ENTRY("HStack::splice");
+    android_splice((jobject)view, views, replace);
+    return *this;
+}
 
-Toggle::Toggle(const std::string &label) : Widget(Toggle_init()) {
+DEFINE_STYLES(HStack)
+
+/// Looks up a drawable's id by name, only once per name since it takes nine calls into Java
+static jint android_resource_id(const std::string &path) {
+    static std::unordered_map<std::string, jint> ids;
+    auto key = path.substr(0, path.find('.'));
+    auto cached = ids.find(key);
+    if (cached != ids.end())
+        return cached->second;
     auto env = c::env();
-    auto v = (jobject)view;
-    auto setText =
-        env->GetMethodID(env->GetObjectClass(v), "setText", "(Ljava/lang/CharSequence;)V");
-    env->CallVoidMethod(v, setText, env->NewStringUTF(label.c_str()));
+    auto resources = env->CallObjectMethod(c::main_activity, c::jni.getResources);
+    auto packageName = env->CallObjectMethod(c::main_activity, c::jni.getPackageName);
+    auto name = env->NewStringUTF(key.c_str());
+    auto type = env->NewStringUTF("drawable");
+    auto resId = env->CallIntMethod(resources, c::jni.getIdentifier, name, type, packageName);
+    release_local(env, type);
+    release_local(env, name);
+    release_local(env, packageName);
+    release_local(env, resources);
+    ids.emplace(std::move(key), resId);
+    return resId;
 }
 
-Toggle &Toggle::value(bool val) {
+void *ImageView_init(const std::string &path) {
     auto env = c::env();
-    auto v = (jobject)view;
-    auto setChecked =
-        env->GetMethodID(env->FindClass("android/widget/Switch"), "setChecked", "(Z)V");
-    env->CallVoidMethod(v, setChecked, val);
-    return *this;
+    auto resId = android_resource_id(path);
+    auto view = android_new_view(c::jni.image_view);
+    env->CallVoidMethod(view, c::jni.setImageResource, resId);
+    return android_wrap_view(env, view);
 }
 
-bool Toggle::value() {
+void *ImageView_init() {
     auto env = c::env();
-    auto v = (jobject)view;
-    auto isChecked = env->GetMethodID(env->GetObjectClass(v), "isChecked", "()Z");
-    return env->CallBooleanMethod(v, isChecked);
+    auto view = android_new_view(c::jni.image_view);
+    return android_wrap_view(env, view);
 }
 
-Toggle &Toggle::foreground(uint32_t c) {
-    auto env = c::env();
-    auto v = (jobject)view;
-    auto setTextColor = env->GetMethodID(env->GetObjectClass(v), "setTextColor", "(I)V");
-    env->CallVoidMethod(v, setTextColor, argb2rgba(c));
-    return *this;
+ImageView::ImageView(void *v) : Widget(v) {}
+
+ImageView::ImageView() : Widget(nullptr) {
+    FLOUI_ENTRY("ImageView::ImageView");
+    view = ImageView_init();
 }
 
-Toggle &Toggle::action(std::function<void(Widget &)> &&f) {
+ImageView::ImageView(const std::string &path) : Widget(nullptr) {
+    FLOUI_ENTRY("ImageView::ImageView");
+    view = ImageView_init(path);
+}
+
+ImageView &ImageView::image(const std::string &path) {
+    PROPERTY_WRITE(ImageView, Image, image, path)
     auto env = c::env();
-    auto v = (jobject)view;
-    auto setOnClickListener = env->GetMethodID(env->GetObjectClass(v), "setOnClickListener",
-                                               "(Landroid/view/View$OnClickListener;)V");
-    env->CallVoidMethod(v, setOnClickListener, c::main_activity);
-    c::callbackmap[get_android_id(v)] = new std::function<void(Widget &)>(f);
+    env->CallVoidMethod((jobject)view, c::jni.setImageResource, android_resource_id(path));
     return *this;
 }
 
-DEFINE_STYLES(Toggle)
+DEFINE_STYLES(ImageView)
 
-void *Check_init() {
+void *WebView_init() {
     auto env = c::env();
-    auto view = android_new_view("android/widget/CheckBox");
-    auto setTransformationMethod =
-        env->GetMethodID(env->GetObjectClass(view), "setTransformationMethod",
-                         "(Landroid/text/method/TransformationMethod;)V");
-    env->CallVoidMethod(view, setTransformationMethod, nullptr);
-    return env->NewWeakGlobalRef(view);
+    auto view = android_new_view(c::jni.web_view);
+    return android_wrap_view(env, view);
 }
 
-Check::Check(void *b) : Widget(b) {}
+WebView::WebView(void *v) : Widget(v) {}
+
+WebView::WebView() : Widget(nullptr) {
+    FLOUI_ENTRY("WebView::WebView");
+    view = WebView_init();
+}
 
-Check::Check(const std::string &label) : Widget(Check_init()) {
+WebView &WebView::load_file_url(const std::string &local_path) {
+    FLOUI_ENTRY("WebView::load_file_url");
     auto env = c::env();
-    auto v = (jobject)view;
-    auto setText =
-        env->GetMethodID(env->GetObjectClass(v), "setText", "(Ljava/lang/CharSequence;)V");
-    env->CallVoidMethod(v, setText, env->NewStringUTF(label.c_str()));
+    auto path = std::string("file:///android_asset/" +
+                            local_path.substr(local_path.find("file:///") + 8, local_path.size()));
+    auto url = env->NewStringUTF(path.c_str());
+    env->CallVoidMethod((jobject)view, c::jni.loadUrl, url);
+    release_local(env, url);
+    return *this;
 }
 
-Check &Check::value(bool val) {
+WebView &WebView::load_http_url(const std::string &path) {
+    FLOUI_ENTRY("WebView::load_http_url");
     auto env = c::env();
-    auto v = (jobject)view;
-    auto setChecked =
-        env->GetMethodID(env->FindClass("android/widget/CheckBox"), "setChecked", "(Z)V");
-    env->CallVoidMethod(v, setChecked, val);
+    auto url = env->NewStringUTF(path.c_str());
+    env->CallVoidMethod((jobject)view, c::jni.loadUrl, url);
+    release_local(env, url);
     return *this;
 }
 
-bool Check::value() {
+WebView &WebView::load_html(const std::string &html) {
+    FLOUI_ENTRY("WebView::load_html");
     auto env = c::env();
-    auto v = (jobject)view;
-    auto isChecked = env->GetMethodID(env->GetObjectClass(v), "isChecked", "()Z");
-    return env->CallBooleanMethod(v, isChecked);
+    auto data = env->NewStringUTF(html.c_str());
+    auto mime = env->NewStringUTF("text/html");
+    auto encoding = env->NewStringUTF("utf-8");
+    env->CallVoidMethod((jobject)view, c::jni.loadDataWithBaseURL, nullptr, data, mime, encoding,
+                        nullptr);
+    release_local(env, encoding);
+    release_local(env, mime);
+    release_local(env, data);
+    return *this;
 }
 
-Check &Check::foreground(uint32_t c) {
+WebView &WebView::load_url(const std::string &url) {
+    FLOUI_ENTRY("WebView::load_url");
+    if (url.find("file://") == 0) {
+        load_file_url(url);
+    } else {
+        load_http_url(url);
+    }
+    return *this;
+}
+
+DEFINE_STYLES(WebView)
+
+void *ScrollView_init() {
     auto env = c::env();
-    auto v = (jobject)view;
-    auto setTextColor = env->GetMethodID(env->GetObjectClass(v), "setTextColor", "(I)V");
-    env->CallVoidMethod(v, setTextColor, argb2rgba(c));
+    auto view = android_new_view(c::jni.scroll_view);
+    return android_wrap_view(env, view);
+}
+
+ScrollView::ScrollView(void *v) : Widget(v) {}
+
+ScrollView::ScrollView(const Widget &w) : Widget(nullptr) {
+    FLOUI_ENTRY("ScrollView::ScrollView");
+    view = ScrollView_init();
+    auto env = c::env();
+    env->CallVoidMethod((jobject)view, c::jni.addView, (jobject)w.inner());
+    if (!LazyStack::lazy(w.inner()))
+        return;
+    if (!c::jni.setOnScrollChangeListener || !c::jni.onScrollChange) {
+        // Without scroll events every child has to be made up front
+        floui_log("floui: lazy stacks need MainActivity.onScrollChange, see the README");
+        LazyStack(w.inner()).layout(0, INT32_MAX / 2);
+        return;
+    }
+    env->CallVoidMethod((jobject)view, c::jni.setOnScrollChangeListener, c::main_activity);
+    LazyStack::attach(get_android_id((jobject)view), w.inner());
+}
+
+DEFINE_STYLES(ScrollView)
+
+/// Java collects the views once they're removed, floui only holds a weak reference to the child's
+/// view. Those to the views under it, which floui can't reach from the child, are kept
+void Widget::destroy(void *view) {
+    discard(view);
+    c::env()->DeleteWeakGlobalRef((jweak)view);
+}
+
+void *ListView_init(int list) {
+    auto env = c::env();
+    if (!c::jni.recycler_view.cls || !c::jni.listAdapter) {
+        floui_log("floui: ListView needs androidx.recyclerview and MainActivity.listAdapter");
+        return Spacer().inner();
+    }
+    auto view = android_new_view(c::jni.recycler_view);
+    auto manager = env->NewObject(c::jni.linear_layout_manager.cls,
+                                  c::jni.linear_layout_manager.init, c::main_activity);
+    env->CallVoidMethod(view, c::jni.setLayoutManager, manager);
+    release_local(env, manager);
+    auto adapter = env->CallObjectMethod(c::main_activity, c::jni.listAdapter, list);
+    env->CallVoidMethod(view, c::jni.setAdapter, adapter);
+    release_local(env, adapter);
+    return android_wrap_view(env, view);
+}
+
+ListView::ListView(void *v) : Widget(v) {}
+
+ListView::ListView(int count, Create create, Bind bind, Type type) : Widget(nullptr) {
+    FLOUI_ENTRY("ListView::ListView");
+    auto list = add_list(count, std::move(create), std::move(bind), std::move(type));
+    view = ListView_init(list);
+    ids_[view] = list;
+}
+
+ListView &ListView::count(int n) {
+    FLOUI_ENTRY("ListView::count");
+    list().count = n;
+    if (!c::jni.getAdapter)
+        return *this;
+    auto env = c::env();
+    auto adapter = env->CallObjectMethod((jobject)view, c::jni.getAdapter);
+    env->CallVoidMethod(adapter, c::jni.notifyDataSetChanged);
+    release_local(env, adapter);
     return *this;
 }
 
-Check &Check::action(std::function<void(Widget &)> &&f) {
+DEFINE_STYLES(ListView)
+
+/// In a single call through MainActivity.applyStyle, otherwise with a call per property, the text
+/// properties only going to TextViews, which buttons, toggles, checks and text fields are
+void Style::show(void *view, const Style &s) {
+    static constexpr int gravity[] = {3 /*left*/, 17 /*center*/, 5 /*right*/};
     auto env = c::env();
     auto v = (jobject)view;
-    auto setOnClickListener = env->GetMethodID(env->GetObjectClass(v), "setOnClickListener",
-                                               "(Landroid/view/View$OnClickListener;)V");
-    env->CallVoidMethod(v, setOnClickListener, c::main_activity);
-    c::callbackmap[get_android_id(v)] = new std::function<void(Widget &)>(f);
-    return *this;
+    if (c::jni.applyStyle) {
+        env->CallVoidMethod(c::main_activity, c::jni.applyStyle, v, (jint)s.fields(),
+                            (jint)argb2rgba(s.background()), (jint)argb2rgba(s.foreground()),
+                            (float)s.fontsize(), (jint)s.font(), gravity[(int)s.align()]);
+        return;
+    }
+    if (s.has(Background))
+        env->CallVoidMethod(v, c::jni.setBackgroundColor, argb2rgba(s.background()));
+    if (!(s.fields() & ~Background) || !env->IsInstanceOf(v, c::jni.text.cls))
+        return;
+    if (s.has(Foreground))
+        env->CallVoidMethod(v, c::jni.setTextColor, argb2rgba(s.foreground()));
+    if (s.has(Fontsize))
+        env->CallVoidMethod(v, c::jni.setTextSize, (float)s.fontsize());
+    if (s.has(Font))
+        env->CallVoidMethod(v, c::jni.setTypeface, (jobject) nullptr, (jint)s.font());
+    if (s.has(Alignment))
+        env->CallVoidMethod(v, c::jni.setGravity, gravity[(int)s.align()]);
+}
+
+#elif defined(__APPLE__) && defined(__OBJC__)
+
+#import <Foundation/Foundation.h>
+#include <TargetConditionals.h>
+
+@interface Callback : NSObject {
+    int slot_;
+    void *target_;
+}
+- (id)initWithTarget:(void *)target Slot:(int)slot;
+- (void)invoke;
+@end
+
+void floui_log0(const char *s) { NSLog(@"%@", [NSString stringWithUTF8String:s]); }
+
+void FlouiViewController::wake() {
+    dispatch_async(dispatch_get_main_queue(), ^{
+      FlouiViewController::drain();
+    });
+}
+
+int floui_log(const char *s) {
+    floui::Log::write<floui::LogLevel::Info>(s);
+    return 0;
+}
+
+@implementation Callback
+- (id)initWithTarget:(void *)target Slot:(int)slot {
+    self = [super init];
+    slot_ = slot;
+    target_ = target;
+    return self;
+}
+- (void)invoke {
+    FlouiViewController::handle_event(slot_, target_);
+}
+@end
+
+#if TARGET_OS_IPHONE
+// ios stuff
+#import <UIKit/UIKit.h>
+#import <WebKit/WKWebView.h>
+
+/// Reports the scrolling of scroll views holding a lazy stack, keyed by the scroll view
+@interface LazyScroll : NSObject <UIScrollViewDelegate>
+@end
+
+@implementation LazyScroll
+- (void)scrollViewDidScroll:(UIScrollView *)v {
+    LazyStack::scrolled((int64_t)(intptr_t)(__bridge void *)v, v.contentOffset.x,
+                        v.contentOffset.y, v.bounds.size.width, v.bounds.size.height);
 }
+@end
 
-DEFINE_STYLES(Check)
+/// Invalidates the elided text of text fields as the user edits them
+@interface TextChanged : NSObject
+- (void)changed:(UITextField *)field;
+@end
 
-void *Slider_init() {
-    auto env = c::env();
-    auto view = android_new_view("com/google/android/material/slider/Slider");
-    return env->NewWeakGlobalRef(view);
+@implementation TextChanged
+- (void)changed:(UITextField *)field {
+    FlouiViewController::invalidate((__bridge void *)field, Prop::Text);
 }
+@end
 
-Slider::Slider(void *b) : Widget(b) {}
+struct FlouiViewControllerImpl {
+    static inline UIViewController *vc = nullptr;
+    static inline const char *name = nullptr;
+    static inline std::vector<Callback *> callbacks = {};
+    /// Scroll view delegates are weak
+    static inline LazyScroll *lazy_scroll = nil;
+    /// Control targets are weak
+    static inline TextChanged *text_changed = nil;
+
+    FlouiViewControllerImpl(UIViewController *vc, const char *name, void *) {
+        FlouiViewControllerImpl::vc = vc;
+        FlouiViewControllerImpl::name = name;
+        // Applies batched writes made outside of callbacks once per run loop turn
+        static auto flushing = [] {
+            auto observer = CFRunLoopObserverCreateWithHandler(
+                kCFAllocatorDefault, kCFRunLoopBeforeWaiting, true, 0,
+                ^(CFRunLoopObserverRef, CFRunLoopActivity) {
+                  FlouiViewController::flush();
+                });
+            CFRunLoopAddObserver(CFRunLoopGetMain(), observer, kCFRunLoopCommonModes);
+            CFRelease(observer);
+            return true;
+        }();
+        (void)flushing;
+    }
+};
 
-Slider::Slider() : Widget(Slider_init()) {}
+FlouiViewController::FlouiViewController(void *vc, void *name, void *)
+    : impl(new FlouiViewControllerImpl((__bridge UIViewController *)vc, (const char *)name,
+                                       nullptr)) {}
 
-Slider &Slider::value(double val) {
-    auto env = c::env();
-    auto v = (jobject)view;
-    auto setValue = env->GetMethodID(env->GetObjectClass(v), "setValue", "(F)V");
-    env->CallVoidMethod(v, setValue, val);
-    return *this;
+void FlouiViewController::handle_events(void *) { return; }
+
+FlouiViewController::~FlouiViewController() { delete impl; }
+
+BulkScope::BulkScope(int) {}
+
+BulkScope::~BulkScope() {}
+
+Color Color::system_purple() {
+    CGFloat r = 0, g = 0, b = 0, a = 0;
+    [UIColor.purpleColor getRed:&r green:&g blue:&b alpha:&a];
+    return Color(
+        ((uint32_t)(r * 255) << 24 | (uint32_t)(g * 255) << 16 | (uint32_t)(b * 255) << 8) |
+        (uint32_t)(a * 255));
 }
 
-double Slider::value() {
-    auto env = c::env();
-    auto v = (jobject)view;
-    auto getValue = env->GetMethodID(env->GetObjectClass(v), "getValue", "()F");
-    return env->CallFloatMethod(v, getValue);
+static UIColor *col2uicol(uint32_t col) {
+    auto r = ((col >> 24) & 0xFF) / 255.0;
+    auto g = ((col >> 16) & 0xFF) / 255.0;
+    auto b = ((col >> 8) & 0xFF) / 255.0;
+    auto a = ((col)&0xFF) / 255.0;
+    return [UIColor colorWithRed:r green:g blue:b alpha:a];
 }
 
-Slider &Slider::foreground(uint32_t) { return *this; }
+#define DEFINE_STYLES(widget)                                                                      \
+    widget &widget::background(uint32_t col) {                                                     \
+        PROPERTY_WRITE(widget, Background, background, col)                                        \
+        auto v = (__bridge UIView *)view;                                                          \
+        v.backgroundColor = col2uicol(col);                                                        \
+        return *this;                                                                              \
+    }                                                                                              \
+    widget &widget::id(Id val) {                                                                   \
+        widget_map.insert(val, view);                                                              \
+        return *this;                                                                              \
+    }                                                                                              \
+    widget &widget::size(int w, int h) {                                                           \
+        PROPERTY_WRITE(widget, Size, size, w, h)                                                   \
+        auto v = (__bridge UIView *)view;                                                          \
+        auto frame = v.frame;                                                                      \
+        frame.size.width = w;                                                                      \
+        frame.size.height = h;                                                                     \
+        v.frame = frame;                                                                           \
+        return *this;                                                                              \
+    }
 
-Slider &Slider::action(std::function<void(Widget &)> &&f) {
-    auto env = c::env();
-    auto v = (jobject)view;
-    auto addOnChangeListener = env->GetMethodID(
-        env->FindClass("com/google/android/material/slider/Slider"), "addOnChangeListener",
-        "(Lcom/google/android/material/slider/BaseOnChangeListener;)V");
-    env->CallVoidMethod(v, addOnChangeListener, c::main_activity);
-    c::callbackmap[get_android_id(v)] = new std::function<void(Widget &)>(f);
-    return *this;
-}
+Widget::Widget(void *v) : view(v) {}
 
-DEFINE_STYLES(Slider)
+void *Widget::inner() const { return view; }
 
-void *Text_init() {
-    auto env = c::env();
-    auto view = android_new_view("android/widget/TextView");
-    return env->NewWeakGlobalRef(view);
-}
+DEFINE_STYLES(Widget)
 
-Text::Text(void *b) : Widget(b) {}
+Button::Button(void *b) : Widget(b) {}
 
-Text::Text(const std::string &label) : Widget(Text_init()) {
-    auto env = c::env();
-    auto v = (jobject)view;
-    auto setText =
-        env->GetMethodID(env->GetObjectClass(v), "setText", "(Ljava/lang/CharSequence;)V");
-    env->CallVoidMethod(v, setText, env->NewStringUTF(label.c_str()));
+Button::Button(const std::string &label) : Widget(nullptr) {
+    FLOUI_ENTRY("Button::Button");
+    view = (void *)CFBridgingRetain([UIButton buttonWithType:UIButtonTypeCustom]);
+    auto v = (__bridge UIButton *)view;
+    [v setTitle:[NSString stringWithUTF8String:label.c_str()] forState:UIControlStateNormal];
+    [v setTitleColor:UIColor.blueColor forState:UIControlStateNormal];
 }
 
-Text &Text::fontsize(int size) {
-    auto env = c::env();
-    auto v = (jobject)view;
-    auto setTextSize = env->GetMethodID(env->GetObjectClass(v), "setTextSize", "(F)V");
-    env->CallVoidMethod(v, setTextSize, (float)size);
+Button &Button::filled() {
+    FLOUI_ENTRY("Button::filled");
+    ((__bridge UIButton *)view).configuration = [UIButtonConfiguration filledButtonConfiguration];
     return *this;
 }
 
-Text &Text::bold() {
-    auto env = c::env();
-    auto v = (jobject)view;
-    auto setTypeface =
-        env->GetMethodID(env->GetObjectClass(v), "setTypeface", "(Landroid/graphics/Typeface;I)V");
-    env->CallVoidMethod(v, setTypeface, (jobject) nullptr, 1);
+Button &Button::action(Action &&f) {
+    FLOUI_ENTRY("Button::action");
+    auto v = (__bridge UIButton *)view;
+    auto &callbacks = FlouiViewControllerImpl::callbacks;
+    auto slot = FlouiViewController::add_callback(std::move(f));
+    callbacks.push_back([[Callback alloc] initWithTarget:view Slot:slot]);
+    [v addTarget:callbacks.back()
+                  action:@selector(invoke)
+        forControlEvents:UIControlEventPrimaryActionTriggered];
     return *this;
 }
 
-Text &Text::italic() {
-    auto env = c::env();
-    auto v = (jobject)view;
-    auto setTypeface =
-        env->GetMethodID(env->GetObjectClass(v), "setTypeface", "(Landroid/graphics/Typeface;I)V");
-    env->CallVoidMethod(v, setTypeface, (jobject) nullptr, 2);
+Button &Button::action(::id target, SEL s) {
+    FLOUI_ENTRY("Button::action");
+    auto v = (__bridge UIButton *)view;
+    [v addTarget:target action:s forControlEvents:UIControlEventPrimaryActionTriggered];
     return *this;
 }
 
-Text &Text::normal() {
-    auto env = c::env();
-    auto v = (jobject)view;
-    auto setTypeface =
-        env->GetMethodID(env->GetObjectClass(v), "setTypeface", "(Landroid/graphics/Typeface;I)V");
-    env->CallVoidMethod(v, setTypeface, (jobject) nullptr, 0);
+Button &Button::foreground(uint32_t c) {
+    PROPERTY_WRITE(Button, Foreground, foreground, c)
+    auto v = (__bridge UIButton *)view;
+    [v setTitleColor:col2uicol(c) forState:UIControlStateNormal];
     return *this;
 }
 
-Text &Text::text(const std::string &label) {
-    auto env = c::env();
-    auto v = (jobject)view;
-    auto setText =
-        env->GetMethodID(env->GetObjectClass(v), "setText", "(Ljava/lang/CharSequence;)V");
-    env->CallVoidMethod(v, setText, env->NewStringUTF(label.c_str()));
-    return *this;
-}
+DEFINE_STYLES(Button)
 
-Text &Text::center() {
-    auto env = c::env();
-    auto v = (jobject)view;
-    auto setGravity = env->GetMethodID(env->GetObjectClass(v), "setGravity", "(I)V");
-    env->CallVoidMethod(v, setGravity, 17 /*center*/);
-    return *this;
-}
+#if !TARGET_OS_TV
 
-Text &Text::left() {
-    auto env = c::env();
-    auto v = (jobject)view;
-    auto setGravity = env->GetMethodID(env->GetObjectClass(v), "setGravity", "(I)V");
-    env->CallVoidMethod(v, setGravity, 3 /*left*/);
-    return *this;
-}
+Toggle::Toggle(void *b) : Widget(b) {}
 
-Text &Text::right() {
-    auto env = c::env();
-    auto v = (jobject)view;
-    auto setGravity = env->GetMethodID(env->GetObjectClass(v), "setGravity", "(I)V");
-    env->CallVoidMethod(v, setGravity, 5 /*right*/);
-    return *this;
+Toggle::Toggle(const std::string &label) : Widget(nullptr) {
+    FLOUI_ENTRY("Toggle::Toggle");
+    view = (void *)CFBridgingRetain([UIStackView new]);
+    auto v = (__bridge UIStackView *)view;
+    [v setAxis:UILayoutConstraintAxisHorizontal];
+    [v setDistribution:UIStackViewDistributionFillEqually];
+    [v setAlignment:UIStackViewAlignmentCenter];
+    [v setSpacing:10];
+    auto l = [UILabel new];
+    [l setText:[NSString stringWithUTF8String:label.c_str()]];
+    [v addArrangedSubview:l];
+    auto s = [UISwitch new];
+    [v addArrangedSubview:s];
 }
 
-Text &Text::foreground(uint32_t c) {
-    auto env = c::env();
-    auto v = (jobject)view;
-    auto setTextColor = env->GetMethodID(env->GetObjectClass(v), "setTextColor", "(I)V");
-    env->CallVoidMethod(v, setTextColor, argb2rgba(c));
+Toggle &Toggle::value(bool val) {
+    PROPERTY_WRITE(Toggle, Value, value, val)
+    auto v = (__bridge UIStackView *)view;
+    auto o = [[v subviews] lastObject];
+    [(UISwitch *)o setOn:val animated:YES];
     return *this;
 }
 
-DEFINE_STYLES(Text)
-
-void *TextField_init() {
-    auto env = c::env();
-    auto view = android_new_view("android/widget/EditText");
-    return env->NewWeakGlobalRef(view);
+bool Toggle::value() {
+    FLOUI_ENTRY("Toggle::value");
+    FlouiViewController::settle(view, Prop::Value);
+    FlouiViewController::invalidate(view, Prop::Value);
+    auto v = (__bridge UISwitch *)view;
+    auto o = (UISwitch *)[[v subviews] lastObject];
+    return o.on;
 }
 
-TextField::TextField(void *b) : Widget(b) {}
-
-TextField::TextField() : Widget(TextField_init()) {}
-
-TextField &TextField::fontsize(int size) {
-    auto env = c::env();
-    auto v = (jobject)view;
-    auto setTextSize = env->GetMethodID(env->GetObjectClass(v), "setTextSize", "(F)V");
-    env->CallVoidMethod(v, setTextSize, (float)size);
+Toggle &Toggle::action(Action &&f) {
+    FLOUI_ENTRY("Toggle::action");
+    auto v = (__bridge UISwitch *)view;
+    auto o = [[v subviews] lastObject];
+    auto &callbacks = FlouiViewControllerImpl::callbacks;
+    auto slot = FlouiViewController::add_callback(std::move(f));
+    callbacks.push_back([[Callback alloc] initWithTarget:view Slot:slot]);
+    [(UISwitch *)o addTarget:callbacks.back()
+                      action:@selector(invoke)
+            forControlEvents:UIControlEventPrimaryActionTriggered];
     return *this;
 }
 
-TextField &TextField::text(const std::string &label) {
-    auto env = c::env();
-    auto v = (jobject)view;
-    auto setText =
-        env->GetMethodID(env->GetObjectClass(v), "setText", "(Ljava/lang/CharSequence;)V");
-    env->CallVoidMethod(v, setText, env->NewStringUTF(label.c_str()));
+Toggle &Toggle::action(::id target, SEL s) {
+    FLOUI_ENTRY("Toggle::action");
+    auto v = (__bridge UISwitch *)view;
+    auto o = [[v subviews] lastObject];
+    [(UISwitch *)o addTarget:target action:s forControlEvents:UIControlEventPrimaryActionTriggered];
     return *this;
 }
 
-std::string TextField::text() const {
-    auto env = c::env();
-    auto v = (jobject)view;
-    auto getText =
-        env->GetMethodID(env->GetObjectClass(v), "getText", "()Ljava/lang/CharSequence;");
-    auto ret = env->CallObjectMethod(v, getText);
-    return std::string(reinterpret_cast<const char *>(ret));
-}
+Toggle &Toggle::foreground(uint32_t c) { return *this; }
 
-TextField &TextField::center() {
-    auto env = c::env();
-    auto v = (jobject)view;
-    auto setGravity = env->GetMethodID(env->GetObjectClass(v), "setGravity", "(I)V");
-    env->CallVoidMethod(v, setGravity, 17 /*center*/);
-    return *this;
+DEFINE_STYLES(Toggle)
+
+Check::Check(void *b) : Widget(b) {}
+
+Check::Check(const std::string &label) : Widget(nullptr) {
+    FLOUI_ENTRY("Check::Check");
+    view = (void *)CFBridgingRetain([UIStackView new]);
+    auto v = (__bridge UIStackView *)view;
+    [v setAxis:UILayoutConstraintAxisHorizontal];
+    [v setDistribution:UIStackViewDistributionFillEqually];
+    [v setAlignment:UIStackViewAlignmentCenter];
+    [v setSpacing:10];
+    auto l = [UILabel new];
+    [l setText:[NSString stringWithUTF8String:label.c_str()]];
+    [v addArrangedSubview:l];
+    auto s = [UISwitch new];
+    [s setPreferredStyle:UISwitchStyleCheckbox];
+    [v addArrangedSubview:s];
 }
 
-TextField &TextField::left() {
-    auto env = c::env();
-    auto v = (jobject)view;
-    auto setGravity = env->GetMethodID(env->GetObjectClass(v), "setGravity", "(I)V");
-    env->CallVoidMethod(v, setGravity, 3 /*left*/);
+Check &Check::value(bool val) {
+    PROPERTY_WRITE(Check, Value, value, val)
+    auto v = (__bridge UIStackView *)view;
+    auto o = [[v subviews] lastObject];
+    [(UISwitch *)o setOn:val animated:YES];
     return *this;
 }
 
-TextField &TextField::right() {
-    auto env = c::env();
-    auto v = (jobject)view;
-    auto setGravity = env->GetMethodID(env->GetObjectClass(v), "setGravity", "(I)V");
-    env->CallVoidMethod(v, setGravity, 5 /*right*/);
-    return *this;
+bool Check::value() {
+    FLOUI_ENTRY("Check::value");
+    FlouiViewController::settle(view, Prop::Value);
+    FlouiViewController::invalidate(view, Prop::Value);
+    auto v = (__bridge UISwitch *)view;
+    auto o = (UISwitch *)[[v subviews] lastObject];
+    return o.on;
 }
 
-TextField &TextField::foreground(uint32_t c) {
-    auto env = c::env();
-    auto v = (jobject)view;
-    auto setTextColor = env->GetMethodID(env->GetObjectClass(v), "setTextColor", "(I)V");
-    env->CallVoidMethod(v, setTextColor, argb2rgba(c));
+Check &Check::action(Action &&f) {
+    FLOUI_ENTRY("Check::action");
+    auto v = (__bridge UISwitch *)view;
+    auto o = [[v subviews] lastObject];
+    auto &callbacks = FlouiViewControllerImpl::callbacks;
+    auto slot = FlouiViewController::add_callback(std::move(f));
+    callbacks.push_back([[Callback alloc] initWithTarget:view Slot:slot]);
+    [(UISwitch *)o addTarget:callbacks.back()
+                      action:@selector(invoke)
+            forControlEvents:UIControlEventPrimaryActionTriggered];
     return *this;
 }
 
-DEFINE_STYLES(TextField)
-
-void *Spacer_init() {
-    auto env = c::env();
-    auto view = android_new_view("android/widget/Space");
-    return env->NewWeakGlobalRef(view);
+Check &Check::action(::id target, SEL s) {
+    FLOUI_ENTRY("Check::action");
+    auto v = (__bridge UISwitch *)view;
+    auto o = [[v subviews] lastObject];
+    [(UISwitch *)o addTarget:target action:s forControlEvents:UIControlEventPrimaryActionTriggered];
+    return *this;
 }
 
-Spacer::Spacer(void *b) : Widget(b) {}
+Check &Check::foreground(uint32_t c) { return *this; }
 
-Spacer::Spacer() : Widget(Spacer_init()) {}
+DEFINE_STYLES(Check)
 
-DEFINE_STYLES(Spacer)
+Slider::Slider(void *b) : Widget(b) {}
 
-void *VStack_init() {
-    auto env = c::env();
-    auto view = android_new_view("android/widget/LinearLayout");
-    auto setOrientation = env->GetMethodID(env->GetObjectClass(view), "setOrientation", "(I)V");
-    env->CallVoidMethod(view, setOrientation, 1 /*vertical*/);
-    auto setGravity = env->GetMethodID(env->GetObjectClass(view), "setGravity", "(I)V");
-    env->CallVoidMethod(view, setGravity, 17 /*center*/);
-    return env->NewWeakGlobalRef(view);
+Slider::Slider() : Widget(nullptr) {
+    FLOUI_ENTRY("Slider::Slider");
+    view = (void *)CFBridgingRetain([UISlider new]);
+    //    auto v = (__bridge UISlider *)view;
 }
 
-MainView::MainView(void *m) : Widget(m) {}
-
-MainView::MainView(const FlouiViewController &, std::initializer_list<Widget> l)
-    : Widget(VStack_init()) {
-    auto env = c::env();
-    auto v = (jobject)view;
-    auto addview = env->GetMethodID(env->FindClass("android/view/ViewGroup"), "addView",
-                                    "(Landroid/view/View;)V");
-    env->CallVoidMethod(c::layout, addview, v);
-    auto getLayoutParams = env->GetMethodID(env->GetObjectClass(c::layout), "getLayoutParams",
-                                            "()Landroid/view/ViewGroup$LayoutParams;");
-    auto params = env->CallObjectMethod(v, getLayoutParams);
-    auto width = env->GetFieldID(env->GetObjectClass(params), "width", "I");
-    env->SetIntField(params, width, -1);
-    for (auto &e : l) {
-        env->CallVoidMethod(v, addview, (jobject)e.inner());
-    }
+Slider &Slider::value(double val) {
+    PROPERTY_WRITE(Slider, Value, value, val)
+    auto v = (__bridge UISlider *)view;
+    [v setValue:val];
+    return *this;
 }
 
-MainView &MainView::spacing(int) { return *this; }
-
-MainView &MainView::add(const Widget &w) {
-    auto env = c::env();
-    auto v = (jobject)view;
-    auto addview = env->GetMethodID(env->FindClass("android/view/ViewGroup"), "addView",
-                                    "(Landroid/view/View;)V");
-    env->CallVoidMethod(v, addview, (jobject)w.inner());
-    return *this;
+double Slider::value() {
+    FLOUI_ENTRY("Slider::value");
+    FlouiViewController::settle(view, Prop::Value);
+    FlouiViewController::invalidate(view, Prop::Value);
+    auto v = (__bridge UISlider *)view;
+    return v.value;
 }
 
-MainView &MainView::remove(const Widget &w) {
-    auto env = c::env();
-    auto v = (jobject)view;
-    auto removeView = env->GetMethodID(env->FindClass("android/view/ViewGroup"), "removeView",
-                                       "(Landroid/view/View;)V");
-    env->CallVoidMethod(v, removeView, (jobject)w.inner());
+Slider &Slider::action(Action &&f) {
+    FLOUI_ENTRY("Slider::action");
+    auto v = (__bridge UISlider *)view;
+    auto &callbacks = FlouiViewControllerImpl::callbacks;
+    auto slot = FlouiViewController::add_callback(std::move(f));
+    callbacks.push_back([[Callback alloc] initWithTarget:view Slot:slot]);
+    [v addTarget:callbacks.back()
+                  action:@selector(invoke)
+        forControlEvents:UIControlEventPrimaryActionTriggered];
     return *this;
 }
 
-MainView &MainView::clear() {
-    auto env = c::env();
-    auto v = (jobject)view;
-    auto removeAllViews =
-        env->GetMethodID(env->FindClass("android/view/ViewGroup"), "removeAllViews", "()V");
-    env->CallVoidMethod(v, removeAllViews);
+Slider &Slider::action(::id target, SEL s) {
+    FLOUI_ENTRY("Slider::action");
+    auto v = (__bridge UISlider *)view;
+    [v addTarget:target action:s forControlEvents:UIControlEventPrimaryActionTriggered];
     return *this;
 }
 
-DEFINE_STYLES(MainView)
+Slider &Slider::foreground(uint32_t c) { return *this; }
 
-VStack::VStack(void *m) : Widget(m) {}
+DEFINE_STYLES(Slider)
 
-VStack::VStack(std::initializer_list<Widget> l) : Widget(VStack_init()) {
-    auto env = c::env();
-    auto v = (jobject)view;
-    auto addview = env->GetMethodID(env->FindClass("android/view/ViewGroup"), "addView",
-                                    "(Landroid/view/View;)V");
-    for (auto &e : l) {
-        env->CallVoidMethod(v, addview, (jobject)e.inner());
-    }
-}
+#endif
 
-VStack &VStack::spacing(int) { return *this; }
+Text::Text(void *b) : Widget(b) {}
 
-VStack &VStack::add(const Widget &w) {
-    auto env = c::env();
-    auto v = (jobject)view;
-    auto addview = env->GetMethodID(env->FindClass("android/view/ViewGroup"), "addView",
-                                    "(Landroid/view/View;)V");
-    env->CallVoidMethod(v, addview, (jobject)w.inner());
-    return *this;
+Text::Text(const std::string &s) : Widget(nullptr) {
+    FLOUI_ENTRY("Text::Text");
+    view = (void *)CFBridgingRetain([UILabel new]);
+    auto v = (__bridge UILabel *)view;
+    [v setText:[NSString stringWithUTF8String:s.c_str()]];
+    [v setTextColor:UIColor.blackColor];
 }
 
-VStack &VStack::remove(const Widget &w) {
-    auto env = c::env();
-    auto v = (jobject)view;
-    auto removeView = env->GetMethodID(env->FindClass("android/view/ViewGroup"), "removeView",
-                                       "(Landroid/view/View;)V");
-    env->CallVoidMethod(v, removeView, (jobject)w.inner());
+Text &Text::foreground(uint32_t c) {
+    PROPERTY_WRITE(Text, Foreground, foreground, c)
+    auto v = (__bridge UILabel *)view;
+    [v setTextColor:col2uicol(c)];
     return *this;
 }
 
-VStack &VStack::clear() {
-    auto env = c::env();
-    auto v = (jobject)view;
-    auto removeAllViews =
-        env->GetMethodID(env->FindClass("android/view/ViewGroup"), "removeAllViews", "()V");
-    env->CallVoidMethod(v, removeAllViews);
+Text &Text::center() {
+    FLOUI_ENTRY("Text::center");
+    auto v = (__bridge UILabel *)view;
+    [v setTextAlignment:NSTextAlignmentCenter];
     return *this;
 }
 
-DEFINE_STYLES(VStack)
-
-void *HStack_init() {
-    auto env = c::env();
-    auto view = android_new_view("android/widget/LinearLayout");
-    auto setOrientation = env->GetMethodID(env->GetObjectClass(view), "setOrientation", "(I)V");
-    env->CallVoidMethod(view, setOrientation, 0 /*Horizontal*/);
-    auto setGravity = env->GetMethodID(env->GetObjectClass(view), "setGravity", "(I)V");
-    env->CallVoidMethod(view, setGravity, 17 /*center*/);
-    return env->NewWeakGlobalRef(view);
-}
-
-HStack::HStack(void *m) : Widget(m) {}
-
-HStack::HStack(std::initializer_list<Widget> l) : Widget(HStack_init()) {
-    auto env = c::env();
-    auto v = (jobject)view;
-    auto addview = env->GetMethodID(env->FindClass("android/view/ViewGroup"), "addView",
-                                    "(Landroid/view/View;)V");
-    for (auto &e : l) {
-        env->CallVoidMethod(v, addview, (jobject)e.inner());
-    }
+Text &Text::left() {
+    FLOUI_ENTRY("Text::left");
+    auto v = (__bridge UILabel *)view;
+    [v setTextAlignment:NSTextAlignmentLeft];
+    return *this;
 }
 
-HStack &HStack::spacing(int) { return *this; }
-
-HStack &HStack::add(const Widget &w) {
-    auto env = c::env();
-    auto v = (jobject)view;
-    auto addview = env->GetMethodID(env->FindClass("android/view/ViewGroup"), "addView",
-                                    "(Landroid/view/View;)V");
-    env->CallVoidMethod(v, addview, (jobject)w.inner());
+Text &Text::right() {
+    FLOUI_ENTRY("Text::right");
+    auto v = (__bridge UILabel *)view;
+    [v setTextAlignment:NSTextAlignmentRight];
     return *this;
 }
 
-HStack &HStack::remove(const Widget &w) {
-    auto env = c::env();
-    auto v = (jobject)view;
-    auto removeView = env->GetMethodID(env->FindClass("android/view/ViewGroup"), "removeView",
-                                       "(Landroid/view/View;)V");
-    env->CallVoidMethod(v, removeView, (jobject)w.inner());
+Text &Text::text(const std::string &s) {
+    PROPERTY_WRITE(Text, Text, text, s)
+    auto v = (__bridge UILabel *)view;
+    [v setText:[NSString stringWithUTF8String:s.c_str()]];
     return *this;
 }
 
-HStack &HStack::clear() {
-    auto env = c::env();
-    auto v = (jobject)view;
-    auto removeAllViews =
-        env->GetMethodID(env->FindClass("android/view/ViewGroup"), "removeAllViews", "()V");
-    env->CallVoidMethod(v, removeAllViews);
+Text &Text::fontsize(int size) {
+    PROPERTY_WRITE(Text, Fontsize, fontsize, size)
+    auto v = (__bridge UILabel *)view;
+    [v setFont:[UIFont systemFontOfSize:size]];
     return *this;
 }
 
-DEFINE_STYLES(HStack)
-
-void *ImageView_init(const std::string &path) {
-    auto env = c::env();
-    auto getResources = env->GetMethodID(env->GetObjectClass(c::main_activity), "getResources",
-                                         "()Landroid/content/res/Resources;");
-    auto resources = env->CallObjectMethod(c::main_activity, getResources);
-    auto getPackageName = env->GetMethodID(env->GetObjectClass(c::main_activity), "getPackageName",
-                                           "()Ljava/lang/String;");
-    auto packageName = env->CallObjectMethod(c::main_activity, getPackageName);
-    auto getIdentifier =
-        env->GetMethodID(env->GetObjectClass(resources), "getIdentifier",
-                         "(Ljava/lang/String;Ljava/lang/String;Ljava/lang/String;)I");
-    auto resId = env->CallIntMethod(resources, getIdentifier,
-                                    env->NewStringUTF(path.substr(0, path.find('.')).c_str()),
-                                    env->NewStringUTF("drawable"), packageName);
-    auto view = android_new_view("android/widget/ImageView");
-    auto setImageResource =
-        env->GetMethodID(env->FindClass("android/widget/ImageView"), "setImageResource", "(I)V");
-    env->CallVoidMethod(view, setImageResource, resId);
-    return env->NewWeakGlobalRef(view);
+Text &Text::bold() {
+    FLOUI_ENTRY("Text::bold");
+    auto v = (__bridge UILabel *)view;
+    [v setFont:[UIFont boldSystemFontOfSize:v.font.pointSize]];
+    return *this;
 }
 
-void *ImageView_init() {
-    auto env = c::env();
-    auto view = android_new_view("android/widget/ImageView");
-    return env->NewWeakGlobalRef(view);
+Text &Text::italic() {
+    FLOUI_ENTRY("Text::italic");
+    auto v = (__bridge UILabel *)view;
+    [v setFont:[UIFont italicSystemFontOfSize:v.font.pointSize]];
+    return *this;
 }
 
-ImageView::ImageView(void *v) : Widget(v) {}
-
-ImageView::ImageView() : Widget(ImageView_init()) {}
-
-ImageView::ImageView(const std::string &path) : Widget(ImageView_init(path)) {}
-
-ImageView &ImageView::image(const std::string &path) {
-    auto env = c::env();
-    auto v = (jobject)view;
-    auto getResources = env->GetMethodID(env->GetObjectClass(c::main_activity), "getResources",
-                                         "()Landroid/content/res/Resources;");
-    auto resources = env->CallObjectMethod(c::main_activity, getResources);
-    auto getPackageName = env->GetMethodID(env->GetObjectClass(c::main_activity), "getPackageName",
-                                           "()Ljava/lang/String;");
-    auto packageName = env->CallObjectMethod(c::main_activity, getPackageName);
-    auto getIdentifier =
-        env->GetMethodID(env->GetObjectClass(resources), "getIdentifier",
-                         "(Ljava/lang/String;Ljava/lang/String;Ljava/lang/String;)I");
-    auto resId = env->CallIntMethod(resources, getIdentifier,
-                                    env->NewStringUTF(path.substr(0, path.find('.')).c_str()),
-                                    env->NewStringUTF("drawable"), packageName);
-    auto setImageResource =
-        env->GetMethodID(env->FindClass("android/widget/ImageView"), "setImageResource", "(I)V");
-    env->CallVoidMethod(v, setImageResource, resId);
+Text &Text::normal() {
+    FLOUI_ENTRY("Text::normal");
+    auto v = (__bridge UILabel *)view;
+    [v setFont:[UIFont systemFontOfSize:v.font.pointSize]];
     return *this;
 }
 
-DEFINE_STYLES(ImageView)
-
-void *WebView_init() {
-    auto env = c::env();
-    auto view = android_new_view("android/webkit/WebView");
-    return env->NewWeakGlobalRef(view);
-}
+DEFINE_STYLES(Text)
 
-WebView::WebView(void *v) : Widget(v) {}
+TextField::TextField(void *b) : Widget(b) {}
 
-WebView::WebView() : Widget(WebView_init()) {}
+TextField::TextField() : Widget(nullptr) {
+    FLOUI_ENTRY("TextField::TextField");
+    view = (void *)CFBridgingRetain([UITextField new]);
+    auto v = (__bridge UITextField *)view;
+    [v setTextColor:UIColor.blackColor];
+    auto &target = FlouiViewControllerImpl::text_changed;
+    if (!target)
+        target = [TextChanged new];
+    [v addTarget:target action:@selector(changed:) forControlEvents:UIControlEventEditingChanged];
+}
 
-WebView &WebView::load_file_url(const std::string &local_path) {
-    auto env = c::env();
-    auto v = (jobject)view;
-    auto loadUrl = env->GetMethodID(env->GetObjectClass(v), "loadUrl", "(Ljava/lang/String;)V");
-    auto path = std::string("file:///android_asset/" +
-                            local_path.substr(local_path.find("file:///") + 8, local_path.size()));
-    env->CallVoidMethod(v, loadUrl, env->NewStringUTF(path.c_str()));
+TextField &TextField::foreground(uint32_t c) {
+    PROPERTY_WRITE(TextField, Foreground, foreground, c)
+    auto v = (__bridge UITextField *)view;
+    [v setTextColor:col2uicol(c)];
     return *this;
 }
 
-WebView &WebView::load_http_url(const std::string &path) {
-    auto env = c::env();
-    auto v = (jobject)view;
-    auto loadUrl = env->GetMethodID(env->GetObjectClass(v), "loadUrl", "(Ljava/lang/String;)V");
-    env->CallVoidMethod(v, loadUrl, env->NewStringUTF(path.c_str()));
+TextField &TextField::center() {
+    FLOUI_ENTRY("TextField::center");
+    auto v = (__bridge UITextField *)view;
+    [v setTextAlignment:NSTextAlignmentCenter];
     return *this;
 }
 
-WebView &WebView::load_html(const std::string &html) {
-    auto env = c::env();
-    auto v = (jobject)view;
-    auto loadData = env->GetMethodID(env->GetObjectClass(v), "loadDataWithBaseURL",
-                                     "(Ljava/lang/String;Ljava/lang/String;Ljava/lang/String;Ljava/"
-                                     "lang/String;Ljava/lang/String;)V");
-    env->CallVoidMethod(v, loadData, nullptr, env->NewStringUTF(html.c_str()),
-                        env->NewStringUTF("text/html"), env->NewStringUTF("utf-8"), nullptr);
+TextField &TextField::left() {
+    FLOUI_ENTRY("TextField::left");
+    auto v = (__bridge UITextField *)view;
+    [v setTextAlignment:NSTextAlignmentLeft];
     return *this;
 }
 
-WebView &WebView::load_url(const std::string &url) {
-    if (url.find("file://") == 0) {
-        load_file_url(url);
-    } else {
-        load_http_url(url);
-    }
+TextField &TextField::right() {
+    FLOUI_ENTRY("TextField::right");
+    auto v = (__bridge UITextField *)view;
+    [v setTextAlignment:NSTextAlignmentRight];
     return *this;
 }
 
-DEFINE_STYLES(WebView)
 
-void *ScrollView_init() {
-    auto env = c::env();
-    auto view = android_new_view("android/widget/ScrollView");
-    return env->NewWeakGlobalRef(view);
+TextField &TextField::text(const std::string &s) {
+    PROPERTY_WRITE(TextField, Text, text, s)
+    auto v = (__bridge UITextField *)view;
+    [v setText:[NSString stringWithUTF8String:s.c_str()]];
+    return *this;
 }
 
-ScrollView::ScrollView(void *v) : Widget(v) {}
-
-ScrollView::ScrollView(const Widget &w) : Widget(ScrollView_init()) {
-    auto env = c::env();
-    auto v = (jobject)view;
-    auto addview = env->GetMethodID(env->FindClass("android/view/ViewGroup"), "addView",
-                                    "(Landroid/view/View;)V");
-    env->CallVoidMethod(v, addview, (jobject)w.inner());
+std::string TextField::text() const {
+    FLOUI_ENTRY("TextField::text");
+    FlouiViewController::settle(view, Prop::Text);
+    FlouiViewController::invalidate(view, Prop::Text);
+    return std::string([((__bridge UITextField *)view).text UTF8String]);
 }
 
-DEFINE_STYLES(ScrollView)
+TextField &TextField::fontsize(int size) {
+    PROPERTY_WRITE(TextField, Fontsize, fontsize, size)
+    auto v = (__bridge UITextField *)view;
+    [v setFont:[UIFont systemFontOfSize:size]];
+    return *this;
+}
 
-#elif defined(__APPLE__) && defined(__OBJC__)
+DEFINE_STYLES(TextField)
 
-#import <Foundation/Foundation.h>
-#include <TargetConditionals.h>
+Spacer::Spacer(void *b) : Widget(b) {}
 
-@interface Callback : NSObject {
-    std::function<void(Widget &)> *fn_;
-    void *target_;
+Spacer::Spacer() : Widget(nullptr) {
+    FLOUI_ENTRY("Spacer::Spacer");
+    view = (void *)CFBridgingRetain([UIView new]);
 }
-- (id)initWithTarget:(void *)target Cb:(const std::function<void(Widget &)> &)f;
-- (void)invoke;
-- (void)dealloc;
-@end
-
-void floui_log0(const char *s) { NSLog(@"%@", [NSString stringWithUTF8String:s]); }
 
-int floui_log(const char *s) {
-    floui_log0(s);
-    return 0;
-}
+DEFINE_STYLES(Spacer)
 
-@implementation Callback
-- (id)initWithTarget:(void *)target Cb:(const std::function<void(Widget &)> &)f {
-    self = [super init];
-    fn_ = new std::function<void(Widget &)>(f);
-    target_ = target;
-    return self;
-}
-- (void)invoke {
-    auto w = Widget(target_);
-    (*fn_)(w);
-}
-- (void)dealloc {
-    delete fn_;
-    fn_ = nil;
+/// Arranges views in stack, replacing its subviews if replace. The size constraints of all the
+/// views are activated together, and UIKit lays the stack out once in the next layout pass
+static void ios_splice(UIStackView *stack, const std::vector<void *> &views, bool replace) {
+    if (replace) {
+        for (UIView *view in [stack subviews]) {
+            [view removeFromSuperview];
+        }
+    }
+    auto constraints = [NSMutableArray arrayWithCapacity:views.size() * 2];
+    for (auto view : views) {
+        auto w = (__bridge UIView *)view;
+        w.translatesAutoresizingMaskIntoConstraints = NO;
+        [stack addArrangedSubview:w];
+        if (w.frame.size.width != 0)
+            [constraints addObject:[w.widthAnchor constraintEqualToConstant:w.frame.size.width]];
+        if (w.frame.size.height != 0)
+            [constraints addObject:[w.heightAnchor constraintEqualToConstant:w.frame.size.height]];
+    }
+    [NSLayoutConstraint activateConstraints:constraints];
 }
-@end
-
-#if TARGET_OS_IPHONE
-// ios stuff
-#import <UIKit/UIKit.h>
-#import <WebKit/WKWebView.h>
 
-struct FlouiViewControllerImpl {
-    static inline UIViewController *vc = nullptr;
-    static inline const char *name = nullptr;
-    static inline std::vector<Callback *> callbacks = {};
+MainView::MainView(void *v) : Widget(v) {}
 
-    FlouiViewControllerImpl(UIViewController *vc, const char *name, void *) {
-        FlouiViewControllerImpl::vc = vc;
-        FlouiViewControllerImpl::name = name;
+MainView::MainView(const FlouiViewController &, std::initializer_list<Widget> l) : Widget(nullptr) {
+    FLOUI_ENTRY("MainView::MainView");
+    view = (void *)CFBridgingRetain([UIStackView new]);
+    auto v = (__bridge UIStackView *)view;
+    v.translatesAutoresizingMaskIntoConstraints = NO;
+    auto vc = FlouiViewControllerImpl::vc;
+    auto label = [UILabel new];
+    auto name = FlouiViewControllerImpl::name;
+    if (name) {
+        [label setText:[NSString stringWithUTF8String:name]];
+    } else {
+        [label setText:[[[NSBundle mainBundle] infoDictionary] objectForKey:@"CFBundleName"]];
     }
-};
-
-FlouiViewController::FlouiViewController(void *vc, void *name, void *)
-    : impl(new FlouiViewControllerImpl((__bridge UIViewController *)vc, (const char *)name,
-                                       nullptr)) {}
+#if TARGET_OS_TV
+    [label setTextColor:UIColor.whiteColor];
+    label.backgroundColor = UIColor.systemGrayColor;
+#else
+    [label setTextColor:UIColor.blackColor];
+    label.backgroundColor = UIColor.systemGray5Color;
+#endif
+    [label setFont:[UIFont boldSystemFontOfSize:30]];
+    [label setTextAlignment:NSTextAlignmentCenter];
+    label.frame = CGRectMake(0, 0, vc.view.frame.size.width, 120);
+    [vc.view addSubview:label];
+    [vc.view addSubview:v];
+    [v setAxis:UILayoutConstraintAxisVertical];
+    [v setDistribution:UIStackViewDistributionEqualSpacing];
+    [v setAlignment:UIStackViewAlignmentCenter];
+    [v setSpacing:10];
+    [v setContentHuggingPriority:UILayoutPriorityRequired forAxis:UILayoutConstraintAxisHorizontal];
+    [v.widthAnchor constraintEqualToConstant:vc.view.frame.size.width].active = YES;
+    [v.topAnchor constraintEqualToAnchor:label.bottomAnchor constant:20].active = YES;
+    for (auto &e : l) {
+        auto w = (__bridge UIView *)e.inner();
+        w.translatesAutoresizingMaskIntoConstraints = NO;
+        [v addArrangedSubview:w];
+        if (w.frame.size.width != 0)
+            [w.widthAnchor constraintEqualToConstant:w.frame.size.width].active = YES;
+        if (w.frame.size.height != 0)
+            [w.heightAnchor constraintEqualToConstant:w.frame.size.height].active = YES;
+    }
+}
 
-void FlouiViewController::handle_events(void *) { return; }
+MainView &MainView::spacing(int val) {
+    FLOUI_ENTRY("MainView::spacing");
+    auto v = (__bridge UIStackView *)view;
+    [v setSpacing:val];
+    return *this;
+}
 
-FlouiViewController::~FlouiViewController() { delete impl; }
+MainView &MainView::add(const Widget &w) {
+    FLOUI_ENTRY("MainView::add");
+    auto v = (__bridge UIStackView *)view;
+    auto i = (__bridge UIView *)w.inner();
+    i.translatesAutoresizingMaskIntoConstraints = NO;
+    [v addArrangedSubview:i];
+    if (i.frame.size.width != 0)
+        [i.widthAnchor constraintEqualToConstant:i.frame.size.width].active = YES;
+    if (i.frame.size.height != 0)
+        [i.heightAnchor constraintEqualToConstant:i.frame.size.height].active = YES;
+    return *this;
+}
 
-Color Color::system_purple() {
-    CGFloat r = 0, g = 0, b = 0, a = 0;
-    [UIColor.purpleColor getRed:&r green:&g blue:&b alpha:&a];
-    return Color(
-        ((uint32_t)(r * 255) << 24 | (uint32_t)(g * 255) << 16 | (uint32_t)(b * 255) << 8) |
-        (uint32_t)(a * 255));
+MainView &MainView::insert(const Widget &w, int index) {
+    FLOUI_ENTRY("MainView::insert");
+    auto v = (__bridge UIStackView *)view;
+    auto i = (__bridge UIView *)w.inner();
+    i.translatesAutoresizingMaskIntoConstraints = NO;
+    auto count = v.arrangedSubviews.count;
+    [v insertArrangedSubview:i atIndex:index < 0 ? count : MIN((NSUInteger)index, count)];
+    if (i.frame.size.width != 0)
+        [i.widthAnchor constraintEqualToConstant:i.frame.size.width].active = YES;
+    if (i.frame.size.height != 0)
+        [i.heightAnchor constraintEqualToConstant:i.frame.size.height].active = YES;
+    return *this;
 }
 
-static UIColor *col2uicol(uint32_t col) {
-    auto r = ((col >> 24) & 0xFF) / 255.0;
-    auto g = ((col >> 16) & 0xFF) / 255.0;
-    auto b = ((col >> 8) & 0xFF) / 255.0;
-    auto a = ((col)&0xFF) / 255.0;
-    return [UIColor colorWithRed:r green:g blue:b alpha:a];
+MainView &MainView::remove(const Widget &w) {
+    FLOUI_ENTRY("MainView::remove");
+    auto v = (__bridge UIStackView *)view;
+    auto i = (__bridge UIView *)w.inner();
+    if ([i isDescendantOfView:v])
+        [i removeFromSuperview];
+    return *this;
 }
 
-#define DEFINE_STYLES(widget)                                                                      \
-    widget &widget::background(uint32_t col) {                                                     \
-        auto v = (__bridge UIView *)view;                                                          \
-        v.backgroundColor = col2uicol(col);                                                        \
-        return *this;                                                                              \
-    }                                                                                              \
-    widget &widget::id(const char *val) {                                                          \
-        widget_map[val] = view;                                                                    \
-        return *this;                                                                              \
-    }                                                                                              \
-    widget &widget::size(int w, int h) {                                                           \
-        auto v = (__bridge UIView *)view;                                                          \
-        auto frame = v.frame;                                                                      \
-        frame.size.width = w;                                                                      \
-        frame.size.height = h;                                                                     \
-        v.frame = frame;                                                                           \
-        return *this;                                                                              \
+MainView &MainView::clear() {
+    FLOUI_ENTRY("MainView::clear");
+    auto v = (__bridge UIStackView *)view;
+    for (UIView *view in [v subviews]) {
+        [view removeFromSuperview];
     }
+    return *this;
+}
 
-Widget::Widget(void *v) : view(v) {}
+MainView &MainView::splice(const std::vector<void *> &views, bool replace) {
+    FLOUI_ENTRY("MainView::splice");
+    ios_splice((__bridge UIStackView *)view, views, replace);
+    return *this;
+}
 
-void *Widget::inner() const { return view; }
+DEFINE_STYLES(MainView)
 
-DEFINE_STYLES(Widget)
+VStack::VStack(void *v) : Widget(v) {}
 
-Button::Button(void *b) : Widget(b) {}
+VStack::VStack(std::initializer_list<Widget> l) : Widget(nullptr) {
+    FLOUI_ENTRY("VStack::VStack");
+    view = (void *)CFBridgingRetain([UIStackView new]);
+    auto v = (__bridge UIStackView *)view;
+    [v setAxis:UILayoutConstraintAxisVertical];
+    [v setDistribution:UIStackViewDistributionFillEqually];
+    [v setAlignment:UIStackViewAlignmentCenter];
+    [v setSpacing:10];
+    for (auto &e : l) {
+        auto w = (__bridge UIView *)e.inner();
+        w.translatesAutoresizingMaskIntoConstraints = NO;
+        [v addArrangedSubview:w];
+        if (w.frame.size.width != 0)
+            [w.widthAnchor constraintEqualToConstant:w.frame.size.width].active = YES;
+        if (w.frame.size.height != 0)
+            [w.heightAnchor constraintEqualToConstant:w.frame.size.height].active = YES;
+    }
+}
 
-Button::Button(const std::string &label)
-    : Widget((void *)CFBridgingRetain([UIButton buttonWithType:UIButtonTypeCustom])) {
-    auto v = (__bridge UIButton *)view;
-    [v setTitle:[NSString stringWithUTF8String:label.c_str()] forState:UIControlStateNormal];
-    [v setTitleColor:UIColor.blueColor forState:UIControlStateNormal];
+VStack &VStack::spacing(int val) {
+    FLOUI_ENTRY("VStack::spacing");
+    auto v = (__bridge UIStackView *)view;
+    [v setSpacing:val];
+    return *this;
 }
 
-Button &Button::filled() {
-    ((__bridge UIButton *)view).configuration = [UIButtonConfiguration filledButtonConfiguration];
+VStack &VStack::add(const Widget &w) {
+    FLOUI_ENTRY("VStack::add");
+    auto v = (__bridge UIStackView *)view;
+    auto i = (__bridge UIView *)w.inner();
+    i.translatesAutoresizingMaskIntoConstraints = NO;
+    [v addArrangedSubview:i];
+    if (i.frame.size.width != 0)
+        [i.widthAnchor constraintEqualToConstant:i.frame.size.width].active = YES;
+    if (i.frame.size.height != 0)
+        [i.heightAnchor constraintEqualToConstant:i.frame.size.height].active = YES;
     return *this;
 }
 
-Button &Button::action(std::function<void(Widget &)> &&f) {
-    auto v = (__bridge UIButton *)view;
-    auto &callbacks = FlouiViewControllerImpl::callbacks;
-    callbacks.push_back([[Callback alloc] initWithTarget:view Cb:f]);
-    [v addTarget:callbacks.back()
-                  action:@selector(invoke)
-        forControlEvents:UIControlEventPrimaryActionTriggered];
+VStack &VStack::insert(const Widget &w, int index) {
+    FLOUI_ENTRY("VStack::insert");
+    auto v = (__bridge UIStackView *)view;
+    auto i = (__bridge UIView *)w.inner();
+    i.translatesAutoresizingMaskIntoConstraints = NO;
+    auto count = v.arrangedSubviews.count;
+    [v insertArrangedSubview:i atIndex:index < 0 ? count : MIN((NSUInteger)index, count)];
+    if (i.frame.size.width != 0)
+        [i.widthAnchor constraintEqualToConstant:i.frame.size.width].active = YES;
+    if (i.frame.size.height != 0)
+        [i.heightAnchor constraintEqualToConstant:i.frame.size.height].active = YES;
     return *this;
 }
 
-Button &Button::action(::id target, SEL s) {
-    auto v = (__bridge UIButton *)view;
-    [v addTarget:target action:s forControlEvents:UIControlEventPrimaryActionTriggered];
+VStack &VStack::remove(const Widget &w) {
+    FLOUI_ENTRY("VStack::remove");
+    auto v = (__bridge UIStackView *)view;
+    auto i = (__bridge UIView *)w.inner();
+    if ([i isDescendantOfView:v])
+        [i removeFromSuperview];
     return *this;
 }
 
-Button &Button::foreground(uint32_t c) {
-    auto v = (__bridge UIButton *)view;
-    [v setTitleColor:col2uicol(c) forState:UIControlStateNormal];
+VStack &VStack::clear() {
+    FLOUI_ENTRY("VStack::clear");
+    auto v = (__bridge UIStackView *)view;
+    for (UIView *view in [v subviews]) {
+        [view removeFromSuperview];
+    }
     return *this;
 }
 
-DEFINE_STYLES(Button)
+VStack &VStack::splice(const std::vector<void *> &views, bool replace) {
+    FLOUI_ENTRY("VStack::splice");
+    ios_splice((__bridge UIStackView *)view, views, replace);
+    return *this;
+}
 
-#if !TARGET_OS_TV
+DEFINE_STYLES(VStack)
 
-Toggle::Toggle(void *b) : Widget(b) {}
+HStack::HStack(void *v) : Widget(v) {}
 
-Toggle::Toggle(const std::string &label) : Widget((void *)CFBridgingRetain([UIStackView new])) {
+HStack::HStack(std::initializer_list<Widget> l) : Widget(nullptr) {
+    FLOUI_ENTRY("HStack::HStack");
+    view = (void *)CFBridgingRetain([UIStackView new]);
     auto v = (__bridge UIStackView *)view;
     [v setAxis:UILayoutConstraintAxisHorizontal];
     [v setDistribution:UIStackViewDistributionFillEqually];
     [v setAlignment:UIStackViewAlignmentCenter];
     [v setSpacing:10];
-    auto l = [UILabel new];
-    [l setText:[NSString stringWithUTF8String:label.c_str()]];
-    [v addArrangedSubview:l];
-    auto s = [UISwitch new];
-    [v addArrangedSubview:s];
+    for (auto &e : l) {
+        auto w = (__bridge UIView *)e.inner();
+        w.translatesAutoresizingMaskIntoConstraints = NO;
+        [v addArrangedSubview:w];
+        if (w.frame.size.width != 0)
+            [w.widthAnchor constraintEqualToConstant:w.frame.size.width].active = YES;
+        if (w.frame.size.height != 0)
+            [w.heightAnchor constraintEqualToConstant:w.frame.size.height].active = YES;
+    }
 }
 
-Toggle &Toggle::value(bool val) {
+HStack &HStack::spacing(int val) {
+    FLOUI_ENTRY("HStack::spacing");
     auto v = (__bridge UIStackView *)view;
-    auto o = [[v subviews] lastObject];
-    [(UISwitch *)o setOn:val animated:YES];
+    [v setSpacing:val];
     return *this;
 }
 
-bool Toggle::value() {
-    auto v = (__bridge UISwitch *)view;
-    auto o = (UISwitch *)[[v subviews] lastObject];
-    return o.on;
+HStack &HStack::add(const Widget &w) {
+    FLOUI_ENTRY("HStack::add");
+    auto v = (__bridge UIStackView *)view;
+    auto i = (__bridge UIView *)w.inner();
+    i.translatesAutoresizingMaskIntoConstraints = NO;
+    [v addArrangedSubview:i];
+    if (i.frame.size.width != 0)
+        [i.widthAnchor constraintEqualToConstant:i.frame.size.width].active = YES;
+    if (i.frame.size.height != 0)
+        [i.heightAnchor constraintEqualToConstant:i.frame.size.height].active = YES;
+    return *this;
 }
 
-Toggle &Toggle::action(std::function<void(Widget &)> &&f) {
-    auto v = (__bridge UISwitch *)view;
-    auto o = [[v subviews] lastObject];
-    auto &callbacks = FlouiViewControllerImpl::callbacks;
-    callbacks.push_back([[Callback alloc] initWithTarget:view Cb:f]);
-    [(UISwitch *)o addTarget:callbacks.back()
-                      action:@selector(invoke)
-            forControlEvents:UIControlEventPrimaryActionTriggered];
+HStack &HStack::insert(const Widget &w, int index) {
+    FLOUI_ENTRY("HStack::insert");
+    auto v = (__bridge UIStackView *)view;
+    auto i = (__bridge UIView *)w.inner();
+    i.translatesAutoresizingMaskIntoConstraints = NO;
+    auto count = v.arrangedSubviews.count;
+    [v insertArrangedSubview:i atIndex:index < 0 ? count : MIN((NSUInteger)index, count)];
+    if (i.frame.size.width != 0)
+        [i.widthAnchor constraintEqualToConstant:i.frame.size.width].active = YES;
+    if (i.frame.size.height != 0)
+        [i.heightAnchor constraintEqualToConstant:i.frame.size.height].active = YES;
     return *this;
 }
 
-Toggle &Toggle::action(::id target, SEL s) {
-    auto v = (__bridge UISwitch *)view;
-    auto o = [[v subviews] lastObject];
-    [(UISwitch *)o addTarget:target action:s forControlEvents:UIControlEventPrimaryActionTriggered];
+HStack &HStack::remove(const Widget &w) {
+    FLOUI_ENTRY("HStack::remove");
+    auto v = (__bridge UIStackView *)view;
+    auto i = (__bridge UIView *)w.inner();
+    if ([i isDescendantOfView:v])
+        [i removeFromSuperview];
     return *this;
 }
 
-Toggle &Toggle::foreground(uint32_t c) { return *this; }
+HStack &HStack::clear() {
+    FLOUI_ENTRY("HStack::clear");
+    auto v = (__bridge UIStackView *)view;
+    for (UIView *view in [v subviews]) {
+        [view removeFromSuperview];
+    }
+    return *this;
+}
 
-DEFINE_STYLES(Toggle)
+HStack &HStack::splice(const std::vector<void *> &views, bool replace) {
+    FLOUI_ENTRY("HStack::splice");
+    ios_splice((__bridge UIStackView *)view, views, replace);
+    return *this;
+}
 
-Check::Check(void *b) : Widget(b) {}
+DEFINE_STYLES(HStack)
 
-Check::Check(const std::string &label) : Widget((void *)CFBridgingRetain([UIStackView new])) {
-    auto v = (__bridge UIStackView *)view;
-    [v setAxis:UILayoutConstraintAxisHorizontal];
-    [v setDistribution:UIStackViewDistributionFillEqually];
-    [v setAlignment:UIStackViewAlignmentCenter];
-    [v setSpacing:10];
-    auto l = [UILabel new];
-    [l setText:[NSString stringWithUTF8String:label.c_str()]];
-    [v addArrangedSubview:l];
-    auto s = [UISwitch new];
-    [s setPreferredStyle:UISwitchStyleCheckbox];
-    [v addArrangedSubview:s];
+ImageView::ImageView(void *v) : Widget(v) {}
+
+ImageView::ImageView() : Widget(nullptr) {
+    FLOUI_ENTRY("ImageView::ImageView");
+    view = (void *)CFBridgingRetain([UIImageView new]);
 }
 
-Check &Check::value(bool val) {
-    auto v = (__bridge UIStackView *)view;
-    auto o = [[v subviews] lastObject];
-    [(UISwitch *)o setOn:val animated:YES];
+ImageView::ImageView(const std::string &path) : Widget(nullptr) {
+    FLOUI_ENTRY("ImageView::ImageView");
+    view = (void *)CFBridgingRetain([UIImageView new]);
+    auto i = [UIImage imageNamed:[NSString stringWithUTF8String:path.c_str()]];
+    auto v = (__bridge UIImageView *)view;
+    [v setImage:i];
+    [v setContentMode:UIViewContentModeScaleAspectFit];
+}
+
+ImageView &ImageView::image(const std::string &path) {
+    PROPERTY_WRITE(ImageView, Image, image, path)
+    auto v = (__bridge UIImageView *)view;
+    auto i = [UIImage imageNamed:[NSString stringWithUTF8String:path.c_str()]];
+    [v setImage:i];
+    return *this;
+}
+
+DEFINE_STYLES(ImageView)
+
+#ifdef FLOUI_IOS_WEBVIEW
+
+WebView::WebView(void *v) : Widget(v) {}
+
+WebView::WebView() : Widget(nullptr) {
+    FLOUI_ENTRY("WebView::WebView");
+    view = (void *)CFBridgingRetain([WKWebView new]);
+    auto vc = FlouiViewControllerImpl::vc;
+    auto frame = vc.view.frame;
+    Widget(view).size(frame.size.width, frame.size.height - 120);
+}
+
+std::string get_ext(const std::string &http) {
+    return http.substr(http.find_last_of('.') + 1, http.size());
+}
+
+std::string get_stem(const std::string &http) {
+    return http.substr(http.find_last_of('/') + 1, http.find('.') - http.find_last_of('/') - 1);
+}
+
+std::string get_subdir(const std::string &http) {
+    auto last = http.find_last_of('/');
+    if (last == 7) {
+        return "";
+    }
+    return http.substr(http.find_first_of("file:///") + 8, last - 8);
+}
+
+WebView &WebView::load_file_url(const std::string &local_path) {
+    FLOUI_ENTRY("WebView::load_file_url");
+    auto v = (__bridge WKWebView *)view;
+    auto bundle = [NSBundle mainBundle];
+    auto stem = [NSString stringWithUTF8String:get_stem(local_path).c_str()];
+    auto ext = [NSString stringWithUTF8String:get_ext(local_path).c_str()];
+    auto dir = [NSString stringWithUTF8String:get_subdir(local_path).c_str()];
+    auto url = [bundle URLForResource:stem withExtension:ext subdirectory:dir];
+    [v loadFileURL:url allowingReadAccessToURL:url.URLByDeletingLastPathComponent];
     return *this;
 }
 
-bool Check::value() {
-    auto v = (__bridge UISwitch *)view;
-    auto o = (UISwitch *)[[v subviews] lastObject];
-    return o.on;
+WebView &WebView::load_http_url(const std::string &path) {
+    FLOUI_ENTRY("WebView::load_http_url");
+    auto v = (__bridge WKWebView *)view;
+    [v loadRequest:[NSURLRequest
+                       requestWithURL:[NSURL
+                                          URLWithString:[NSString
+                                                            stringWithUTF8String:path.c_str()]]]];
+    return *this;
 }
 
-Check &Check::action(std::function<void(Widget &)> &&f) {
-    auto v = (__bridge UISwitch *)view;
-    auto o = [[v subviews] lastObject];
-    auto &callbacks = FlouiViewControllerImpl::callbacks;
-    callbacks.push_back([[Callback alloc] initWithTarget:view Cb:f]);
-    [(UISwitch *)o addTarget:callbacks.back()
-                      action:@selector(invoke)
-            forControlEvents:UIControlEventPrimaryActionTriggered];
+WebView &WebView::load_html(const std::string &path) {
+    FLOUI_ENTRY("WebView::load_html");
+    auto v = (__bridge WKWebView *)view;
+    [v loadHTMLString:[NSString stringWithUTF8String:path.c_str()] baseURL:nil];
     return *this;
 }
 
-Check &Check::action(::id target, SEL s) {
-    auto v = (__bridge UISwitch *)view;
-    auto o = [[v subviews] lastObject];
-    [(UISwitch *)o addTarget:target action:s forControlEvents:UIControlEventPrimaryActionTriggered];
+WebView &WebView::load_url(const std::string &url) {
+    FLOUI_ENTRY("WebView::load_url");
+    if (url.find("file://") == 0) {
+        load_file_url(url);
+    } else {
+        load_http_url(url);
+    }
     return *this;
 }
 
-Check &Check::foreground(uint32_t c) { return *this; }
+DEFINE_STYLES(WebView)
 
-DEFINE_STYLES(Check)
+#endif // FLOUI_IOS_WEBVIEW
 
-Slider::Slider(void *b) : Widget(b) {}
+ScrollView::ScrollView(void *v) : Widget(v) {}
 
-Slider::Slider() : Widget((void *)CFBridgingRetain([UISlider new])) {
-    //    auto v = (__bridge UISlider *)view;
+ScrollView::ScrollView(const Widget &w) : Widget(nullptr) {
+    FLOUI_ENTRY("ScrollView::ScrollView");
+    view = (void *)CFBridgingRetain([UIScrollView new]);
+    auto v = (__bridge UIScrollView *)view;
+    auto i = (__bridge UIView *)w.inner();
+    i.translatesAutoresizingMaskIntoConstraints = NO;
+    [v addSubview:i];
+    if (i.frame.size.width != 0)
+        [i.widthAnchor constraintEqualToConstant:i.frame.size.width].active = YES;
+    if (i.frame.size.height != 0)
+        [i.heightAnchor constraintEqualToConstant:i.frame.size.height].active = YES;
+    if (LazyStack::lazy(w.inner())) {
+        auto &delegate = FlouiViewControllerImpl::lazy_scroll;
+        if (!delegate)
+            delegate = [LazyScroll new];
+        v.delegate = delegate;
+        LazyStack::attach((int64_t)(intptr_t)view, w.inner());
+    }
 }
 
-Slider &Slider::value(double val) {
-    auto v = (__bridge UISlider *)view;
-    [v setValue:val];
-    return *this;
-}
+DEFINE_STYLES(ScrollView)
 
-double Slider::value() {
-    auto v = (__bridge UISlider *)view;
-    return v.value;
+/// Views are retained by their widget's constructor, and stacks arrange floui's widgets, so the
+/// child and the views arranged under it are released
+void Widget::destroy(void *view) {
+    auto v = (__bridge UIView *)view;
+    if ([v isKindOfClass:[UIStackView class]]) {
+        for (UIView *child in [(UIStackView *)v arrangedSubviews])
+            destroy((__bridge void *)child);
+    }
+    discard(view);
+    [v removeFromSuperview];
+    CFBridgingRelease(view);
+}
+
+/// UIKit only renders once per run loop turn, so the properties are set one after the other, but
+/// the font is made once from the size and style instead of per setter
+void Style::show(void *view, const Style &s) {
+    static constexpr NSTextAlignment alignment[] = {NSTextAlignmentLeft, NSTextAlignmentCenter,
+                                                    NSTextAlignmentRight};
+    auto v = (__bridge UIView *)view;
+    if (s.has(Background))
+        v.backgroundColor = col2uicol(s.background());
+    // Like Text::fontsize, a size alone makes the font regular
+    auto font = [&](UIFont *current) {
+        auto size = s.has(Fontsize) ? (CGFloat)s.fontsize() : current.pointSize;
+        auto style = s.has(Font) ? s.font() : FontStyle::Normal;
+        if (style == FontStyle::Bold)
+            return [UIFont boldSystemFontOfSize:size];
+        if (style == FontStyle::Italic)
+            return [UIFont italicSystemFontOfSize:size];
+        return [UIFont systemFontOfSize:size];
+    };
+    if ([v isKindOfClass:[UILabel class]]) {
+        auto l = (UILabel *)v;
+        if (s.has(Foreground))
+            l.textColor = col2uicol(s.foreground());
+        if (s.has(Fontsize) || s.has(Font))
+            l.font = font(l.font);
+        if (s.has(Alignment))
+            l.textAlignment = alignment[(int)s.align()];
+    } else if ([v isKindOfClass:[UITextField class]]) {
+        auto f = (UITextField *)v;
+        if (s.has(Foreground))
+            f.textColor = col2uicol(s.foreground());
+        if (s.has(Fontsize))
+            f.font = [UIFont systemFontOfSize:s.fontsize()];
+        if (s.has(Alignment))
+            f.textAlignment = alignment[(int)s.align()];
+    } else if ([v isKindOfClass:[UIButton class]] && s.has(Foreground)) {
+        [(UIButton *)v setTitleColor:col2uicol(s.foreground()) forState:UIControlStateNormal];
+    }
 }
 
-Slider &Slider::action(std::function<void(Widget &)> &&f) {
-    auto v = (__bridge UISlider *)view;
-    auto &callbacks = FlouiViewControllerImpl::callbacks;
-    callbacks.push_back([[Callback alloc] initWithTarget:view Cb:f]);
-    [v addTarget:callbacks.back()
-                  action:@selector(invoke)
-        forControlEvents:UIControlEventPrimaryActionTriggered];
-    return *this;
-}
+#endif // TARGET_OS_IPHONE
 
-Slider &Slider::action(::id target, SEL s) {
-    auto v = (__bridge UISlider *)view;
-    [v addTarget:target action:s forControlEvents:UIControlEventPrimaryActionTriggered];
-    return *this;
-}
+#elif defined(FLOUI_HEADLESS)
+// headless stuff
 
-Slider &Slider::foreground(uint32_t c) { return *this; }
+Color Color::system_purple() { return Color(0x7f007fff); }
 
-DEFINE_STYLES(Slider)
+using headless::View;
 
-#endif
+struct FlouiViewControllerImpl {
+    /// Every view alive, views are destroyed by lazy stacks evicting them and headless::reset
+    static inline std::vector<std::unique_ptr<View>> views{};
+    /// The row recyclers of lists, and their viewport
+    struct List {
+        RowRecycler rows;
+        int width = 0;
+        int height = 0;
+    };
+    static inline std::unordered_map<View *, List> lists{};
+    static inline std::atomic<size_t> wakes{0};
+    static inline size_t container_calls = 0;
 
-Text::Text(void *b) : Widget(b) {}
+    FlouiViewControllerImpl(void *, void *, void *) {}
+};
 
-Text::Text(const std::string &s) : Widget((void *)CFBridgingRetain([UILabel new])) {
-    auto v = (__bridge UILabel *)view;
-    [v setText:[NSString stringWithUTF8String:s.c_str()]];
-    [v setTextColor:UIColor.blackColor];
-}
+using c = FlouiViewControllerImpl;
 
-Text &Text::foreground(uint32_t c) {
-    auto v = (__bridge UILabel *)view;
-    [v setTextColor:col2uicol(c)];
-    return *this;
-}
+FlouiViewController::FlouiViewController(void *, void *, void *)
+    : impl(new FlouiViewControllerImpl(nullptr, nullptr, nullptr)) {}
 
-Text &Text::center() {
-    auto v = (__bridge UILabel *)view;
-    [v setTextAlignment:NSTextAlignmentCenter];
-    return *this;
+void FlouiViewController::handle_events(void *view) {
+    auto v = (View *)view;
+    if (v && v->slot >= 0)
+        handle_event(v->slot, view);
 }
 
-Text &Text::left() {
-    auto v = (__bridge UILabel *)view;
-    [v setTextAlignment:NSTextAlignmentLeft];
-    return *this;
-}
+void FlouiViewController::wake() { c::wakes.fetch_add(1, std::memory_order_relaxed); }
 
-Text &Text::right() {
-    auto v = (__bridge UILabel *)view;
-    [v setTextAlignment:NSTextAlignmentRight];
-    return *this;
+FlouiViewController::~FlouiViewController() {
+    flush();
+    delete impl;
 }
 
-Text &Text::text(const std::string &s) {
-    auto v = (__bridge UILabel *)view;
-    [v setText:[NSString stringWithUTF8String:s.c_str()]];
-    return *this;
-}
+BulkScope::BulkScope(int) {}
 
-Text &Text::fontsize(int size) {
-    auto v = (__bridge UILabel *)view;
-    [v setFont:[UIFont systemFontOfSize:size]];
-    return *this;
+BulkScope::~BulkScope() {}
+
+void floui_log0(const char *s) {
+    fputs(s, stderr);
+    fputs("\n", stderr);
 }
 
-Text &Text::bold() {
-    auto v = (__bridge UILabel *)view;
-    [v setFont:[UIFont boldSystemFontOfSize:v.font.pointSize]];
-    return *this;
+int floui_log(const char *s) {
+    floui::Log::write<floui::LogLevel::Info>(s);
+    return 0;
 }
 
-Text &Text::italic() {
-    auto v = (__bridge UILabel *)view;
-    [v setFont:[UIFont italicSystemFontOfSize:v.font.pointSize]];
-    return *this;
+static View *headless_new_view(View::Kind kind) {
+    c::views.push_back(std::make_unique<View>(kind));
+    c::views.back()->index = c::views.size() - 1;
+    return c::views.back().get();
 }
 
-Text &Text::normal() {
-    auto v = (__bridge UILabel *)view;
-    [v setFont:[UIFont systemFontOfSize:v.font.pointSize]];
-    return *this;
+void Widget::destroy(void *view) {
+    auto v = (View *)view;
+    auto list = c::lists.find(v);
+    if (list != c::lists.end()) {
+        // The bound rows are the list's children, the pooled ones aren't attached anywhere
+        v->clear();
+        list->second.rows.each([](Widget &row) { destroy(row.inner()); });
+        c::lists.erase(list);
+    }
+    while (!v->children.empty())
+        destroy(v->children.back());
+    discard(v);
+    if (v->parent)
+        v->parent->remove(v);
+    auto i = v->index;
+    std::swap(c::views[i], c::views.back());
+    c::views[i]->index = i;
+    c::views.pop_back();
+}
+
+/// Lays out the rows of a list in its viewport, its children are the bound rows in order
+static void headless_layout_list(View *v) {
+    auto &l = c::lists.at(v);
+    l.rows.layout(
+        v->scroll_y, l.height, [](Widget &, int) {}, [](Widget &) {});
+    v->clear();
+    for (auto &r : l.rows.rows())
+        v->add((View *)r.view.inner());
+}
+
+namespace floui::headless {
+size_t views() { return c::views.size(); }
+
+size_t wakes() { return c::wakes.load(std::memory_order_relaxed); }
+
+size_t container_calls() { return c::container_calls; }
+
+void reset() {
+    for (auto &v : c::views) {
+        if (v->kind == View::Kind::VStack || v->kind == View::Kind::HStack)
+            LazyStack::forget(v.get());
+        FlouiViewController::invalidate(v.get());
+    }
+    ListView::reset();
+    c::lists.clear();
+    c::views.clear();
+    Images::reset();
+    Layout::reset();
+    TextCache::clear();
+    Style::reset();
+    Effect::reset();
+    FlouiViewController::release_callbacks();
+}
+
+void click(const Widget &w) {
+    auto &v = view(w);
+    if (v.kind == View::Kind::Toggle || v.kind == View::Kind::Check) {
+        v.value = !v.value;
+        FlouiViewController::invalidate(&v, Prop::Value);
+    }
+    if (v.slot >= 0)
+        FlouiViewController::handle_event(v.slot, &v);
+    Layout::update();
+}
+
+void slide(const Widget &w, double value) {
+    auto &v = view(w);
+    v.value = value;
+    FlouiViewController::invalidate(&v, Prop::Value);
+    if (v.slot >= 0)
+        FlouiViewController::handle_event(v.slot, &v);
+    Layout::update();
+}
+
+void type(const Widget &w, const std::string &text) {
+    view(w).text = text;
+    FlouiViewController::invalidate(w.inner(), Prop::Text);
+    Layout::dirty(w.inner());
+    Layout::update();
+}
+
+void scroll(const Widget &w, int x, int y, int width, int height) {
+    auto &v = view(w);
+    v.scroll_x = x;
+    v.scroll_y = y;
+    if (v.kind == View::Kind::ListView) {
+        auto &l = c::lists.at(&v);
+        l.width = width;
+        l.height = height;
+        headless_layout_list(&v);
+    } else {
+        LazyStack::scrolled((int64_t)(intptr_t)&v, x, y, width, height);
+    }
 }
+} // namespace floui::headless
 
-DEFINE_STYLES(Text)
+#define DEFINE_STYLES(widget)                                                                      \
+    widget &widget::background(uint32_t col) {                                                     \
+        PROPERTY_WRITE(widget, Background, background, col)                                        \
+        ((View *)view)->background = col;                                                          \
+        return *this;                                                                              \
+    }                                                                                              \
+    widget &widget::id(Id val) {                                                                   \
+        widget_map.insert(val, view);                                                              \
+        return *this;                                                                              \
+    }                                                                                              \
+    widget &widget::size(int w, int h) {                                                           \
+        PROPERTY_WRITE(widget, Size, size, w, h)                                                   \
+        auto v = (View *)view;                                                                     \
+        v->width = w;                                                                              \
+        v->height = h;                                                                             \
+        Layout::size(view, w, h);                                                                  \
+        return *this;                                                                              \
+    }
 
-TextField::TextField(void *b) : Widget(b) {}
+/// Defines the setters shared by the widgets which have a foreground color and a callback
+#define DEFINE_CONTROL(widget)                                                                     \
+    widget &widget::foreground(uint32_t c) {                                                       \
+        PROPERTY_WRITE(widget, Foreground, foreground, c)                                          \
+        ((View *)view)->foreground = c;                                                            \
+        return *this;                                                                              \
+    }                                                                                              \
+    widget &widget::action(Action &&f) {                                                           \
+        ((View *)view)->slot = FlouiViewController::add_callback(std::move(f));                    \
+        return *this;                                                                              \
+    }
 
-TextField::TextField() : Widget((void *)CFBridgingRetain([UITextField new])) {
-    auto v = (__bridge UITextField *)view;
-    [v setTextColor:UIColor.blackColor];
-}
+/// Defines the children management of containers
+#define DEFINE_CONTAINER(widget)                                                                   \
+    widget &widget::spacing(int val) {                                                             \
+        ((View *)view)->spacing = val;                                                             \
+        Layout::spacing(view, val);                                                                \
+        return *this;                                                                              \
+    }                                                                                              \
+    widget &widget::add(const Widget &w) {                                                         \
+        FLOUI_ENTRY(#widget "::add");                                                              \
+        c::container_calls++;                                                                      \
+        ((View *)view)->add((View *)w.inner());                                                    \
+        Layout::add(view, w.inner());                                                              \
+        return *this;                                                                              \
+    }                                                                                              \
+    widget &widget::insert(const Widget &w, int index) {                                           \
+        FLOUI_ENTRY(#widget "::insert");                                                           \
+        c::container_calls++;                                                                      \
+        ((View *)view)->insert((View *)w.inner(), index);                                          \
+        Layout::insert(view, w.inner(), index);                                                    \
+        return *this;                                                                              \
+    }                                                                                              \
+    widget &widget::remove(const Widget &w) {                                                      \
+        FLOUI_ENTRY(#widget "::remove");                                                           \
+        c::container_calls++;                                                                      \
+        ((View *)view)->remove((View *)w.inner());                                                 \
+        Layout::remove(view, w.inner());                                                           \
+        return *this;                                                                              \
+    }                                                                                              \
+    widget &widget::clear() {                                                                      \
+        FLOUI_ENTRY(#widget "::clear");                                                            \
+        c::container_calls++;                                                                      \
+        ((View *)view)->clear();                                                                   \
+        Layout::clear(view);                                                                       \
+        return *this;                                                                              \
+    }                                                                                              \
+    widget &widget::splice(const std::vector<void *> &views, bool replace) {                       \
+        FLOUI_ENTRY(#widget "::splice");                                                           \
+        c::container_calls++;                                                                      \
+        auto v = (View *)view;                                                                     \
+        if (replace) {                                                                             \
+            v->clear();                                                                            \
+            Layout::clear(view);                                                                   \
+        }                                                                                          \
+        v->children.reserve(v->children.size() + views.size());                                    \
+        for (auto child : views)                                                                   \
+            v->add((View *)child);                                                                 \
+        Layout::add(view, views);                                                                  \
+        return *this;                                                                              \
+    }
 
-TextField &TextField::foreground(uint32_t c) {
-    auto v = (__bridge UITextField *)view;
-    [v setTextColor:col2uicol(c)];
-    return *this;
-}
+Widget::Widget(void *v) : view(v) {}
 
-TextField &TextField::center() {
-    auto v = (__bridge UITextField *)view;
-    [v setTextAlignment:NSTextAlignmentCenter];
-    return *this;
-}
+void *Widget::inner() const { return view; }
 
-TextField &TextField::left() {
-    auto v = (__bridge UITextField *)view;
-    [v setTextAlignment:NSTextAlignmentLeft];
-    return *this;
+DEFINE_STYLES(Widget)
+
+Button::Button(void *b) : Widget(b) {}
+
+Button::Button(const std::string &label) : Widget(nullptr) {
+    FLOUI_ENTRY("Button::Button");
+    view = headless_new_view(View::Kind::Button);
+    ((View *)view)->text = label;
 }
 
-TextField &TextField::right() {
-    auto v = (__bridge UITextField *)view;
-    [v setTextAlignment:NSTextAlignmentRight];
+Button &Button::filled() {
+    ((View *)view)->filled = true;
     return *this;
 }
 
+DEFINE_CONTROL(Button)
+DEFINE_STYLES(Button)
 
-TextField &TextField::text(const std::string &s) {
-    auto v = (__bridge UITextField *)view;
-    [v setText:[NSString stringWithUTF8String:s.c_str()]];
-    return *this;
-}
+Toggle::Toggle(void *b) : Widget(b) {}
 
-std::string TextField::text() const {
-    return std::string([((__bridge UITextField *)view).text UTF8String]);
+Toggle::Toggle(const std::string &label) : Widget(nullptr) {
+    FLOUI_ENTRY("Toggle::Toggle");
+    view = headless_new_view(View::Kind::Toggle);
+    ((View *)view)->text = label;
 }
 
-TextField &TextField::fontsize(int size) {
-    auto v = (__bridge UITextField *)view;
-    [v setFont:[UIFont systemFontOfSize:size]];
+Toggle &Toggle::value(bool val) {
+    PROPERTY_WRITE(Toggle, Value, value, val)
+    ((View *)view)->value = val;
     return *this;
 }
 
-DEFINE_STYLES(TextField)
-
-Spacer::Spacer(void *b) : Widget(b) {}
-
-Spacer::Spacer() : Widget((void *)CFBridgingRetain([UIView new])) {}
-
-DEFINE_STYLES(Spacer)
-
-MainView::MainView(void *v) : Widget(v) {}
-
-MainView::MainView(const FlouiViewController &, std::initializer_list<Widget> l)
-    : Widget((void *)CFBridgingRetain([UIStackView new])) {
-    auto v = (__bridge UIStackView *)view;
-    v.translatesAutoresizingMaskIntoConstraints = NO;
-    auto vc = FlouiViewControllerImpl::vc;
-    auto label = [UILabel new];
-    auto name = FlouiViewControllerImpl::name;
-    if (name) {
-        [label setText:[NSString stringWithUTF8String:name]];
-    } else {
-        [label setText:[[[NSBundle mainBundle] infoDictionary] objectForKey:@"CFBundleName"]];
-    }
-#if TARGET_OS_TV
-    [label setTextColor:UIColor.whiteColor];
-    label.backgroundColor = UIColor.systemGrayColor;
-#else
-    [label setTextColor:UIColor.blackColor];
-    label.backgroundColor = UIColor.systemGray5Color;
-#endif
-    [label setFont:[UIFont boldSystemFontOfSize:30]];
-    [label setTextAlignment:NSTextAlignmentCenter];
-    label.frame = CGRectMake(0, 0, vc.view.frame.size.width, 120);
-    [vc.view addSubview:label];
-    [vc.view addSubview:v];
-    [v setAxis:UILayoutConstraintAxisVertical];
-    [v setDistribution:UIStackViewDistributionEqualSpacing];
-    [v setAlignment:UIStackViewAlignmentCenter];
-    [v setSpacing:10];
-    [v setContentHuggingPriority:UILayoutPriorityRequired forAxis:UILayoutConstraintAxisHorizontal];
-    [v.widthAnchor constraintEqualToConstant:vc.view.frame.size.width].active = YES;
-    [v.topAnchor constraintEqualToAnchor:label.bottomAnchor constant:20].active = YES;
-    for (auto &e : l) {
-        auto w = (__bridge UIView *)e.inner();
-        w.translatesAutoresizingMaskIntoConstraints = NO;
-        [v addArrangedSubview:w];
-        if (w.frame.size.width != 0)
-            [w.widthAnchor constraintEqualToConstant:w.frame.size.width].active = YES;
-        if (w.frame.size.height != 0)
-            [w.heightAnchor constraintEqualToConstant:w.frame.size.height].active = YES;
-    }
+bool Toggle::value() {
+    FlouiViewController::settle(view, Prop::Value);
+    // The user may have changed it
+    FlouiViewController::invalidate(view, Prop::Value);
+    return ((View *)view)->value != 0;
 }
 
-MainView &MainView::spacing(int val) {
-    auto v = (__bridge UIStackView *)view;
-    [v setSpacing:val];
+DEFINE_CONTROL(Toggle)
+DEFINE_STYLES(Toggle)
+
+Check::Check(void *b) : Widget(b) {}
+
+Check::Check(const std::string &label) : Widget(nullptr) {
+    FLOUI_ENTRY("Check::Check");
+    view = headless_new_view(View::Kind::Check);
+    ((View *)view)->text = label;
+}
+
+Check &Check::value(bool val) {
+    PROPERTY_WRITE(Check, Value, value, val)
+    ((View *)view)->value = val;
     return *this;
 }
 
-MainView &MainView::add(const Widget &w) {
-    auto v = (__bridge UIStackView *)view;
-    auto i = (__bridge UIView *)w.inner();
-    i.translatesAutoresizingMaskIntoConstraints = NO;
-    [v addArrangedSubview:i];
-    if (i.frame.size.width != 0)
-        [i.widthAnchor constraintEqualToConstant:i.frame.size.width].active = YES;
-    if (i.frame.size.height != 0)
-        [i.heightAnchor constraintEqualToConstant:i.frame.size.height].active = YES;
+bool Check::value() {
+    FlouiViewController::settle(view, Prop::Value);
+    // The user may have changed it
+    FlouiViewController::invalidate(view, Prop::Value);
+    return ((View *)view)->value != 0;
+}
+
+DEFINE_CONTROL(Check)
+DEFINE_STYLES(Check)
+
+Slider::Slider(void *b) : Widget(b) {}
+
+Slider::Slider() : Widget(nullptr) {
+    FLOUI_ENTRY("Slider::Slider");
+    view = headless_new_view(View::Kind::Slider);
+}
+
+Slider &Slider::value(double val) {
+    PROPERTY_WRITE(Slider, Value, value, val)
+    ((View *)view)->value = val;
     return *this;
 }
 
-MainView &MainView::remove(const Widget &w) {
-    auto v = (__bridge UIStackView *)view;
-    auto i = (__bridge UIView *)w.inner();
-    if ([i isDescendantOfView:v])
-        [i removeFromSuperview];
+double Slider::value() {
+    FlouiViewController::settle(view, Prop::Value);
+    // The user may have changed it
+    FlouiViewController::invalidate(view, Prop::Value);
+    return ((View *)view)->value;
+}
+
+DEFINE_CONTROL(Slider)
+DEFINE_STYLES(Slider)
+
+Text::Text(void *b) : Widget(b) {}
+
+Text::Text(const std::string &label) : Widget(nullptr) {
+    FLOUI_ENTRY("Text::Text");
+    view = headless_new_view(View::Kind::Text);
+    ((View *)view)->text = label;
+}
+
+Text &Text::fontsize(int size) {
+    PROPERTY_WRITE(Text, Fontsize, fontsize, size)
+    ((View *)view)->fontsize = size;
+    Layout::dirty(view);
     return *this;
 }
 
-MainView &MainView::clear() {
-    auto v = (__bridge UIStackView *)view;
-    for (UIView *view in [v subviews]) {
-        [view removeFromSuperview];
-    }
+Text &Text::bold() {
+    ((View *)view)->bold = true;
+    Layout::dirty(view);
     return *this;
 }
 
-DEFINE_STYLES(MainView)
+Text &Text::italic() {
+    ((View *)view)->italic = true;
+    Layout::dirty(view);
+    return *this;
+}
 
-VStack::VStack(void *v) : Widget(v) {}
+Text &Text::normal() {
+    auto v = (View *)view;
+    v->bold = false;
+    v->italic = false;
+    Layout::dirty(view);
+    return *this;
+}
 
-VStack::VStack(std::initializer_list<Widget> l)
-    : Widget((void *)CFBridgingRetain([UIStackView new])) {
-    auto v = (__bridge UIStackView *)view;
-    [v setAxis:UILayoutConstraintAxisVertical];
-    [v setDistribution:UIStackViewDistributionFillEqually];
-    [v setAlignment:UIStackViewAlignmentCenter];
-    [v setSpacing:10];
-    for (auto &e : l) {
-        auto w = (__bridge UIView *)e.inner();
-        w.translatesAutoresizingMaskIntoConstraints = NO;
-        [v addArrangedSubview:w];
-        if (w.frame.size.width != 0)
-            [w.widthAnchor constraintEqualToConstant:w.frame.size.width].active = YES;
-        if (w.frame.size.height != 0)
-            [w.heightAnchor constraintEqualToConstant:w.frame.size.height].active = YES;
-    }
+Text &Text::text(const std::string &label) {
+    PROPERTY_WRITE(Text, Text, text, label)
+    ((View *)view)->text = label;
+    Layout::dirty(view);
+    return *this;
 }
 
-VStack &VStack::spacing(int val) {
-    auto v = (__bridge UIStackView *)view;
-    [v setSpacing:val];
+Text &Text::center() {
+    ((View *)view)->align = View::Align::Center;
     return *this;
 }
 
-VStack &VStack::add(const Widget &w) {
-    auto v = (__bridge UIStackView *)view;
-    auto i = (__bridge UIView *)w.inner();
-    i.translatesAutoresizingMaskIntoConstraints = NO;
-    [v addArrangedSubview:i];
-    if (i.frame.size.width != 0)
-        [i.widthAnchor constraintEqualToConstant:i.frame.size.width].active = YES;
-    if (i.frame.size.height != 0)
-        [i.heightAnchor constraintEqualToConstant:i.frame.size.height].active = YES;
+Text &Text::left() {
+    ((View *)view)->align = View::Align::Left;
     return *this;
 }
 
-VStack &VStack::remove(const Widget &w) {
-    auto v = (__bridge UIStackView *)view;
-    auto i = (__bridge UIView *)w.inner();
-    if ([i isDescendantOfView:v])
-        [i removeFromSuperview];
+Text &Text::right() {
+    ((View *)view)->align = View::Align::Right;
     return *this;
 }
 
-VStack &VStack::clear() {
-    auto v = (__bridge UIStackView *)view;
-    for (UIView *view in [v subviews]) {
-        [view removeFromSuperview];
-    }
+Text &Text::foreground(uint32_t c) {
+    PROPERTY_WRITE(Text, Foreground, foreground, c)
+    ((View *)view)->foreground = c;
     return *this;
 }
 
-DEFINE_STYLES(VStack)
+DEFINE_STYLES(Text)
 
-HStack::HStack(void *v) : Widget(v) {}
+TextField::TextField(void *b) : Widget(b) {}
 
-HStack::HStack(std::initializer_list<Widget> l)
-    : Widget((void *)CFBridgingRetain([UIStackView new])) {
-    auto v = (__bridge UIStackView *)view;
-    [v setAxis:UILayoutConstraintAxisHorizontal];
-    [v setDistribution:UIStackViewDistributionFillEqually];
-    [v setAlignment:UIStackViewAlignmentCenter];
-    [v setSpacing:10];
-    for (auto &e : l) {
-        auto w = (__bridge UIView *)e.inner();
-        w.translatesAutoresizingMaskIntoConstraints = NO;
-        [v addArrangedSubview:w];
-        if (w.frame.size.width != 0)
-            [w.widthAnchor constraintEqualToConstant:w.frame.size.width].active = YES;
-        if (w.frame.size.height != 0)
-            [w.heightAnchor constraintEqualToConstant:w.frame.size.height].active = YES;
-    }
+TextField::TextField() : Widget(nullptr) {
+    FLOUI_ENTRY("TextField::TextField");
+    view = headless_new_view(View::Kind::TextField);
 }
 
-HStack &HStack::spacing(int val) {
-    auto v = (__bridge UIStackView *)view;
-    [v setSpacing:val];
+TextField &TextField::fontsize(int size) {
+    PROPERTY_WRITE(TextField, Fontsize, fontsize, size)
+    ((View *)view)->fontsize = size;
+    Layout::dirty(view);
     return *this;
 }
 
-HStack &HStack::add(const Widget &w) {
-    auto v = (__bridge UIStackView *)view;
-    auto i = (__bridge UIView *)w.inner();
-    i.translatesAutoresizingMaskIntoConstraints = NO;
-    [v addArrangedSubview:i];
-    if (i.frame.size.width != 0)
-        [i.widthAnchor constraintEqualToConstant:i.frame.size.width].active = YES;
-    if (i.frame.size.height != 0)
-        [i.heightAnchor constraintEqualToConstant:i.frame.size.height].active = YES;
+TextField &TextField::text(const std::string &label) {
+    PROPERTY_WRITE(TextField, Text, text, label)
+    ((View *)view)->text = label;
+    Layout::dirty(view);
     return *this;
 }
 
-HStack &HStack::remove(const Widget &w) {
-    auto v = (__bridge UIStackView *)view;
-    auto i = (__bridge UIView *)w.inner();
-    if ([i isDescendantOfView:v])
-        [i removeFromSuperview];
+std::string TextField::text() const {
+    FlouiViewController::settle(view, Prop::Text);
+    // The user may have changed it
+    FlouiViewController::invalidate(view, Prop::Text);
+    return ((View *)view)->text;
+}
+
+TextField &TextField::center() {
+    ((View *)view)->align = View::Align::Center;
     return *this;
 }
 
-HStack &HStack::clear() {
-    auto v = (__bridge UIStackView *)view;
-    for (UIView *view in [v subviews]) {
-        [view removeFromSuperview];
-    }
+TextField &TextField::left() {
+    ((View *)view)->align = View::Align::Left;
+    return *this;
+}
+
+TextField &TextField::right() {
+    ((View *)view)->align = View::Align::Right;
     return *this;
 }
 
+TextField &TextField::foreground(uint32_t c) {
+    PROPERTY_WRITE(TextField, Foreground, foreground, c)
+    ((View *)view)->foreground = c;
+    return *this;
+}
+
+DEFINE_STYLES(TextField)
+
+Spacer::Spacer(void *b) : Widget(b) {}
+
+Spacer::Spacer() : Widget(nullptr) {
+    FLOUI_ENTRY("Spacer::Spacer");
+    view = headless_new_view(View::Kind::Spacer);
+}
+
+DEFINE_STYLES(Spacer)
+
+MainView::MainView(void *m) : Widget(m) {}
+
+MainView::MainView(const FlouiViewController &, std::initializer_list<Widget> l)
+    : Widget(nullptr) {
+    FLOUI_ENTRY("MainView::MainView");
+    view = headless_new_view(View::Kind::MainView);
+    Layout::container(view, Layout::Direction::Column);
+    Layout::root(view);
+    splice(gather_views(l.begin(), l.end()), false);
+}
+
+DEFINE_CONTAINER(MainView)
+DEFINE_STYLES(MainView)
+
+VStack::VStack(void *m) : Widget(m) {}
+
+VStack::VStack(std::initializer_list<Widget> l) : Widget(nullptr) {
+    FLOUI_ENTRY("VStack::VStack");
+    view = headless_new_view(View::Kind::VStack);
+    Layout::container(view, Layout::Direction::Column);
+    splice(gather_views(l.begin(), l.end()), false);
+}
+
+DEFINE_CONTAINER(VStack)
+DEFINE_STYLES(VStack)
+
+HStack::HStack(void *m) : Widget(m) {}
+
+HStack::HStack(std::initializer_list<Widget> l) : Widget(nullptr) {
+    FLOUI_ENTRY("HStack::HStack");
+    view = headless_new_view(View::Kind::HStack);
+    Layout::container(view, Layout::Direction::Row);
+    splice(gather_views(l.begin(), l.end()), false);
+}
+
+DEFINE_CONTAINER(HStack)
 DEFINE_STYLES(HStack)
 
 ImageView::ImageView(void *v) : Widget(v) {}
 
-ImageView::ImageView() : Widget((void *)CFBridgingRetain([UIImageView new])) {}
+ImageView::ImageView() : Widget(nullptr) {
+    FLOUI_ENTRY("ImageView::ImageView");
+    view = headless_new_view(View::Kind::ImageView);
+}
 
-ImageView::ImageView(const std::string &path)
-    : Widget((void *)CFBridgingRetain([UIImageView new])) {
-    auto i = [UIImage imageNamed:[NSString stringWithUTF8String:path.c_str()]];
-    auto v = (__bridge UIImageView *)view;
-    [v setImage:i];
-    [v setContentMode:UIViewContentModeScaleAspectFit];
+ImageView::ImageView(const std::string &path) : Widget(nullptr) {
+    FLOUI_ENTRY("ImageView::ImageView");
+    view = headless_new_view(View::Kind::ImageView);
+    ((View *)view)->text = path;
+    Images::load(view, path);
 }
 
 ImageView &ImageView::image(const std::string &path) {
-    auto v = (__bridge UIImageView *)view;
-    auto i = [UIImage imageNamed:[NSString stringWithUTF8String:path.c_str()]];
-    [v setImage:i];
+    PROPERTY_WRITE(ImageView, Image, image, path)
+    ((View *)view)->text = path;
+    Images::load(view, path);
     return *this;
 }
 
-DEFINE_STYLES(ImageView)
-
-#ifdef FLOUI_IOS_WEBVIEW
+/// Fills a buffer of pixels derived from the path, an empty path fails
+Image Images::decode(const std::string &path, int width, int height) {
+    if (path.empty())
+        return {};
+    fit(headless::image_width, headless::image_height, width, height);
+    auto pixels = new uint32_t[(size_t)width * height];
+    auto seed = (uint32_t)std::hash<std::string>()(path);
+    for (int y = 0; y < height; y++)
+        for (int x = 0; x < width; x++)
+            pixels[(size_t)y * width + x] = seed ^ (uint32_t)(x * 0x9e3779b1u + y * 0x85ebca6bu);
+    return Image{pixels, width, height, (size_t)width * height * sizeof(uint32_t)};
+}
 
-WebView::WebView(void *v) : Widget(v) {}
+void Images::release(const Image &image) { delete[] (uint32_t *)image.native; }
 
-WebView::WebView() : Widget((void *)CFBridgingRetain([WKWebView new])) {
-    auto vc = FlouiViewControllerImpl::vc;
-    auto frame = vc.view.frame;
-    Widget(view).size(frame.size.width, frame.size.height - 120);
+void Images::show(void *view, const Image *image) {
+    ((View *)view)->image = image;
+    Layout::dirty(view);
 }
 
-std::string get_ext(const std::string &http) {
-    return http.substr(http.find_last_of('.') + 1, http.size());
+void Images::target(void *view, int &width, int &height) {
+    width = ((View *)view)->width;
+    height = ((View *)view)->height;
 }
 
-std::string get_stem(const std::string &http) {
-    return http.substr(http.find_last_of('/') + 1, http.find('.') - http.find_last_of('/') - 1);
-}
+DEFINE_STYLES(ImageView)
 
-std::string get_subdir(const std::string &http) {
-    auto last = http.find_last_of('/');
-    if (last == 7) {
-        return "";
-    }
-    return http.substr(http.find_first_of("file:///") + 8, last - 8);
+WebView::WebView(void *v) : Widget(v) {}
+
+WebView::WebView() : Widget(nullptr) {
+    FLOUI_ENTRY("WebView::WebView");
+    view = headless_new_view(View::Kind::WebView);
 }
 
 WebView &WebView::load_file_url(const std::string &local_path) {
-    auto v = (__bridge WKWebView *)view;
-    auto bundle = [NSBundle mainBundle];
-    auto stem = [NSString stringWithUTF8String:get_stem(local_path).c_str()];
-    auto ext = [NSString stringWithUTF8String:get_ext(local_path).c_str()];
-    auto dir = [NSString stringWithUTF8String:get_subdir(local_path).c_str()];
-    auto url = [bundle URLForResource:stem withExtension:ext subdirectory:dir];
-    [v loadFileURL:url allowingReadAccessToURL:url.URLByDeletingLastPathComponent];
+    ((View *)view)->text = local_path;
     return *this;
 }
 
 WebView &WebView::load_http_url(const std::string &path) {
-    auto v = (__bridge WKWebView *)view;
-    [v loadRequest:[NSURLRequest
-                       requestWithURL:[NSURL
-                                          URLWithString:[NSString
-                                                            stringWithUTF8String:path.c_str()]]]];
+    ((View *)view)->text = path;
     return *this;
 }
 
-WebView &WebView::load_html(const std::string &path) {
-    auto v = (__bridge WKWebView *)view;
-    [v loadHTMLString:[NSString stringWithUTF8String:path.c_str()] baseURL:nil];
+WebView &WebView::load_html(const std::string &html) {
+    ((View *)view)->text = html;
     return *this;
 }
 
 WebView &WebView::load_url(const std::string &url) {
-    if (url.find("file://") == 0) {
-        load_file_url(url);
-    } else {
-        load_http_url(url);
-    }
+    ((View *)view)->text = url;
     return *this;
 }
 
 DEFINE_STYLES(WebView)
 
-#endif // FLOUI_IOS_WEBVIEW
-
 ScrollView::ScrollView(void *v) : Widget(v) {}
 
-ScrollView::ScrollView(const Widget &w) : Widget((void *)CFBridgingRetain([UIScrollView new])) {
-    auto v = (__bridge UIScrollView *)view;
-    auto i = (__bridge UIView *)w.inner();
-    i.translatesAutoresizingMaskIntoConstraints = NO;
-    [v addSubview:i];
-    if (i.frame.size.width != 0)
-        [i.widthAnchor constraintEqualToConstant:i.frame.size.width].active = YES;
-    if (i.frame.size.height != 0)
-        [i.heightAnchor constraintEqualToConstant:i.frame.size.height].active = YES;
+ScrollView::ScrollView(const Widget &w) : Widget(nullptr) {
+    FLOUI_ENTRY("ScrollView::ScrollView");
+    view = headless_new_view(View::Kind::ScrollView);
+    ((View *)view)->add((View *)w.inner());
+    Layout::container(view, Layout::Direction::Column, true);
+    Layout::add(view, w.inner());
+    if (LazyStack::lazy(w.inner()))
+        LazyStack::attach((int64_t)(intptr_t)view, w.inner());
 }
 
 DEFINE_STYLES(ScrollView)
 
-#endif // TARGET_OS_IPHONE
+ListView::ListView(void *v) : Widget(v) {}
+
+ListView::ListView(int count, Create create, Bind bind, Type type) : Widget(nullptr) {
+    FLOUI_ENTRY("ListView::ListView");
+    view = headless_new_view(View::Kind::ListView);
+    auto list = add_list(count, std::move(create), std::move(bind), std::move(type));
+    ids_[view] = list;
+    c::lists.emplace((View *)view, c::List{RowRecycler(list)});
+}
+
+ListView &ListView::count(int n) {
+    list().count = n;
+    auto v = (View *)view;
+    c::lists.at(v).rows.reset([](Widget &) {});
+    headless_layout_list(v);
+    return *this;
+}
+
+DEFINE_STYLES(ListView)
+
+/// Each byte is 0.6 times the font size wide, 0.65 when bold, and lines are 1.2 times high
+TextCache::Metrics TextCache::shape(const std::string &text, const Font &font, int max_width) {
+    auto advance = font.size * (font.bold ? 13 : 12);
+    return wrap(text, max_width, font.size * 12 / 10,
+                [=](const char *, int n) { return n * advance / 20; });
+}
+
+/// Toggles and checks add a square box to their label, and images are as large as they're shown
+void Layout::measure(void *view, int &width, int &height) {
+    auto v = (View *)view;
+    switch (v->kind) {
+    case View::Kind::Button:
+    case View::Kind::Toggle:
+    case View::Kind::Check:
+    case View::Kind::Text:
+    case View::Kind::TextField: {
+        auto &m = TextCache::measure(v->text, Font{0, v->fontsize, v->bold, v->italic});
+        width = m.width;
+        height = m.height;
+        if (v->kind == View::Kind::Toggle || v->kind == View::Kind::Check)
+            width += height;
+        break;
+    }
+    case View::Kind::Slider:
+        width = 100;
+        height = 20;
+        break;
+    case View::Kind::ImageView:
+        width = v->image ? v->image->width : 0;
+        height = v->image ? v->image->height : 0;
+        break;
+    default:
+        width = height = 0;
+    }
+}
+
+void Layout::apply(void *view, const Frame &frame) { ((View *)view)->frame = frame; }
+
+/// Controls take the foreground, and texts and text fields the text properties, bold and italic
+/// only applying to texts
+void Style::show(void *view, const Style &s) {
+    auto v = (View *)view;
+    if (s.has(Background))
+        v->background = s.background();
+    switch (v->kind) {
+    case View::Kind::Button:
+    case View::Kind::Toggle:
+    case View::Kind::Check:
+    case View::Kind::Slider:
+        if (s.has(Foreground))
+            v->foreground = s.foreground();
+        return;
+    case View::Kind::Text:
+    case View::Kind::TextField:
+        break;
+    default:
+        return;
+    }
+    if (s.has(Foreground))
+        v->foreground = s.foreground();
+    if (s.has(Fontsize))
+        v->fontsize = s.fontsize();
+    if (s.has(Font) && v->kind == View::Kind::Text) {
+        v->bold = s.font() == FontStyle::Bold;
+        v->italic = s.font() == FontStyle::Italic;
+    }
+    if (s.has(Alignment))
+        v->align = static_cast<View::Align>(s.align());
+    if (s.has(Fontsize) || s.has(Font))
+        Layout::dirty(view);
+}
 
 #else
 // other platform
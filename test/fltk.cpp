@@ -6,20 +6,38 @@
 
 #include <FL/Enumerations.H>
 #include <FL/Fl_Box.H>
+#include <FL/Fl_BMP_Image.H>
 #include <FL/Fl_Button.H>
 #include <FL/Fl_Input.H>
-#include <FL/Fl_Pack.H>
+#include <FL/Fl_JPEG_Image.H>
+#include <FL/Fl_PNG_Image.H>
+#include <FL/Fl_Group.H>
 #include <FL/Fl_Double_Window.H>
+#include <FL/fl_draw.H>
+#include <FL/Fl_Scrollbar.H>
 
 
 using namespace floui;
 
 struct FlouiViewControllerImpl {
     static inline Fl_Window *win = nullptr;
-    static inline std::vector<std::function<void(Widget &)> *> callbacks = {};
+
+    /// Applies batched writes and lays out again once per event loop turn
+    static void flush_cb(void *) {
+        FlouiViewController::flush();
+        Layout::update();
+    }
+
+    /// Runs posted tasks, woken by Fl::awake
+    static void drain_cb(void *) { FlouiViewController::drain(); }
 
     FlouiViewControllerImpl(Fl_Window *win, void *, void *) {
         FlouiViewControllerImpl::win = win;
+        // Lets other threads call Fl::awake
+        Fl::lock();
+        Fl::add_check(flush_cb);
+        // Images are downsampled to their view's size
+        Fl_Image::RGB_scaling(FL_RGB_SCALING_BILINEAR);
         win->end();
         win->show();
         win->color(FL_WHITE);
@@ -31,10 +49,12 @@ FlouiViewController::FlouiViewController(void *win, void *, void *)
 
 void FlouiViewController::handle_events(void *) { return; }
 
+void FlouiViewController::wake() { Fl::awake(FlouiViewControllerImpl::drain_cb, nullptr); }
+
 FlouiViewController::~FlouiViewController() {
-    for (auto &elem : FlouiViewControllerImpl::callbacks) {
-        delete elem;
-    }
+    Fl::remove_check(FlouiViewControllerImpl::flush_cb);
+    flush();
+    release_callbacks();
     delete impl;
 }
 
@@ -44,31 +64,33 @@ void floui_log0(const char *s) {
 }
 
 int floui_log(const char *s) {
-    floui_log0(s);
+    floui::Log::write<floui::LogLevel::Info>(s);
     return 0;
 }
 
 using c = FlouiViewControllerImpl;
 
+/// The callback data is the dispatch slot
 void widget_cb(Fl_Widget *w, void *data) {
-    auto f = (std::function<void(Widget &)> *)data;
-    auto e = Widget(w);
-    (*f)(e);
+    FlouiViewController::handle_event((int)(intptr_t)data, w);
 }
 
 #define DEFINE_STYLES(widget)                                                                      \
     widget &widget::background(uint32_t col) {                                                     \
+        PROPERTY_WRITE(widget, Background, background, col)                                        \
         auto v = (Fl_Widget *)view;                                                                \
         v->color(col);                                                                             \
         return *this;                                                                              \
     }                                                                                              \
-    widget &widget::id(const char *val) {                                                          \
-        widget_map[val] = view;                                                                    \
+    widget &widget::id(Id val) {                                                                   \
+        widget_map.insert(val, view);                                                              \
         return *this;                                                                              \
     }                                                                                              \
     widget &widget::size(int w, int h) {                                                           \
+        PROPERTY_WRITE(widget, Size, size, w, h)                                                   \
         auto v = (Fl_Widget *)view;                                                                \
         v->size(w, h);                                                                             \
+        Layout::size(view, w, h);                                                                  \
         return *this;                                                                              \
     }
 
@@ -78,31 +100,162 @@ void *Widget::inner() const { return view; }
 
 DEFINE_STYLES(Widget)
 
+/// The main view fills the window, and its children are placed by Layout, so it doesn't move
+/// them itself
+class FlMainView : public Fl_Group {
+  public:
+    FlMainView(int w, int h) : Fl_Group(0, 0, w, h) {
+        end();
+        resizable(nullptr);
+        Layout::container(this, Layout::Direction::Column);
+        Layout::root(this);
+        Layout::size(this, w, h);
+    }
+
+    void resize(int X, int Y, int W, int H) override {
+        Fl_Widget::resize(X, Y, W, H);
+        Layout::size(this, W, H);
+        Layout::update();
+    }
+};
+
 void *MainView_init() {
-    auto pack = new Fl_Pack(0, 0, c::win->w(), c::win->h());
-    c::win->add(pack);
-    return pack;
+    auto main_view = new FlMainView(c::win->w(), c::win->h());
+    c::win->add(main_view);
+    c::win->resizable(main_view);
+    return main_view;
 }
 
 MainView::MainView(void *v) : Widget(v) {}
 
 MainView::MainView(const FlouiViewController &controller, std::initializer_list<Widget> l)
     : Widget(MainView_init()) {
-    auto v = (Fl_Pack *)view;
-    auto count = l.size();
-    count = count ? count : c::win->h();
-    auto h = v->h() / count;
-    for (auto &w : l) {
-        auto e = (Fl_Widget *)w.inner();
-        if (e->h() == 0) {
-            e->size(0, h);
-        }
-        v->add(e);
-    }
+    for (auto &w : l)
+        add(w);
+}
+
+MainView &MainView::spacing(int val) {
+    Layout::spacing(view, val);
+    return *this;
+}
+
+MainView &MainView::add(const Widget &w) {
+    ((Fl_Group *)view)->add((Fl_Widget *)w.inner());
+    Layout::add(view, w.inner());
+    return *this;
+}
+
+MainView &MainView::insert(const Widget &w, int index) {
+    auto v = (Fl_Group *)view;
+    // Fl_Group::insert appends past the end, but takes no negative index
+    v->insert(*(Fl_Widget *)w.inner(), index < 0 ? v->children() : index);
+    Layout::insert(view, w.inner(), index);
+    return *this;
+}
+
+MainView &MainView::remove(const Widget &w) {
+    ((Fl_Group *)view)->remove((Fl_Widget *)w.inner());
+    Layout::remove(view, w.inner());
+    return *this;
+}
+
+MainView &MainView::clear() {
+    // Fl_Group::clear deletes the children, which floui doesn't own
+    auto v = (Fl_Group *)view;
+    while (v->children())
+        v->remove(v->children() - 1);
+    Layout::clear(view);
+    return *this;
+}
+
+MainView &MainView::splice(const std::vector<void *> &views, bool replace) {
+    if (replace)
+        clear();
+    auto v = (Fl_Group *)view;
+    for (auto child : views)
+        v->add((Fl_Widget *)child);
+    Layout::add(view, views);
+    return *this;
 }
 
 DEFINE_STYLES(MainView)
 
+static void discard_all(Fl_Widget *w) {
+    if (auto g = w->as_group()) {
+        for (int i = 0; i < g->children(); i++)
+            discard_all(g->child(i));
+    }
+    Widget::discard(w);
+}
+
+/// Fl_Group deletes the widgets under it along with it
+void Widget::destroy(void *view) {
+    auto w = (Fl_Widget *)view;
+    discard_all(w);
+    if (w->parent())
+        w->parent()->remove(w);
+    Fl::delete_widget(w);
+}
+
+/// Shaped with FLTK's font metrics, bold and italic being offsets of the face
+TextCache::Metrics TextCache::shape(const std::string &text, const Font &font, int max_width) {
+    fl_font(font.face + (font.bold ? FL_BOLD : 0) + (font.italic ? FL_ITALIC : 0), font.size);
+    return wrap(text, max_width, fl_height(),
+                [](const char *s, int n) { return (int)fl_width(s, n); });
+}
+
+/// Labels are measured through TextCache, and images by FLTK, with room for the box's border and
+/// a margin
+void Layout::measure(void *view, int &width, int &height) {
+    auto v = (Fl_Widget *)view;
+    width = height = 0;
+    if (!v->label() && !v->image())
+        return;
+    if (v->image()) {
+        v->measure_label(width, height);
+    } else {
+        auto &m = TextCache::measure(v->label(), Font{v->labelfont(), v->labelsize()});
+        width = m.width;
+        height = m.height;
+    }
+    width += Fl::box_dw(v->box()) + 8;
+    height += Fl::box_dh(v->box()) + 8;
+}
+
+void Layout::apply(void *view, const Frame &frame) {
+    auto v = (Fl_Widget *)view;
+    v->resize(frame.x, frame.y, frame.width, frame.height);
+    v->redraw();
+}
+
+/// Sets the label's properties, and an input's text ones, then redraws and relayouts once
+void Style::show(void *view, const Style &s) {
+    static constexpr Fl_Align align[] = {FL_ALIGN_LEFT | FL_ALIGN_INSIDE, FL_ALIGN_CENTER,
+                                         FL_ALIGN_RIGHT | FL_ALIGN_INSIDE};
+    static constexpr Fl_Font font[] = {FL_HELVETICA, FL_HELVETICA_BOLD, FL_HELVETICA_ITALIC};
+    auto v = (Fl_Widget *)view;
+    auto input = dynamic_cast<Fl_Input_ *>(v);
+    if (s.has(Background))
+        v->color(s.background());
+    if (s.has(Foreground)) {
+        v->labelcolor(s.foreground());
+        if (input)
+            input->textcolor(s.foreground());
+    }
+    if (s.has(Fontsize)) {
+        v->labelsize(s.fontsize());
+        if (input)
+            input->textsize(s.fontsize());
+    }
+    if (s.has(Font))
+        v->labelfont(font[(int)s.font()]);
+    if (s.has(Alignment))
+        v->align(align[(int)s.align()]);
+    v->redraw();
+    if (s.has(Fontsize) || s.has(Font))
+        Layout::dirty(view);
+}
+
 Button::Button(void *v) : Widget(v) {}
 
 Button::Button(const std::string &label) : Widget(new Fl_Button(0, 0, 0, 0, 0)) {
@@ -115,10 +268,10 @@ Button::Button(const std::string &label) : Widget(new Fl_Button(0, 0, 0, 0, 0))
     v->down_color(FL_WHITE);
 }
 
-Button &Button::action(std::function<void(Widget &)> &&f) {
+Button &Button::action(Action &&f) {
     auto v = ((Fl_Button *)view);
-    c::callbacks.push_back(new std::function<void(Widget &)>(f));
-    v->callback(widget_cb, c::callbacks.back());
+    auto slot = FlouiViewController::add_callback(std::move(f));
+    v->callback(widget_cb, (void *)(intptr_t)slot);
     return *this;
 }
 
@@ -132,15 +285,148 @@ Text::Text(const std::string &label) : Widget(new Fl_Box(0, 0, 0, 0, 0)) {
 }
 
 Text &Text::text(const std::string &label) {
+    PROPERTY_WRITE(Text, Text, text, label)
     auto v = ((Fl_Box *)view);
     v->copy_label(label.c_str());
+    Layout::dirty(view);
     return *this;
 }
 
 DEFINE_STYLES(Text)
 
+ImageView::ImageView(void *v) : Widget(v) {}
+
+ImageView::ImageView() : Widget(new Fl_Box(0, 0, 0, 0, 0)) {}
+
+ImageView::ImageView(const std::string &path) : Widget(new Fl_Box(0, 0, 0, 0, 0)) {
+    Images::load(view, path);
+}
+
+ImageView &ImageView::image(const std::string &path) {
+    PROPERTY_WRITE(ImageView, Image, image, path)
+    Images::load(view, path);
+    return *this;
+}
+
+DEFINE_STYLES(ImageView)
+
+/// Picks the loader by extension. Loaders only decode into memory, so they can run off the UI
+/// thread, and so can copy, which does the downsampling
+Image Images::decode(const std::string &path, int width, int height) {
+    std::unique_ptr<Fl_RGB_Image> src;
+    auto ext = path.substr(path.rfind('.') + 1);
+    if (ext == "png")
+        src.reset(new Fl_PNG_Image(path.c_str()));
+    else if (ext == "jpg" || ext == "jpeg")
+        src.reset(new Fl_JPEG_Image(path.c_str()));
+    else if (ext == "bmp")
+        src.reset(new Fl_BMP_Image(path.c_str()));
+    if (!src || src->fail() || src->w() <= 0 || src->h() <= 0)
+        return {};
+    fit(src->w(), src->h(), width, height);
+    auto image = src.get();
+    if (width != src->w() || height != src->h())
+        image = (Fl_RGB_Image *)src->copy(width, height);
+    else
+        src.release();
+    return Image{image, width, height, (size_t)width * height * image->d()};
+}
+
+void Images::release(const Image &image) { delete (Fl_RGB_Image *)image.native; }
+
+void Images::show(void *view, const Image *image) {
+    auto v = (Fl_Box *)view;
+    v->image(image ? (Fl_RGB_Image *)image->native : nullptr);
+    v->redraw();
+    Layout::dirty(view);
+}
+
+void Images::target(void *view, int &width, int &height) {
+    auto v = (Fl_Widget *)view;
+    width = v->w();
+    height = v->h();
+}
+
+/// Rows are children of the group, positioned by a RowRecycler beside a scrollbar. Fl_Scroll
+/// sizes its scroll range from its children, so it can't represent rows which don't exist yet
+class FlListView : public Fl_Group {
+    RowRecycler rows;
+    Fl_Scrollbar bar;
+
+    static void scroll_cb(Fl_Widget *, void *data) { ((FlListView *)data)->relayout(); }
+
+    void place(Widget &row, int dy) {
+        auto w = (Fl_Widget *)row.inner();
+        if (w->parent() != this)
+            add(w);
+        w->resize(x(), y() + dy, this->w() - bar.w(), rows.row_height());
+        w->show();
+    }
+
+  public:
+    explicit FlListView(int list) : Fl_Group(0, 0, 0, 0), rows(list), bar(0, 0, 0, 0) {
+        end();
+        add(bar);
+        bar.linesize(rows.row_height());
+        bar.callback(scroll_cb, this);
+    }
+    ~FlListView() { ListView::forget(this); }
+
+    void relayout() {
+        auto total = rows.content_height();
+        auto offset = std::max(0, std::min(bar.value(), total - h()));
+        bar.value(offset, h(), 0, total);
+        rows.layout(
+            offset, h(), [this](Widget &row, int dy) { place(row, dy); },
+            [](Widget &row) { ((Fl_Widget *)row.inner())->hide(); });
+        redraw();
+    }
+
+    /// Rebinds the rows in view
+    void rebind() {
+        rows.reset([](Widget &row) { ((Fl_Widget *)row.inner())->hide(); });
+        relayout();
+    }
+
+    void resize(int X, int Y, int W, int H) override {
+        Fl_Widget::resize(X, Y, W, H);
+        bar.resize(X + W - 16, Y, 16, H);
+        relayout();
+    }
+
+    int handle(int event) override {
+        if (event == FL_MOUSEWHEEL) {
+            bar.value(bar.value() + Fl::event_dy() * rows.row_height(), h(), 0,
+                      rows.content_height());
+            relayout();
+            return 1;
+        }
+        return Fl_Group::handle(event);
+    }
+};
+
+ListView::ListView(void *v) : Widget(v) {}
+
+ListView::ListView(int count, Create create, Bind bind, Type type) : Widget(nullptr) {
+    auto list = add_list(count, std::move(create), std::move(bind), std::move(type));
+    view = new FlListView(list);
+    ids_[view] = list;
+}
+
+ListView &ListView::count(int n) {
+    list().count = n;
+    ((FlListView *)view)->rebind();
+    return *this;
+}
+
+DEFINE_STYLES(ListView)
+
 static int val = 0;
 
+static constexpr auto mytext = "mytext"_id;
+
+static const Style row = Style().fontsize(16).left();
+
 MainView myview(const FlouiViewController &controller) {
     // clang-format off
     auto main_view = MainView(controller, {
@@ -148,16 +434,20 @@ MainView myview(const FlouiViewController &controller) {
             .action([](auto) { 
                 floui_log("incr"); 
                 val += 1;
-                Widget::from_id<Text>("mytext").text(std::to_string(val));
+                Widget::from_id<Text>(mytext).text(std::to_string(val));
             }),
         Text("0")
-            .id("mytext"), 
+            .id(mytext), 
         Button("Decrement")
             .action([](auto) {
                 floui_log("decr");
                 val -= 1;
-                Widget::from_id<Text>("mytext").text(std::to_string(val));
-            })
+                Widget::from_id<Text>(mytext).text(std::to_string(val));
+            }),
+        ListView(1000000, 
+            [](int) { return Text("").style(row); },
+            [](Widget &row, int i) { Text(row.inner()).text("row " + std::to_string(i)); })
+            .grow(1)
     });
     // clang-format on
     return main_view;
@@ -0,0 +1,688 @@
+// Runs the headless backend: builds every widget, injects events and checks the resulting views
+
+#define FLOUI_HEADLESS
+#define FLOUI_IMPL
+#include "../floui.hpp"
+
+#include <thread>
+
+using namespace floui;
+using headless::View;
+
+static int failures = 0;
+
+static void check(bool ok, const char *what) {
+    if (!ok) {
+        fprintf(stderr, "FAILED: %s\n", what);
+        failures++;
+    }
+}
+
+static constexpr auto count = "count"_id;
+
+static MainView counter(const FlouiViewController &controller, int &val) {
+    // clang-format off
+    return MainView(controller, {
+        Button("Increment")
+            .foreground(Color::Blue)
+            .action([&](Widget &) {
+                val++;
+                Widget::from_id<Text>(count).text(std::to_string(val));
+            }),
+        Text("0")
+            .center()
+            .bold()
+            .fontsize(20)
+            .id(count),
+        Button("Decrement")
+            .action([&](Widget &) {
+                val--;
+                Widget::from_id<Text>(count).text(std::to_string(val));
+            }),
+    });
+    // clang-format on
+}
+
+static void widgets() {
+    auto toggle = Toggle("Wifi").value(true).foreground(Color::Red);
+    auto check_box = Check("Agree");
+    auto slider = Slider().value(0.25);
+    auto field = TextField().text("name").fontsize(12).right();
+    auto image = ImageView("image.png");
+    auto web = WebView().load_url("https://example.com");
+    auto spacer = Spacer().size(10, 20).background(Color::Gray);
+    auto stack = HStack({toggle, check_box}).spacing(4);
+    auto scroll = ScrollView(VStack({stack, slider, field, image, web, spacer}));
+
+    check(headless::view(toggle).value == 1, "toggle value");
+    check(headless::view(toggle).foreground == Color::Red, "toggle foreground");
+    check(headless::view(check_box).text == "Agree", "check label");
+    check(Slider(slider.inner()).value() == 0.25, "slider value");
+    check(headless::view(field).align == View::Align::Right, "text field alignment");
+    check(headless::view(image).text == "image.png", "image path");
+    check(headless::view(web).text == "https://example.com", "web view url");
+    check(headless::view(spacer).width == 10 && headless::view(spacer).height == 20,
+          "spacer size");
+    check(headless::view(stack).children.size() == 2 && headless::view(stack).spacing == 4,
+          "stack children");
+    check(headless::view(scroll).children.size() == 1 &&
+              headless::view(scroll).children[0]->children.size() == 6,
+          "scroll view child");
+    check(headless::view(toggle).parent == &headless::view(stack), "parent");
+
+    std::vector<Text> rows;
+    for (int i = 0; i < 3; i++)
+        rows.push_back(Text(std::to_string(i)));
+    auto column = VStack(Text("title"), HStack(Button("a"), Button("b")))
+                      .add(rows.begin(), rows.end());
+    auto copy = VStack(column);
+    auto &children = headless::view(column).children;
+    check(children.size() == 5 && children[1]->children.size() == 2 && children[4]->text == "2",
+          "variadic and range children");
+    check(copy.inner() == column.inner() && VStack().inner() != column.inner(),
+          "a single stack is copied");
+
+    int toggled = 0;
+    double slid = 0;
+    toggle.action([&](Widget &w) { toggled += Toggle(w.inner()).value() ? 1 : 10; });
+    slider.action([&](Widget &w) { slid = Slider(w.inner()).value(); });
+    headless::click(toggle);
+    headless::click(toggle);
+    headless::slide(slider, 0.75);
+    headless::type(field, "typed");
+    check(toggled == 11, "toggle clicks flip the value");
+    check(slid == 0.75, "slider event");
+    check(field.text() == "typed", "typed text");
+}
+
+static void events(const FlouiViewController &controller) {
+    int val = 0;
+    auto main_view = counter(controller, val);
+    auto &root = headless::view(main_view);
+    check(root.children.size() == 3, "main view children");
+    auto text = Widget::from_id<Text>(count);
+    check(headless::view(text).bold && headless::view(text).fontsize == 20, "text style");
+    auto incr = Button(root.children[0]);
+    auto decr = Button(root.children[2]);
+    headless::click(incr);
+    headless::click(incr);
+    headless::click(decr);
+    check(val == 1 && headless::view(text).text == "1", "clicks update the text");
+    // Android's dispatch path
+    FlouiViewController::handle_events(incr.inner());
+    check(val == 2 && headless::view(text).text == "2", "handle_events");
+
+    main_view.remove(text);
+    check(root.children.size() == 2 && !headless::view(text).parent, "remove");
+    main_view.clear();
+    check(root.children.empty(), "clear");
+}
+
+static void batching() {
+    auto text = Text("");
+    auto button = Button("Tap").action([&](Widget &) {
+        for (int i = 0; i <= 10; i++)
+            text.text(std::to_string(i));
+        check(headless::view(text).text.empty(), "batched writes wait for the flush");
+    });
+    FlouiViewController::batch(true);
+    headless::click(button);
+    check(headless::view(text).text == "10", "the last batched write wins");
+
+    // Getters read the writes queued before them
+    auto toggle = Toggle("On");
+    auto field = TextField();
+    auto flip = Button("Flip").action([&](Widget &) {
+        toggle.value(!toggle.value());
+        toggle.value(!toggle.value());
+        toggle.value(!toggle.value());
+        field.text("typed");
+        field.text(field.text() + "!");
+    });
+    headless::click(flip);
+    FlouiViewController::batch(false);
+    check(headless::view(toggle).value == 1 && headless::view(field).text == "typed!",
+          "getters read queued writes");
+}
+
+/// Clears a flag once destroyed, to tell when a callback's captures go away
+struct Guard {
+    bool *alive;
+    explicit Guard(bool *alive) : alive(alive) { *alive = true; }
+    Guard(Guard &&other) noexcept : alive(other.alive) { other.alive = nullptr; }
+    ~Guard() {
+        if (alive)
+            *alive = false;
+    }
+};
+
+static void releasing() {
+    // A button rebuilding the screen releases its own callback, whose captures have to outlive
+    // the call
+    bool alive = false, alive_during_call = false;
+    auto mark = FlouiViewController::callback_mark();
+    auto rebuild =
+        Button("Rebuild").action([guard = Guard(&alive), mark, &alive_during_call](Widget &) {
+            FlouiViewController::release_callbacks(mark);
+            Button("Rebuilt").action([](Widget &) {});
+            alive_during_call = *guard.alive;
+        });
+    headless::click(rebuild);
+    check(alive_during_call && !alive && FlouiViewController::callback_mark() == mark + 1,
+          "a callback releasing its own slot");
+
+    // A slot released twice is handed out once
+    auto slot = FlouiViewController::add_callback([](Widget &) {});
+    FlouiViewController::release_callback(slot);
+    FlouiViewController::release_callback(slot);
+    auto first = FlouiViewController::add_callback([](Widget &) {});
+    auto second = FlouiViewController::add_callback([](Widget &) {});
+    check(first == slot && second != slot, "a slot released twice is reused once");
+}
+
+static void tree(const FlouiViewController &controller) {
+    auto main_view = MainView(controller, {});
+    Tree t(main_view);
+    auto rows = [](int changed) {
+        std::vector<Node> children;
+        for (int i = 0; i < 10; i++)
+            children.push_back(
+                node::HStack({node::Text(std::to_string(i)), node::Toggle("on").value(i == changed)})
+                    .key(i));
+        return node::VStack(std::move(children));
+    };
+    t.render(rows(-1));
+    t.render(rows(3));
+    auto &stack = *headless::view(main_view).children.at(0);
+    check(stack.children.size() == 10, "rendered rows");
+    check(stack.children[3]->children[1]->value == 1, "rendered toggle value");
+    check(t.stats().created == 31 && t.stats().updated == 1, "render stats");
+
+    // Reordering keyed rows moves only those out of order, and leaves the native order right
+    auto ordered = [&](std::vector<int> keys) {
+        std::vector<Node> children;
+        for (auto k : keys)
+            children.push_back(node::Text(std::to_string(k)).key(k));
+        auto moved = t.stats().moved;
+        t.render(node::VStack(std::move(children)));
+        std::string shown;
+        for (auto v : headless::view(main_view).children.at(0)->children)
+            shown += v->text;
+        std::string expected;
+        for (auto k : keys)
+            expected += std::to_string(k);
+        return shown == expected ? t.stats().moved - moved : size_t(-1);
+    };
+    ordered({1, 2, 3, 4, 5});
+    check(ordered({0, 1, 2, 3, 4, 5}) == 0, "prepending a row moves none");
+    check(ordered({5, 0, 1, 2, 3, 4}) == 1, "moving the last row first moves one");
+    check(ordered({0, 2, 1, 3, 6, 4}) == 1, "swapping rows moves one");
+    check(ordered({4, 6, 3, 1, 2, 0}) == 5, "reversing rows moves all but one");
+
+    // A screen re-rendered with different children reuses the callback slots of the removed ones
+    int clicked = -1;
+    auto churn = [&](int tick) {
+        std::vector<Node> children;
+        for (int i = 0; i < 5 + tick % 5; i++)
+            children.push_back(node::Button("Item")
+                                   .action([&clicked, tick](Widget &) { clicked = tick; })
+                                   .key(tick * 100 + i));
+        children.push_back(node::Text(std::to_string(tick)).id("churned"_id).key(-tick));
+        return node::VStack(std::move(children));
+    };
+    for (int tick = 0; tick < 10; tick++)
+        t.render(churn(tick));
+    auto slots = FlouiViewController::callback_slots();
+    for (int tick = 10; tick <= 1000; tick++)
+        t.render(churn(tick));
+    auto &churned = *headless::view(main_view).children.at(0);
+    headless::click(Button(churned.children[0]));
+    check(FlouiViewController::callback_slots() == slots, "re-rendering reuses callback slots");
+    check(clicked == 1000 && Widget::from_id<Text>("churned"_id).inner() == churned.children.back(),
+          "re-rendered callbacks and ID");
+
+    // A view recreated under the same key is destroyed, along with its ID, layout node and
+    // bindings
+    State<int> value(0);
+    t.render(node::VStack({node::Text("0").id("recreated"_id).key(1)}));
+    Widget::from_id<Text>("recreated"_id).text(bind(value, to_string));
+    auto views = headless::views();
+    auto nodes = Layout::size();
+    auto effects = Effect::attached();
+    t.render(node::VStack({node::Button("0").key(1)}));
+    check(headless::views() == views && Layout::size() == nodes &&
+              Effect::attached() == effects - 1 && !Widget::has_id("recreated"_id),
+          "recreated views are destroyed");
+    value.set(1);
+}
+
+static void bindings(const FlouiViewController &controller) {
+    State<int> count(0);
+    auto label = Text(bind(count, to_string));
+    auto toggle = Toggle("On").value(bind(count, [](int v) { return v % 2 == 1; }));
+    count.set(1);
+    check(headless::view(label).text == "1" && headless::view(toggle).value == 1,
+          "bound properties");
+
+    // The binding's first run gives a bound text its initial value, it isn't evaluated twice
+    int evaluated = 0;
+    auto once = Text(bind(count, [&](int v) {
+        evaluated++;
+        return std::to_string(v);
+    }));
+    check(evaluated == 1 && headless::view(once).text == "1", "bound text evaluated once");
+
+    // Rebinding replaces the binding, rather than adding one which fights it
+    State<int> other(10);
+    label.text(bind(other, to_string));
+    count.set(2);
+    check(headless::view(label).text == "10" && headless::view(toggle).value == 0,
+          "rebinding replaces the binding");
+
+    // A binding only subscribes to what its last run read
+    State<bool> which(true);
+    label.text(bind([=] { return which.get() ? std::to_string(count.get()) : "off"; }));
+    which.set(false);
+    count.set(3);
+    check(headless::view(label).text == "off", "bindings drop the states they no longer read");
+
+    // Discarding a view drops its bindings
+    auto main_view = MainView(controller, {});
+    Tree t(main_view);
+    t.render(node::VStack({node::Text("").id("bound"_id)}));
+    Widget::from_id<Text>("bound"_id).text(bind(count, to_string));
+    auto effects = Effect::attached();
+    t.render(node::VStack({}));
+    count.set(4);
+    check(Effect::attached() == effects - 1, "discarded views drop their bindings");
+}
+
+static void lists() {
+    size_t made = 0;
+    auto lazy = LazyVStack(2000, [&](int i) {
+                    made++;
+                    return Text(std::to_string(i));
+                })
+                    .estimate(50)
+                    .budget(60);
+    auto scroll = ScrollView(lazy);
+    check(made == 23, "lazy stack makes the children in view");
+    headless::scroll(scroll, 0, 50000, 400, 1000);
+    auto &kids = headless::view(lazy).children;
+    // Lead spacer, children 998 to 1022, trail spacer
+    check(kids.size() == 27 && kids[1]->text == "998", "lazy stack scrolled");
+    check(headless::view(lazy).children.front()->height == 998 * 50, "lead spacer");
+
+    // Scrolling back inserts the children coming into view and removes those evicted, the
+    // others staying in place
+    auto calls = headless::container_calls();
+    auto made_before = made;
+    auto evicted = lazy.evicted();
+    headless::scroll(scroll, 0, 49000, 400, 1000);
+    headless::scroll(scroll, 0, 48000, 400, 1000);
+    // Children 958 to 1017 in order, the budget having evicted those past them
+    bool in_order = kids.size() == 62;
+    for (size_t k = 1; in_order && k < 61; k++)
+        in_order = kids[k]->text == std::to_string(957 + k);
+    check(in_order, "lazy stack scrolled back");
+    check(lazy.evicted() > evicted &&
+              headless::container_calls() - calls == made - made_before + lazy.evicted() - evicted,
+          "scrolling back only inserts and evicts the children which change");
+
+    // Evicted children are destroyed along with their views and callbacks
+    auto buttons = LazyVStack(2000, [](int i) {
+                       auto open = Button("Open").action([](Widget &) {});
+                       return HStack(Text(std::to_string(i)), open);
+                   })
+                       .estimate(50)
+                       .budget(30);
+    auto buttons_scroll = ScrollView(buttons);
+    headless::scroll(buttons_scroll, 0, 10000, 400, 1000);
+    auto views = headless::views();
+    auto slots = FlouiViewController::callback_slots();
+    for (int y = 20000; y <= 90000; y += 10000)
+        headless::scroll(buttons_scroll, 0, y, 400, 1000);
+    check(buttons.evicted() > 100 && headless::views() == views &&
+              FlouiViewController::callback_slots() == slots,
+          "evicted children destroyed");
+
+    auto list = ListView(
+        1000000, [](int) { return Text(""); },
+        [](Widget &row, int i) { Text(row.inner()).text(std::to_string(i)); });
+    headless::scroll(list, 0, 4000, 400, 400);
+    auto &rows = headless::view(list).children;
+    check(rows.size() == 15 && rows.front()->text == "98", "list scrolled");
+    list.count(50);
+    headless::scroll(list, 0, 1e6, 400, 400);
+    check(rows.empty(), "list shrunk");
+
+    // Forgetting a list releases its functions, and the adapter entry points refuse its id
+    auto captured = std::make_shared<int>(0);
+    auto forgotten = ListView(
+        10, [captured](int) { return Text(""); }, [](Widget &, int) {});
+    auto id = forgotten.list_id();
+    ListView::forget(forgotten.inner());
+    check(captured.use_count() == 1 && ListView::row_count(id) == 0 &&
+              !ListView::create_row(id, 0).inner() && ListView::row_count(-1) == 0 &&
+              ListView::row_type(1 << 20, 0) == 0,
+          "forgotten lists");
+    auto reused = ListView(
+        3, [](int) { return Text(""); }, [](Widget &, int) {});
+    check(reused.list_id() == id && ListView::row_count(id) == 3, "list ids reused");
+}
+
+static bool framed(const Widget &w, int x, int y, int width, int height) {
+    auto f = Layout::frame(w.inner());
+    return f.x == x && f.y == y && f.width == width && f.height == height;
+}
+
+/// Stacks are laid out by Layout, and only what changed is laid out again
+static void layout(const FlouiViewController &controller) {
+    auto title = Text("Title");
+    auto name = Text("Name").fontsize(20);
+    auto fill = Spacer().grow(1);
+    auto ok = Button("OK");
+    auto row = HStack({name, fill, ok}).spacing(10).padding(5).align(Layout::Align::Center);
+    MainView(controller, {title, row}).size(300, 200);
+    Layout::update();
+    check(framed(title, 0, 0, 300, 16) && framed(row, 0, 16, 300, 34), "stretched across");
+    check(framed(name, 5, 21, 48, 24) && framed(fill, 63, 33, 206, 0) &&
+              framed(ok, 279, 25, 16, 16),
+          "grown and centered");
+    check(headless::view(ok).frame.x == 279, "frame applied");
+
+    auto measured = Layout::measured();
+    auto applied = Layout::applied();
+    name.text("Nom!");
+    Layout::update();
+    check(Layout::measured() - measured == 1 && Layout::applied() == applied,
+          "same size text laid out in place");
+    name.text("Full name");
+    Layout::update();
+    check(framed(name, 5, 21, 108, 24) && framed(fill, 123, 33, 146, 0) &&
+              Layout::applied() - applied == 2,
+          "only the frames which changed applied");
+
+    auto first = Text("First");
+    auto second = Text("Second");
+    row.replace_children({ok, name}).add_all(std::vector<Text>{first, second});
+    Layout::update();
+    auto &children = headless::view(row).children;
+    check(children.size() == 4 && children[0] == &headless::view(ok) &&
+              children[3] == &headless::view(second) && headless::view(fill).parent == nullptr,
+          "children replaced and added in bulk");
+    check(headless::view(first).frame.x > headless::view(name).frame.x &&
+              headless::view(second).frame.x > headless::view(first).frame.x,
+          "bulk children laid out");
+}
+
+/// Text metrics are cached by text and font, and shared by layout and truncation
+static void text_cache() {
+    TextCache::clear();
+    Font font{0, 10};
+    auto &m = TextCache::measure("one two three", font, 40);
+    check(m.width == 30 && m.height == 36 && m.breaks == std::vector<uint32_t>{4, 8},
+          "text wrapped");
+    check(TextCache::truncate("one two three", font, 40) == "one..." &&
+              TextCache::truncate("one", font, 40) == "one",
+          "text truncated");
+    check(TextCache::hits() == 1 && TextCache::misses() == 2, "metrics shared");
+    TextCache::measure("one two three", Font{0, 10, true}, 40);
+    check(TextCache::size() == 3 && TextCache::misses() == 3, "fonts cached apart");
+    TextCache::invalidate(0);
+    check(TextCache::size() == 0, "face invalidated");
+    TextCache::capacity(2);
+    for (auto t : {"a", "b", "c"})
+        TextCache::measure(t, font);
+    check(TextCache::size() == 2, "least recently used text evicted");
+    TextCache::capacity(4096);
+}
+
+static void styles() {
+    auto row = Style().foreground(Color::Blue).fontsize(20).bold().center();
+    auto text = Text("styled").style(row);
+    auto button = Button("styled").style(Style(row));
+    auto &v = headless::view(text);
+    check(v.foreground == Color::Blue && v.fontsize == 20 && v.bold &&
+              v.align == headless::View::Align::Center,
+          "style applied");
+    check(headless::view(button).foreground == Color::Blue && headless::view(button).fontsize == 14,
+          "only the properties a widget has applied");
+    check(Style::of(text.inner()) == Style::of(button.inner()) &&
+              Style::of(text.inner()) == &row.intern(),
+          "equal styles shared");
+    FlouiViewController::elide(true);
+    text.style(row);
+    auto elided = FlouiViewController::elided_writes();
+    text.style(row).foreground(Color::Red).style(row);
+    check(FlouiViewController::elided_writes() == elided + 1 && v.foreground == Color::Blue,
+          "restyling elided until a property changes");
+
+    // Typing invalidates the elided text, so writing back the previous one isn't skipped
+    auto field = TextField().text("a");
+    headless::type(field, "b");
+    field.text("a");
+    check(headless::view(field).text == "a", "typing invalidates the elided text");
+    FlouiViewController::elide(false);
+    FlouiViewController::batch(true);
+    text.style(Style().fontsize(30)).style(Style().fontsize(40));
+    check(v.fontsize == 20, "batched style waits for the flush");
+    FlouiViewController::batch(false);
+    check(v.fontsize == 40, "the last batched style wins");
+}
+
+static void tracing(const FlouiViewController &controller) {
+    int val = 0;
+    counter(controller, val);
+    check(Trace::size() == 0, "nothing traced while not recording");
+    Trace::start();
+    auto main_view = counter(controller, val);
+    headless::click(Button(headless::view(main_view).children[0]));
+    Trace::stop();
+    // 3 widgets, 2 styled setters, the main view and the splice of its children, a callback and
+    // its text write, and the layout after the click
+    check(Trace::size() == 10, "spans recorded");
+    auto path = "headless_trace.json";
+    check(Trace::write(path), "trace written");
+    std::string json;
+    if (auto f = fopen(path, "r")) {
+        char buf[4096];
+        size_t n;
+        while ((n = fread(buf, 1, sizeof(buf), f)))
+            json.append(buf, n);
+        fclose(f);
+    }
+    remove(path);
+    check(json.find("\"name\": \"MainView::MainView\"") != std::string::npos &&
+              json.find("\"name\": \"callback\"") != std::string::npos &&
+              json.find("\"ph\": \"X\"") != std::string::npos,
+          "trace events");
+    Trace::clear();
+}
+
+/// Posts from other threads run on the drain, in order and batched per wake
+static void posting() {
+    auto text = Text("0");
+    auto wakes = headless::wakes();
+    std::thread([=] {
+        for (int i = 1; i <= 3; i++)
+            post([=] { Text(text.inner()).text(std::to_string(i)); });
+        post_batch({[=] { Text(text.inner()).fontsize(30); }, [=] { Text(text.inner()).bold(); }});
+    }).join();
+    check(headless::wakes() == wakes + 1, "one wake per batch of posts");
+    check(headless::view(text).text == "0", "posts wait for the drain");
+    check(FlouiViewController::drain() == 5 && FlouiViewController::drain() == 0, "drain");
+    auto &v = headless::view(text);
+    check(v.text == "3" && v.fontsize == 30 && v.bold, "posted writes");
+
+    // Millions of posts from many threads, half of them in batches, drained as they come
+    constexpr int threads = 8, per = 250000, batch = 64;
+    std::vector<int> last(threads, -1);
+    bool ordered = true;
+    std::atomic<int> done{0};
+    std::vector<std::thread> posters;
+    for (int t = 0; t < threads; t++)
+        posters.emplace_back([&, t] {
+            auto task = [&](int i) {
+                return [&, t, i] {
+                    ordered &= last[t] + 1 == i;
+                    last[t] = i;
+                };
+            };
+            if (t % 2) {
+                for (int i = 0; i < per; i++)
+                    post(task(i));
+            } else {
+                for (int i = 0; i < per; i += batch) {
+                    std::vector<std::function<void()>> fs;
+                    for (int j = i; j < std::min(per, i + batch); j++)
+                        fs.push_back(task(j));
+                    post_batch(std::move(fs));
+                }
+            }
+            done++;
+        });
+    size_t ran = 0, drains = 0;
+    wakes = headless::wakes();
+    while (done < threads || ran < (size_t)threads * per) {
+        if (auto n = FlouiViewController::drain()) {
+            ran += n;
+            drains++;
+        }
+    }
+    for (auto &t : posters)
+        t.join();
+    printf("%d posts from %d threads: %zu drains, %zu wakes\n", threads * per, threads, drains,
+           headless::wakes() - wakes);
+    check(ran == (size_t)threads * per && ordered, "posts from many threads");
+    check(drains < ran / 10, "posts drained in batches");
+}
+
+/// Drains posts until every image load has finished
+static void load_images() {
+    while (Images::pending())
+        FlouiViewController::drain();
+}
+
+/// Images are decoded off the UI thread at their view's size, and cached by path and size
+static void images() {
+    load_images();
+    auto decodes = Images::decodes();
+    auto a = ImageView("photo.png").size(200, 200);
+    auto b = ImageView("photo.png").size(200, 200);
+    auto small = ImageView("photo.png").size(64, 0);
+    check(!headless::view(a).image && Images::pending() == 3, "images load on the next drain");
+    load_images();
+    auto shown = headless::view(a).image;
+    check(shown && shown->width == 200 && shown->height == 150, "image downsampled to its view");
+    check(headless::view(b).image == shown && headless::view(small).image->width == 64 &&
+              Images::decodes() - decodes == 2,
+          "decodes shared by views of the same size");
+
+    auto hits = Images::hits();
+    auto again = ImageView("photo.png").size(200, 200);
+    FlouiViewController::drain();
+    check(headless::view(again).image == shown && Images::hits() == hits + 1 &&
+              Images::pending() == 0,
+          "cached image shown on the next drain");
+
+    auto budget = Images::budget();
+    Images::budget(shown->bytes);
+    check(Images::size() == 1 && Images::bytes() <= shown->bytes &&
+              headless::view(a).image == shown,
+          "images evicted over budget stay shown");
+    Images::budget(budget);
+
+    Images::placeholder("placeholder.png");
+    auto later = ImageView("later.png").size(10, 10);
+    check(headless::view(later).image && headless::view(later).image->width == 1024,
+          "placeholder shown while loading");
+    load_images();
+    check(headless::view(later).image->width == 10, "placeholder replaced");
+    Images::placeholder("");
+}
+
+#ifdef FLOUI_COROUTINES
+/// Drains posts until n tasks have run
+static void settle(size_t n) {
+    for (size_t ran = 0; ran < n;)
+        ran += FlouiViewController::drain();
+}
+
+/// Coroutine actions run their background work off the UI thread, and are dropped once cancelled
+static void coroutines() {
+    auto text = Text("idle");
+    std::thread::id worker;
+    std::atomic<bool> loaded{false};
+    auto load = Button("Load").action([&, text](Widget) -> task {
+        Text(text.inner()).text("loading");
+        auto n = co_await background([&] {
+            worker = std::this_thread::get_id();
+            while (!loaded)
+                std::this_thread::yield();
+            return 42;
+        });
+        Text(text.inner()).text(std::to_string(n));
+    });
+    headless::click(load);
+    check(headless::view(text).text == "loading" && FlouiViewController::inflight() == 1,
+          "task suspended");
+    loaded = true;
+    settle(1);
+    check(headless::view(text).text == "42" && worker != std::this_thread::get_id() &&
+              FlouiViewController::inflight() == 0,
+          "task resumed on the UI thread");
+
+    struct Destroyed {
+        bool &flag;
+        ~Destroyed() { flag = true; }
+    };
+    std::atomic<bool> release{false};
+    bool resumed = false, destroyed = false;
+    auto slow = Button("Slow").action([&](Widget) -> task {
+        Destroyed d{destroyed};
+        co_await background([&] {
+            while (!release)
+                std::this_thread::yield();
+        });
+        resumed = true;
+    });
+    headless::click(slow);
+    FlouiViewController::cancel(slow.inner());
+    release = true;
+    settle(1);
+    check(!resumed && destroyed && FlouiViewController::inflight() == 0, "cancelled task");
+}
+#endif
+
+int main() {
+    FlouiViewController controller(nullptr);
+    widgets();
+    images();
+    events(controller);
+    batching();
+    releasing();
+    tree(controller);
+    bindings(controller);
+    lists();
+    layout(controller);
+    text_cache();
+    styles();
+    tracing(controller);
+    posting();
+#ifdef FLOUI_COROUTINES
+    coroutines();
+#endif
+    State<int> count(0);
+    Text(bind(count, to_string));
+    auto before = headless::views();
+    headless::reset();
+    check(before > 0 && headless::views() == 0, "reset");
+    // Writes to the views reset freed
+    count.set(1);
+    lists();
+    if (failures)
+        return 1;
+    printf("headless: all checks passed\n");
+    return 0;
+}
@@ -32,12 +32,52 @@ Java_com_example_myapplication_MainActivity_mainView(
 }
 extern "C"
 JNIEXPORT void JNICALL
-Java_com_example_myapplication_MainActivity_handleEvent(JNIEnv *env, jobject thiz, jobject view) {
-    FlouiViewController::handle_events(view);
+Java_com_example_myapplication_MainActivity_handleEvent(JNIEnv *, jobject, jint slot,
+                                                        jobject view) {
+    FlouiViewController::handle_event(slot, view);
 }
 extern "C"
 JNIEXPORT jobject JNICALL
-Java_com_example_myapplication_MainActivity_findNativeViewById(JNIEnv *env, jobject thiz,
-                                                               jstring id) {
-    return (jobject)Widget::from_id<Widget>(reinterpret_cast<const char *>(id)).inner();
-}
\ No newline at end of file
+Java_com_example_myapplication_MainActivity_findNativeViewById(JNIEnv *env, jobject, jstring id) {
+    auto chars = env->GetStringUTFChars(id, nullptr);
+    auto view = Widget::from_id<Widget>(chars).inner();
+    env->ReleaseStringUTFChars(id, chars);
+    return (jobject)view;
+}
+extern "C"
+JNIEXPORT jint JNICALL
+Java_com_example_myapplication_MainActivity_rowCount(JNIEnv *, jobject, jint list) {
+    return ListView::row_count(list);
+}
+extern "C"
+JNIEXPORT jint JNICALL
+Java_com_example_myapplication_MainActivity_rowType(JNIEnv *, jobject, jint list, jint position) {
+    return ListView::row_type(list, position);
+}
+extern "C"
+JNIEXPORT jobject JNICALL
+Java_com_example_myapplication_MainActivity_createRow(JNIEnv *, jobject, jint list, jint type) {
+    return (jobject)ListView::create_row(list, type).inner();
+}
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_myapplication_MainActivity_bindRow(JNIEnv *, jobject, jint list, jobject view,
+                                                    jint position) {
+    ListView::bind_row(list, view, position);
+}
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_myapplication_MainActivity_scrolled(JNIEnv *, jobject, jint id, jint x, jint y,
+                                                     jint w, jint h) {
+    LazyStack::scrolled(id, x, y, w, h);
+}
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_myapplication_MainActivity_drainPosts(JNIEnv *, jobject) {
+    FlouiViewController::drain();
+}
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_myapplication_MainActivity_textChanged(JNIEnv *, jobject, jobject view) {
+    FlouiViewController::invalidate(view, Prop::Text);
+}
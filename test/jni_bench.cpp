@@ -0,0 +1,611 @@
+// Runs the Android backend against a mock JNIEnv (see jni_mock.hpp) and reports the JNI calls
+// and wall time each widget type and some representative trees cost.
+// Exits with a non-zero status if any count goes over its budget, so it can gate regressions.
+// Don't define __ANDROID__ !
+
+#include "jni_mock.hpp"
+#define __ANDROID__
+#define FLOUI_IMPL
+#include "../floui.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+#include <optional>
+#include <thread>
+
+using namespace floui;
+
+static bool over_budget = false;
+
+static size_t allocations = 0;
+
+// GCC pairs the malloc below with the free in operator delete once both are inlined
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+
+void *operator new(size_t n) {
+    allocations++;
+    if (auto p = std::malloc(n))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+
+void operator delete(void *p, size_t) noexcept { std::free(p); }
+
+/// Runs f N times, reports per iteration JNI crossings and time, then checks the total against
+/// budget, which is the number of JNI crossings one iteration is allowed
+template <typename F>
+static void measure(const char *name, size_t per, double budget, F &&f) {
+    constexpr int N = 1000;
+    jni_mock::reset();
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < N; i++)
+        f();
+    auto end = std::chrono::steady_clock::now();
+    auto ns = std::chrono::duration<double, std::nano>(end - start).count() / N;
+    auto &n = jni_mock::counters;
+    auto total = (double)n.total() / N;
+    auto ok = total <= budget;
+    over_budget |= !ok;
+    printf("%-14s %5zu %8.2f %8.2f %8.2f %8.2f %8.2f %10.1f %8.2f %s\n", name, per,
+           (double)n.lookups() / N, (double)n.calls() / N, (double)n.new_string_utf / N,
+           (double)n.refs() / N, total, ns, budget, ok ? "" : "OVER BUDGET");
+}
+
+static int val = 0;
+
+static MainView counter(const FlouiViewController &controller) {
+    return MainView(controller, {
+                                    Button("Increment")
+                                        .foreground(Color::Blue)
+                                        .action([=](Widget &) {
+                                            val++;
+                                            Widget::from_id<Text>("val").text(std::to_string(val));
+                                        }),
+                                    Text("0")
+                                        .center()
+                                        .bold()
+                                        .fontsize(20)
+                                        .foreground(Color::Black)
+                                        .id("val"),
+                                    Button("Decrement")
+                                        .foreground(Color::Red)
+                                        .action([=](Widget &) {
+                                            val--;
+                                            Widget::from_id<Text>("val").text(std::to_string(val));
+                                        }),
+                                });
+}
+
+static MainView settings(const FlouiViewController &controller) {
+    return MainView(controller, {
+                                    Text("Settings").bold().fontsize(24),
+                                    HStack({Text("Wifi"), Toggle("").value(true)}),
+                                    HStack({Text("Bluetooth"), Toggle("")}),
+                                    HStack({Text("Notifications"), Check("")}),
+                                    HStack({Text("Volume"), Slider().value(0.5)}),
+                                    HStack({Text("Name"), TextField().text("floui")}),
+                                    ImageView("logo.png").size(100, 100),
+                                });
+}
+
+static MainView list(const FlouiViewController &controller, int rows) {
+    auto stack = VStack({});
+    for (int i = 0; i < rows; i++) {
+        stack.add(HStack({Text(std::to_string(i)).foreground(Color::Gray), Spacer(),
+                          Button("Open").action([](Widget &) {})}));
+    }
+    return MainView(controller, {ScrollView(stack)});
+}
+
+/// Delivers events through f, reporting JNI crossings and time per event
+template <typename F>
+static void dispatch(const char *name, double budget, F &&f) {
+    constexpr int N = 1000000;
+    jni_mock::reset();
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < N; i++)
+        f();
+    auto end = std::chrono::steady_clock::now();
+    auto ns = std::chrono::duration<double, std::nano>(end - start).count() / N;
+    auto total = (double)jni_mock::counters.total() / N;
+    auto ok = total <= budget;
+    over_budget |= !ok;
+    printf("%-22s %8.2f %10.2f %8.2f %s\n", name, total, ns, budget, ok ? "" : "OVER BUDGET");
+}
+
+/// Registers and releases callbacks like rebuilding a screen does, then checks that doing it
+/// again allocates nothing and that captures get destroyed
+static bool pooled_callbacks() {
+    int *p = &val;
+    long a = 1;
+    double b = 2;
+    auto shared = std::make_shared<int>(0);
+    auto build = [&] {
+        for (int i = 0; i < 1000; i++) {
+            FlouiViewController::add_callback([p, a, b](Widget &) { *p += a + (int)b; });
+            FlouiViewController::add_callback([shared](Widget &) { (*shared)++; });
+        }
+    };
+    auto mark = FlouiViewController::callback_mark();
+    build();
+    FlouiViewController::release_callbacks(mark);
+    allocations = 0;
+    build();
+    auto n = allocations;
+    auto captured = shared.use_count();
+    FlouiViewController::release_callbacks(mark);
+    printf("\n%-22s %8zu %12zu %12ld %12ld\n", "2000 callbacks", n,
+           FlouiViewController::callback_mark() - mark, captured, shared.use_count());
+    return n == 0 && captured == 1001 && shared.use_count() == 1;
+}
+
+static Node dashboard(int first, int rows, int changed) {
+    auto stack = node::VStack({});
+    for (int i = first; i < rows; i++) {
+        auto value = i == changed ? -i : i;
+        stack.add(node::HStack({node::Text("sensor " + std::to_string(i)).bold(),
+                                node::Text(std::to_string(value)).foreground(Color::Gray),
+                                node::Toggle("").value(value > 0).action([i](Widget &) {})})
+                      .key(static_cast<uint64_t>(i)));
+    }
+    return stack;
+}
+
+/// Renders a 100 row dashboard through a Tree, then renders it again unchanged, with one value
+/// changed, without its first row and with it prepended back, which moves no other row, and
+/// checks what each render did natively against expected
+static void render(Tree &tree, const char *name, Node root, TreeStats expected) {
+    jni_mock::reset();
+    auto before = tree.stats();
+    tree.render(std::move(root));
+    auto after = tree.stats();
+    TreeStats d{after.created - before.created, after.removed - before.removed,
+                after.moved - before.moved, after.updated - before.updated};
+    auto ok = d.created == expected.created && d.removed == expected.removed &&
+              d.moved == expected.moved && d.updated == expected.updated;
+    over_budget |= !ok;
+    printf("%-22s %8zu %8zu %8zu %8zu %8zu %s\n", name, d.created, d.removed, d.moved, d.updated,
+           jni_mock::counters.total(), ok ? "" : "UNEXPECTED");
+}
+
+/// Binds texts to two States, then sets one of them ten times within a single event and checks
+/// only its text was written, once
+static bool coalesced_bindings() {
+    State<int> a(0);
+    State<int> b(0);
+    auto text_a = Text(bind(a, to_string));
+    Text(bind(b, to_string));
+    auto writes = [&](auto f) {
+        jni_mock::reset();
+        f();
+        return jni_mock::counters.total();
+    };
+    auto one = writes([&] { text_a.text("1"); });
+    auto slot = FlouiViewController::add_callback([=](Widget &) {
+        for (int i = 0; i < 10; i++)
+            a.update([](int v) { return v + 1; });
+    });
+    auto event = writes([&] { FlouiViewController::handle_event(slot, nullptr); });
+    auto same = writes([&] { a.set(a.get()); });
+    printf("%-22s %8zu %8zu %8zu\n", "10 sets in a callback", one, event, same);
+    return event == one && same == 0;
+}
+
+/// Writes the same property ten times within an event, with and without batching
+static bool batched_writes() {
+    auto text = Text("");
+    auto slot = FlouiViewController::add_callback([=](Widget &) {
+        auto t = text;
+        for (int i = 0; i < 10; i++)
+            t.text(std::to_string(i)).background(Color::White);
+    });
+    auto event = [&] {
+        jni_mock::reset();
+        FlouiViewController::handle_event(slot, nullptr);
+        return jni_mock::counters.total();
+    };
+    auto direct = event();
+    FlouiViewController::batch(true);
+    auto batched = event();
+    FlouiViewController::batch(false);
+    printf("%-22s %8zu %8zu\n", "10 writes x 2 props", direct, batched);
+    return batched * 10 == direct;
+}
+
+/// Rewrites unchanged values with elision enabled, checking that only changes and writes after
+/// the native value may have changed reach JNI
+static bool elided_writes() {
+    FlouiViewController::elide(true);
+    auto text = Text("");
+    auto field = TextField();
+    auto rewrite = [&] {
+        jni_mock::reset();
+        for (int i = 0; i < 10; i++) {
+            text.text("same").background(Color::White).size(100, 40);
+            field.text("typed over");
+        }
+        return jni_mock::counters.total();
+    };
+    auto first = rewrite();
+    auto again = rewrite();
+    field.text();
+    auto after_read = rewrite();
+    auto applied = FlouiViewController::applied_writes();
+    auto elided = FlouiViewController::elided_writes();
+    FlouiViewController::elide(false);
+    printf("%-22s %8zu %8zu %8zu %8zu %8zu\n", "40 writes, 3 rounds", first, again, after_read, applied,
+           elided);
+    return again == 0 && after_read == 3 && applied == 5 && elided == 115;
+}
+
+/// Restyles 5k rows with chained setters and then with a shared Style, checking that a style is
+/// one JNI call per row and that the rows share its storage
+static bool restyle() {
+    constexpr size_t rows = 5000;
+    std::vector<Text> texts;
+    for (size_t i = 0; i < rows; i++)
+        texts.push_back(Text(std::to_string(i)));
+    auto pass = [&](auto &&f) {
+        jni_mock::reset();
+        for (auto &t : texts)
+            f(t);
+        return jni_mock::counters.total();
+    };
+    auto chained = pass([](Text &t) {
+        t.foreground(Color::Black).background(Color::White).fontsize(14).bold().center();
+    });
+    auto row =
+        Style().foreground(Color::Black).background(Color::White).fontsize(14).bold().center();
+    auto styled = pass([&](Text &t) { t.style(row); });
+    auto shared = std::all_of(texts.begin(), texts.end(), [&](const Text &t) {
+        return Style::of(t.inner()) == &row.intern();
+    });
+    printf("%-22s %8zu %8zu\n", "5k rows, 5 props", chained, styled);
+    return chained == 5 * rows && styled == rows && shared;
+}
+
+/// Inserts n children into a stack an add at a time, then with add_all, and reports the Java
+/// method invocations and the JNI crossings of each, checking that add_all invokes Java once
+static bool bulk_insert(const char *name, size_t n) {
+    std::vector<Spacer> children;
+    for (size_t i = 0; i < n; i++)
+        children.push_back(Spacer());
+    auto each = VStack();
+    jni_mock::reset();
+    for (auto &child : children)
+        each.add(child);
+    auto one_by_one = jni_mock::counters;
+    auto bulk = VStack();
+    jni_mock::reset();
+    bulk.add_all(children);
+    auto all = jni_mock::counters;
+    printf("%-22s %8zu %8zu %8zu %8zu\n", name, one_by_one.calls(), one_by_one.total(), all.calls(),
+           all.total());
+    return one_by_one.calls() == n && all.calls() == 1;
+}
+
+/// Scrolls a million row list a viewport at a time, as a platform without a recycling list
+/// would, checking that the number of row views stays flat and reporting the worst frame
+static bool scroll_list() {
+    constexpr int rows = 1000000;
+    constexpr int height = 600;
+    size_t views = 0;
+    auto list = ListView(
+        rows, [&](int) { return Widget((views++, jni_mock::new_handle())); },
+        [](Widget &, int) {});
+    RowRecycler recycler(list.list_id());
+    double worst = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int offset = 0; offset < recycler.content_height(); offset += height / 2) {
+        auto frame = std::chrono::steady_clock::now();
+        recycler.layout(
+            offset, height, [](Widget &, int) {}, [](Widget &) {});
+        worst = std::max(
+            worst,
+            std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - frame)
+                .count());
+    }
+    auto ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start)
+                  .count();
+    // 15 rows in view, 2 rows of overscan each side, and one row cut at each edge
+    auto max_views = size_t(height / 40 + 1 + 2 * 2);
+    printf("%-22s %8zu %8zu %8zu %10.1f %10.1f\n", "1M rows", views, recycler.bound(),
+           recycler.pooled(), worst / 1000, ms);
+    return views <= max_views && views == recycler.rows().size() + recycler.pooled();
+}
+
+/// A screen of 2000 rows in a ScrollView, built eagerly and lazily, then the lazy one scrolled
+/// from top to bottom and back under a budget
+static bool lazy_stack() {
+    constexpr int items = 2000;
+    constexpr int height = 48;
+    auto row = [](int i) { return HStack({Text(std::to_string(i)), Toggle("On")}); };
+    auto first_frame = [](const char *name, auto &&build) {
+        jni_mock::reset();
+        auto start = std::chrono::steady_clock::now();
+        auto widget = build();
+        auto us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() -
+                                                             start)
+                      .count();
+        printf("%-22s %8zu %10.1f\n", name, jni_mock::counters.total(), us);
+        jni_mock::return_from_native();
+        return std::pair{widget, jni_mock::counters.total()};
+    };
+    auto [eager, eager_calls] = first_frame("eager", [&] {
+        auto stack = VStack({});
+        for (int i = 0; i < items; i++)
+            stack.add(row(i));
+        return ScrollView(stack);
+    });
+    auto stack = LazyVStack(items, row);
+    auto [lazy, lazy_calls] =
+        first_frame("lazy", [&] { return ScrollView(stack.estimate(height).budget(100)); });
+    // 1000px viewport, plus 2 children of overscan each side
+    auto visible = size_t(1000 / height + 1 + 2);
+    auto first = stack.made();
+    // The mock's View.getId() is derived from the view's handle
+    auto key = (int64_t)(reinterpret_cast<uintptr_t>(lazy.inner()) >> 4);
+    size_t most = 0;
+    for (int y = 0; y <= items * height; y += 300) {
+        LazyStack::scrolled(key, 0, y, 400, 1000);
+        most = std::max(most, stack.live());
+    }
+    for (int y = items * height; y >= 0; y -= 300) {
+        LazyStack::scrolled(key, 0, y, 400, 1000);
+        most = std::max(most, stack.live());
+    }
+    jni_mock::return_from_native();
+    printf("\n%-22s %8s %8s %8s %8s\n", "lazy scroll", "at first", "made", "evicted", "most");
+    printf("%-22s %8zu %8zu %8zu %8zu\n", "2000 rows, budget 100", first, stack.made(), stack.evicted(),
+           most);
+    return first == visible && lazy_calls * 20 < eager_calls && most <= 100;
+}
+
+#ifdef FLOUI_STATS
+/// Builds the counter screen and runs a callback, then checks the entry point stats against the
+/// mock's count of JNI calls
+static bool entry_stats(const FlouiViewController &controller) {
+    stats().reset();
+    jni_mock::return_from_native();
+    jni_mock::reset();
+    auto native = Stats::native_calls;
+    counter(controller);
+    auto slot = FlouiViewController::add_callback(
+        [](Widget &) { Widget::from_id<Text>("val"_id).text("1"); });
+    FlouiViewController::handle_event(slot, nullptr);
+    stats().text(stdout);
+    auto &callback = stats().entry("callback");
+    auto ok = Stats::native_calls - native == jni_mock::counters.total() &&
+              stats().entry("Button::Button").calls == 2 &&
+              stats().entry("Text::fontsize").calls == 1 && callback.calls == 1 &&
+              callback.native_calls == stats().entry("Text::text").native_calls;
+    jni_mock::return_from_native();
+    return ok;
+}
+#endif
+
+/// Logs from many threads through the background thread, which has to attach to the VM, and checks
+/// every message crossed JNI once, as a single string
+static bool async_log() {
+    jni_mock::return_from_native();
+    jni_mock::reset();
+    constexpr int threads = 4, per = 100;
+    Log::async(true);
+    std::vector<std::thread> loggers;
+    for (int t = 0; t < threads; t++)
+        loggers.emplace_back([t] {
+            for (int i = 0; i < per; i++)
+                floui_log("floui: message %d from %d", i, t);
+        });
+    for (auto &t : loggers)
+        t.join();
+    Log::flush();
+    Log::async(false);
+    auto &n = jni_mock::counters;
+    printf("%-22s %8zu %8zu %8zu %8zu\n", "400 messages", n.new_string_utf, n.call_static_method,
+           n.attach, Log::dropped());
+    jni_mock::return_from_native();
+    return n.new_string_utf == threads * per && n.call_static_method == threads * per &&
+           n.attach == 2;
+}
+
+/// Posts writes from a worker thread, which attaches to wake the UI thread once, then drains them in
+/// one batch, so only the last write crosses JNI
+static bool posted_writes() {
+    auto text = Text("0");
+    jni_mock::return_from_native();
+    jni_mock::reset();
+    std::thread([=] {
+        for (int i = 0; i < 1000; i++)
+            post([=] { Text(text.inner()).text(std::to_string(i)); });
+    }).join();
+    auto woken = jni_mock::counters;
+    FlouiViewController::batch(true);
+    auto ran = FlouiViewController::drain();
+    FlouiViewController::batch(false);
+    auto drained = jni_mock::counters.total() - woken.total();
+    printf("%-22s %8zu %8zu %8zu %8zu\n", "1000 posts", ran, woken.total(), woken.attach, drained);
+    jni_mock::return_from_native();
+    return ran == 1000 && woken.total() == 1 && woken.attach == 2 && drained <= 3;
+}
+
+/// Builds rows of widgets within a single native call, then checks how many local references
+/// were alive at once against budget
+static void local_refs(const char *name, int rows, size_t budget, bool bulk) {
+    jni_mock::return_from_native();
+    jni_mock::reset();
+    {
+        std::optional<BulkScope> scope;
+        if (bulk)
+            scope.emplace();
+        auto stack = VStack({});
+        for (int i = 0; i < rows; i++) {
+            stack.add(HStack({Text(std::to_string(i)), Button("Open").size(100, 40)}));
+        }
+    }
+    auto &n = jni_mock::counters;
+    auto ok = n.peak_locals <= budget;
+    over_budget |= !ok;
+    printf("%-22s %8d %12zu %12zu %8zu %s\n", name, rows * 4 + 1, n.peak_locals, n.total(),
+           budget, ok ? "" : "OVER BUDGET");
+    jni_mock::return_from_native();
+}
+
+int main() {
+    auto env = jni_mock::env();
+    FlouiViewController controller(env, jni_mock::new_handle(), jni_mock::new_handle());
+
+    // IDs are looked up by content, unknown ones are reported and give a null widget
+    counter(controller);
+    std::string name = "val";
+    if (!Widget::from_id<Text>(name.c_str()).inner() || Widget::from_id<Text>("nope"_id).inner()) {
+        fprintf(stderr, "widget id lookup failed\n");
+        return 1;
+    }
+
+    // Android lays out with its native stacks, so layout setters don't keep nodes
+    VStack({Spacer().grow(1).shrink(0).padding(4)}).align(Layout::Align::Center);
+    if (Layout::size() != 0) {
+        fprintf(stderr, "layout nodes recorded on Android\n");
+        return 1;
+    }
+
+    printf("%-14s %5s %8s %8s %8s %8s %8s %10s %8s\n", "per iteration", "nodes", "lookups",
+           "calls", "strings", "refs", "total", "ns", "budget");
+    measure("Button", 1, 14, [] {
+        Button("Increment").foreground(Color::Blue).action([](Widget &) {});
+    });
+    measure("Text", 1, 12, [] {
+        Text("0").center().bold().fontsize(20).foreground(Color::Black).background(Color::White);
+    });
+    measure("Toggle", 1, 9, [] { Toggle("Toggle").value(true); });
+    measure("Check", 1, 9, [] { Check("Check").value(true); });
+    measure("Slider", 1, 5, [] { Slider().value(0.5); });
+    // One more for MainActivity.watchText
+    measure("TextField", 1, 9, [] { TextField().text("Text").fontsize(14); });
+    measure("Spacer", 1, 7, [] { Spacer().size(10, 10); });
+    measure("ImageView", 1, 6, [] { ImageView("image.png"); });
+    measure("WebView", 1, 7, [] { WebView().load_url("https://example.com"); });
+    measure("ScrollView", 2, 9, [] { ScrollView{Spacer()}; });
+    measure("ListView 1M", 1, 10, [] {
+        ListView(
+            1000000, [](int) { return Text(""); }, [](Widget &, int) {});
+    });
+    measure("VStack", 4, 27, [] { VStack({Text("1"), Text("2")}).add(Spacer()); });
+    measure("HStack", 4, 27, [] { HStack({Text("1"), Text("2")}).add(Spacer()); });
+    auto spaced = VStack({Text("1"), Text("2")});
+    measure("spacing", 0, 5, [&] { spaced.spacing(8); });
+    measure("counter tree", 4, 52, [&] { counter(controller); });
+    measure("settings tree", 18, 155, [&] { settings(controller); });
+    measure("list tree x100", 403, 3522, [&] { list(controller, 100); });
+
+    // Slots carried by the view skip the view id lookup, so dispatch never crosses JNI
+    int hits = 0;
+    auto button = Button("Tap").action([&](Widget &) { hits++; });
+    auto slot = FlouiViewController::add_callback([&](Widget &) { hits++; });
+    printf("\n%-22s %8s %10s %8s\n", "per event", "total", "ns", "budget");
+    dispatch("handle_events(view)", 1,
+             [&] { FlouiViewController::handle_events(button.inner()); });
+    dispatch("handle_event(slot)", 0, [&] { FlouiViewController::handle_event(slot, nullptr); });
+    if (hits != 2000000) {
+        fprintf(stderr, "events were not dispatched\n");
+        return 1;
+    }
+
+    printf("\n%-22s %8s %8s %8s %8s %8s\n", "tree render", "created", "removed", "moved",
+           "updated", "total");
+    {
+        auto main_view = MainView(controller, {});
+        Tree tree(main_view);
+        render(tree, "first", dashboard(0, 100, -1), {401, 0, 0, 0});
+        render(tree, "unchanged", dashboard(0, 100, -1), {0, 0, 0, 0});
+        render(tree, "one value", dashboard(0, 100, 50), {0, 0, 0, 2});
+        render(tree, "first row dropped", dashboard(1, 100, 50), {0, 1, 0, 0});
+        render(tree, "row prepended", dashboard(0, 100, 50), {4, 0, 0, 0});
+    }
+
+    printf("\n%-22s %8s %8s %8s\n", "state bindings", "1 write", "event", "same");
+    if (!coalesced_bindings()) {
+        fprintf(stderr, "state changes were not coalesced\n");
+        return 1;
+    }
+
+    printf("\n%-22s %8s %8s\n", "per event", "direct", "batched");
+    if (!batched_writes()) {
+        fprintf(stderr, "batched writes were not coalesced\n");
+        return 1;
+    }
+
+    printf("\n%-22s %8s %8s %8s %8s %8s\n", "write elision", "first", "again", "read",
+           "applied", "elided");
+    if (!elided_writes()) {
+        fprintf(stderr, "unchanged writes were not elided\n");
+        return 1;
+    }
+
+    printf("\n%-22s %8s %8s\n", "restyle", "chained", "style");
+    if (!restyle()) {
+        fprintf(stderr, "styles were not applied in one call per row\n");
+        return 1;
+    }
+
+    printf("\n%-22s %8s %8s %8s %8s\n", "insert children", "calls", "total", "bulk", "total");
+    if (!bulk_insert("1k children", 1000) || !bulk_insert("10k children", 10000)) {
+        fprintf(stderr, "bulk insertion took more than one call\n");
+        return 1;
+    }
+
+    printf("\n%-22s %8s %8s %8s %10s %10s\n", "list scroll", "views", "bound", "pooled",
+           "worst us", "total ms");
+    if (!scroll_list()) {
+        fprintf(stderr, "list views were not recycled\n");
+        return 1;
+    }
+
+    printf("\n%-22s %8s %10s\n", "2000 rows first frame", "total", "us");
+    if (!lazy_stack()) {
+        fprintf(stderr, "lazy stack made children out of view\n");
+        return 1;
+    }
+
+    printf("\n%-22s %8s %12s %12s %12s", "rebuild", "allocs", "slots left", "captured",
+           "released");
+    if (!pooled_callbacks()) {
+        fprintf(stderr, "pooled callbacks allocated or leaked\n");
+        return 1;
+    }
+
+    printf("\n%-22s %8s %8s %8s %8s\n", "async log", "strings", "calls", "attach", "dropped");
+    if (!async_log()) {
+        fprintf(stderr, "async log messages were lost or the log thread was not attached\n");
+        return 1;
+    }
+
+    printf("\n%-22s %8s %8s %8s %8s\n", "posted writes", "ran", "wake", "attach", "drain");
+    if (!posted_writes()) {
+        fprintf(stderr, "posted writes were not batched\n");
+        return 1;
+    }
+
+    printf("\n%-22s %8s %12s %12s %8s\n", "single native call", "nodes", "peak locals",
+           "total", "budget");
+    local_refs("10k rows", 10000, 30001, false);
+    local_refs("10k rows, BulkScope", 10000, 260, true);
+
+#ifdef FLOUI_STATS
+    printf("\n");
+    if (!entry_stats(controller)) {
+        fprintf(stderr, "entry point stats don't match the JNI calls made\n");
+        return 1;
+    }
+#endif
+
+    if (over_budget) {
+        fprintf(stderr, "JNI call budget exceeded\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,385 @@
+// A counting stand-in for ART's JNIEnv and JavaVM, so that the Android backend can run on desktop.
+// Objects are opaque handles which are never dereferenced, methods do nothing and every call
+// into the function tables is recorded.
+
+#pragma once
+
+#include <jni.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+namespace jni_mock {
+
+/// Number of calls into the JNI function tables, by kind
+struct Counters {
+    size_t find_class = 0;
+    size_t get_object_class = 0;
+    size_t get_method_id = 0;
+    size_t get_static_method_id = 0;
+    size_t get_field_id = 0;
+    size_t call_method = 0;
+    size_t call_static_method = 0;
+    size_t field_access = 0;
+    size_t new_object = 0;
+    size_t new_string_utf = 0;
+    size_t array_access = 0;
+    size_t string_chars = 0;
+    size_t new_global_ref = 0;
+    size_t new_weak_global_ref = 0;
+    size_t new_local_ref = 0;
+    size_t delete_ref = 0;
+    size_t local_frame = 0;
+    size_t exception = 0;
+    size_t get_env = 0;
+    size_t attach = 0;
+    /// Local references currently alive, and the most that were alive at once
+    size_t live_locals = 0;
+    size_t peak_locals = 0;
+    /// Global references currently alive, weak ones included
+    size_t live_globals = 0;
+
+    /// Reflective lookups, FindClass, GetObjectClass and Get*ID
+    size_t lookups() const {
+        return find_class + get_object_class + get_method_id + get_static_method_id +
+               get_field_id;
+    }
+    /// Java method invocations
+    size_t calls() const { return call_method + call_static_method + field_access; }
+    /// Reference creation and deletion
+    size_t refs() const {
+        return new_global_ref + new_weak_global_ref + new_local_ref + delete_ref + local_frame;
+    }
+    /// Every crossing into JNIEnv, JavaVM calls excluded
+    size_t total() const {
+        return lookups() + calls() + refs() + new_object + new_string_utf + array_access +
+               string_chars + exception;
+    }
+
+    void print(FILE *f = stdout) const {
+        fprintf(f,
+                "FindClass: %zu, GetObjectClass: %zu, GetMethodID: %zu, GetStaticMethodID: %zu, "
+                "GetFieldID: %zu\n"
+                "Call*Method: %zu, CallStatic*Method: %zu, Get/Set*Field: %zu, NewObject: %zu, "
+                "NewStringUTF: %zu, SetObjectArrayElement: %zu\n"
+                "NewGlobalRef: %zu, NewWeakGlobalRef: %zu, NewLocalRef: %zu, Delete*Ref: %zu, "
+                "Push/PopLocalFrame: %zu, GetEnv: %zu\n"
+                "live locals: %zu, peak locals: %zu, live globals: %zu\n",
+                find_class, get_object_class, get_method_id, get_static_method_id, get_field_id,
+                call_method, call_static_method, field_access, new_object, new_string_utf,
+                array_access, new_global_ref, new_weak_global_ref, new_local_ref, delete_ref,
+                local_frame, get_env, live_locals, peak_locals, live_globals);
+    }
+};
+
+inline Counters counters{};
+
+/// Number of local references created in each pushed frame, the first one is the native method's
+inline std::vector<size_t> frames{0};
+
+inline jobject new_handle() {
+    static uintptr_t next = 0;
+    next += 16;
+    return reinterpret_cast<jobject>(next);
+}
+
+template <typename T = jobject>
+inline T handle() {
+    return reinterpret_cast<T>(new_handle());
+}
+
+/// Creates a handle owned by the current local frame
+template <typename T = jobject>
+inline T local() {
+    frames.back()++;
+    counters.live_locals++;
+    if (counters.live_locals > counters.peak_locals)
+        counters.peak_locals = counters.live_locals;
+    return handle<T>();
+}
+
+inline jclass JNICALL FindClass(JNIEnv *, const char *) {
+    counters.find_class++;
+    return local<jclass>();
+}
+
+inline jclass JNICALL GetObjectClass(JNIEnv *, jobject) {
+    counters.get_object_class++;
+    return local<jclass>();
+}
+
+inline jmethodID JNICALL GetMethodID(JNIEnv *, jclass, const char *, const char *) {
+    counters.get_method_id++;
+    return handle<jmethodID>();
+}
+
+inline jmethodID JNICALL GetStaticMethodID(JNIEnv *, jclass, const char *, const char *) {
+    counters.get_static_method_id++;
+    return handle<jmethodID>();
+}
+
+inline jfieldID JNICALL GetFieldID(JNIEnv *, jclass, const char *, const char *) {
+    counters.get_field_id++;
+    return handle<jfieldID>();
+}
+
+inline jobject JNICALL NewObjectV(JNIEnv *, jclass, jmethodID, va_list) {
+    counters.new_object++;
+    return local();
+}
+
+inline jobject JNICALL CallObjectMethodV(JNIEnv *, jobject, jmethodID, va_list) {
+    counters.call_method++;
+    return local();
+}
+
+inline jboolean JNICALL CallBooleanMethodV(JNIEnv *, jobject, jmethodID, va_list) {
+    counters.call_method++;
+    return JNI_FALSE;
+}
+
+/// Returns a value derived from the receiver, so View.getId() is stable per view
+inline jint JNICALL CallIntMethodV(JNIEnv *, jobject obj, jmethodID, va_list) {
+    counters.call_method++;
+    return (jint)(reinterpret_cast<uintptr_t>(obj) >> 4);
+}
+
+inline jfloat JNICALL CallFloatMethodV(JNIEnv *, jobject, jmethodID, va_list) {
+    counters.call_method++;
+    return 0;
+}
+
+inline void JNICALL CallVoidMethodV(JNIEnv *, jobject, jmethodID, va_list) {
+    counters.call_method++;
+}
+
+inline jobject JNICALL CallStaticObjectMethodV(JNIEnv *, jclass, jmethodID, va_list) {
+    counters.call_static_method++;
+    return local();
+}
+
+/// Counts up, like View.generateViewId()
+inline jint JNICALL CallStaticIntMethodV(JNIEnv *, jclass, jmethodID, va_list) {
+    static jint id = 0;
+    counters.call_static_method++;
+    return ++id;
+}
+
+inline void JNICALL CallStaticVoidMethodV(JNIEnv *, jclass, jmethodID, va_list) {
+    counters.call_static_method++;
+}
+
+inline jint JNICALL GetIntField(JNIEnv *, jobject, jfieldID) {
+    counters.field_access++;
+    return 0;
+}
+
+inline void JNICALL SetIntField(JNIEnv *, jobject, jfieldID, jint) { counters.field_access++; }
+
+inline jstring JNICALL NewStringUTF(JNIEnv *, const char *) {
+    counters.new_string_utf++;
+    return local<jstring>();
+}
+
+inline const char *JNICALL GetStringUTFChars(JNIEnv *, jstring, jboolean *is_copy) {
+    counters.string_chars++;
+    if (is_copy)
+        *is_copy = JNI_FALSE;
+    return "";
+}
+
+inline void JNICALL ReleaseStringUTFChars(JNIEnv *, jstring, const char *) {
+    counters.string_chars++;
+}
+
+inline jobject JNICALL NewGlobalRef(JNIEnv *, jobject obj) {
+    counters.new_global_ref++;
+    counters.live_globals++;
+    return obj;
+}
+
+inline jweak JNICALL NewWeakGlobalRef(JNIEnv *, jobject obj) {
+    counters.new_weak_global_ref++;
+    counters.live_globals++;
+    return obj;
+}
+
+inline jobject JNICALL NewLocalRef(JNIEnv *, jobject) {
+    counters.new_local_ref++;
+    return local();
+}
+
+inline void JNICALL DeleteLocalRef(JNIEnv *, jobject) {
+    counters.delete_ref++;
+    if (frames.back())
+        frames.back()--;
+    if (counters.live_locals)
+        counters.live_locals--;
+}
+
+inline void JNICALL DeleteGlobalRef(JNIEnv *, jobject) {
+    counters.delete_ref++;
+    if (counters.live_globals)
+        counters.live_globals--;
+}
+
+inline jint JNICALL PushLocalFrame(JNIEnv *, jint) {
+    counters.local_frame++;
+    frames.push_back(0);
+    return JNI_OK;
+}
+
+inline jobject JNICALL PopLocalFrame(JNIEnv *, jobject) {
+    counters.local_frame++;
+    counters.live_locals -= frames.back();
+    if (frames.size() > 1)
+        frames.pop_back();
+    else
+        frames.back() = 0;
+    return nullptr;
+}
+
+inline jint JNICALL EnsureLocalCapacity(JNIEnv *, jint) {
+    counters.local_frame++;
+    return JNI_OK;
+}
+
+inline jboolean JNICALL IsSameObject(JNIEnv *, jobject a, jobject b) {
+    counters.call_method++;
+    return a == b;
+}
+
+inline jobjectArray JNICALL NewObjectArray(JNIEnv *, jsize, jclass, jobject) {
+    counters.new_object++;
+    return local<jobjectArray>();
+}
+
+inline void JNICALL SetObjectArrayElement(JNIEnv *, jobjectArray, jsize, jobject) {
+    counters.array_access++;
+}
+
+inline jboolean JNICALL IsInstanceOf(JNIEnv *, jobject, jclass) {
+    counters.call_method++;
+    return JNI_TRUE;
+}
+
+inline jboolean JNICALL ExceptionCheck(JNIEnv *) {
+    counters.exception++;
+    return JNI_FALSE;
+}
+
+inline void JNICALL ExceptionClear(JNIEnv *) { counters.exception++; }
+
+inline jint JNICALL GetJavaVM(JNIEnv *, JavaVM **vm);
+
+inline JNINativeInterface_ make_env_table() {
+    JNINativeInterface_ t{};
+    t.FindClass = FindClass;
+    t.GetObjectClass = GetObjectClass;
+    t.GetMethodID = GetMethodID;
+    t.GetStaticMethodID = GetStaticMethodID;
+    t.GetFieldID = GetFieldID;
+    t.NewObjectV = NewObjectV;
+    t.CallObjectMethodV = CallObjectMethodV;
+    t.CallBooleanMethodV = CallBooleanMethodV;
+    t.CallIntMethodV = CallIntMethodV;
+    t.CallFloatMethodV = CallFloatMethodV;
+    t.CallVoidMethodV = CallVoidMethodV;
+    t.CallStaticObjectMethodV = CallStaticObjectMethodV;
+    t.CallStaticIntMethodV = CallStaticIntMethodV;
+    t.CallStaticVoidMethodV = CallStaticVoidMethodV;
+    t.GetIntField = GetIntField;
+    t.SetIntField = SetIntField;
+    t.NewStringUTF = NewStringUTF;
+    t.GetStringUTFChars = GetStringUTFChars;
+    t.ReleaseStringUTFChars = ReleaseStringUTFChars;
+    t.NewGlobalRef = NewGlobalRef;
+    t.NewWeakGlobalRef = NewWeakGlobalRef;
+    t.NewLocalRef = NewLocalRef;
+    t.DeleteLocalRef = DeleteLocalRef;
+    t.DeleteGlobalRef = DeleteGlobalRef;
+    t.DeleteWeakGlobalRef = DeleteGlobalRef;
+    t.PushLocalFrame = PushLocalFrame;
+    t.PopLocalFrame = PopLocalFrame;
+    t.EnsureLocalCapacity = EnsureLocalCapacity;
+    t.IsSameObject = IsSameObject;
+    t.IsInstanceOf = IsInstanceOf;
+    t.NewObjectArray = NewObjectArray;
+    t.SetObjectArrayElement = SetObjectArrayElement;
+    t.ExceptionCheck = ExceptionCheck;
+    t.ExceptionClear = ExceptionClear;
+    t.GetJavaVM = GetJavaVM;
+    return t;
+}
+
+inline JNINativeInterface_ env_table = make_env_table();
+inline JNIEnv env_instance{&env_table};
+
+/// The thread Java calls in from, any other has to attach before GetEnv succeeds
+inline const std::thread::id java_thread = std::this_thread::get_id();
+inline thread_local bool attached = false;
+
+inline jint JNICALL GetEnv(JavaVM *, void **penv, jint) {
+    counters.get_env++;
+    if (!attached && std::this_thread::get_id() != java_thread) {
+        *penv = nullptr;
+        return JNI_EDETACHED;
+    }
+    *penv = &env_instance;
+    return JNI_OK;
+}
+
+inline jint JNICALL AttachCurrentThread(JavaVM *, void **penv, void *) {
+    counters.attach++;
+    attached = true;
+    *penv = &env_instance;
+    return JNI_OK;
+}
+
+inline jint JNICALL DetachCurrentThread(JavaVM *) {
+    counters.attach++;
+    attached = false;
+    return JNI_OK;
+}
+
+inline JNIInvokeInterface_ make_vm_table() {
+    JNIInvokeInterface_ t{};
+    t.GetEnv = GetEnv;
+    t.AttachCurrentThread = AttachCurrentThread;
+    t.AttachCurrentThreadAsDaemon = AttachCurrentThread;
+    t.DetachCurrentThread = DetachCurrentThread;
+    return t;
+}
+
+inline JNIInvokeInterface_ vm_table = make_vm_table();
+inline JavaVM vm_instance{&vm_table};
+
+inline jint JNICALL GetJavaVM(JNIEnv *, JavaVM **vm) {
+    *vm = &vm_instance;
+    return JNI_OK;
+}
+
+/// The mock JNIEnv passed to native entry points
+inline JNIEnv *env() { return &env_instance; }
+
+/// The mock JavaVM, as returned by JNIEnv::GetJavaVM
+inline JavaVM *vm() { return &vm_instance; }
+
+/// Resets the call counters, references alive are kept
+inline void reset() {
+    auto live_locals = counters.live_locals;
+    auto live_globals = counters.live_globals;
+    counters = Counters{};
+    counters.live_locals = counters.peak_locals = live_locals;
+    counters.live_globals = live_globals;
+}
+
+/// Drops every local reference, like returning from a native method does
+inline void return_from_native() {
+    counters.live_locals = 0;
+    frames.assign(1, 0);
+}
+
+} // namespace jni_mock
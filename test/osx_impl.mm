@@ -40,8 +40,8 @@ NSColor *col2nscol(uint32_t col) {
         v.layer.backgroundColor = col2nscol(col).CGColor;                                          \
         return *this;                                                                              \
     }                                                                                              \
-    widget &widget::id(const char *val) {                                                          \
-        widget_map[val] = view;                                                                    \
+    widget &widget::id(Id val) {                                                                   \
+        widget_map.insert(val, view);                                                              \
         return *this;                                                                              \
     }                                                                                              \
     widget &widget::size(int w, int h) {                                                           \
@@ -67,10 +67,11 @@ Button::Button(const std::string &label) : Widget((void *)CFBridgingRetain([NSBu
 
 Button &Button::filled() { return *this; }
 
-Button &Button::action(std::function<void(Widget &)> &&f) {
+Button &Button::action(Action &&f) {
     auto v = (__bridge NSButton *)view;
     auto &callbacks = FlouiViewControllerImpl::callbacks;
-    callbacks.push_back([[Callback alloc] initWithTarget:view Cb:f]);
+    auto slot = FlouiViewController::add_callback(std::move(f));
+    callbacks.push_back([[Callback alloc] initWithTarget:view Slot:slot]);
     [v setTarget:callbacks.back()];
     [v setAction:@selector(invoke)];
     return *this;